@@ -57,4 +57,17 @@ struct uQuadChannelCS {
     const std::uint16_t* getChannelDataConst(Channel channel) const;
     const std::uint16_t* getChannelDataConst(std::size_t chIdx) const;
     const std::size_t getChannelSizeConst(Channel channel) const;
-};
\ No newline at end of file
+};
+
+/**
+ * AGOR state of all 4 channels at the start of row of quadruplets <row>, bitOffset is position of the row
+ * in the payload. Stored in checkpoint index of compressed image (C_HEADER_FLAG_CHECKPOINT_INDEX).
+ * First quadruplet of a row is predicted from YCCC_up, so YCCC_prev is not part of the state.
+*/
+struct AgorCheckpoint_s {
+    std::uint64_t bitOffset = 0;
+    std::uint32_t A[4]      = {0, 0, 0, 0};
+    std::uint32_t N         = 0;
+    std::uint32_t row       = 0;
+    std::int16_t YCCC_up[4] = {0, 0, 0, 0};
+};
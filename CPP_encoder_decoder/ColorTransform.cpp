@@ -0,0 +1,614 @@
+#include "ColorTransform.hpp"
+
+// define COLOR_TRANSFORM_SCALAR to disable SIMD kernels
+#if !defined(COLOR_TRANSFORM_SCALAR) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64))
+#    define COLOR_TRANSFORM_X86
+#    include <immintrin.h>
+#    if defined(__GNUC__)
+#        define TARGET_AVX2 __attribute__((target("avx2")))
+#    else
+#        define TARGET_AVX2
+#    endif
+#endif
+
+/**
+ * Same math as Helpers::transformColorGB.
+*/
+static void bayerGBToYCCC_row_scalar(
+   const std::uint16_t* rowTop,
+   const std::uint16_t* rowBottom,
+   std::int16_t* YCCC,
+   std::size_t first,
+   std::size_t width,
+   std::size_t lossyBits)
+{
+    for(std::size_t i = first; i < width; i++) {
+        int gb = rowTop[2 * i];
+        int b  = rowTop[2 * i + 1];
+        int r  = rowBottom[2 * i];
+        int gr = rowBottom[2 * i + 1];
+
+        YCCC[4 * i + 0] = (std::int16_t)((gr + r + b + gb) >> lossyBits);
+        YCCC[4 * i + 1] = (std::int16_t)((gr - gb) >> lossyBits);
+        YCCC[4 * i + 2] = (std::int16_t)((gr - r) >> lossyBits);
+        YCCC[4 * i + 3] = (std::int16_t)((r - b) >> lossyBits);
+    }
+}
+
+/**
+ * Same math as DecoderBase::YCCC_to_BayerGB. Channel i of quad n is at @param ch[i][n * stride],
+ * stride is 4 for interleaved YCCC and 1 for planes.
+*/
+template<typename T>
+static void YCCC_to_BayerGB_row_scalar(
+   const std::int16_t* const ch[4],
+   std::size_t stride,
+   T* rowTop,
+   T* rowBottom,
+   std::size_t first,
+   std::size_t width,
+   std::size_t lossyBits)
+{
+    for(std::size_t i = first; i < width; i++) {
+        std::int16_t y  = ch[0][stride * i];
+        std::int16_t cd = ch[1][stride * i];
+        std::int16_t cm = ch[2][stride * i];
+        std::int16_t co = ch[3][stride * i];
+
+        // clang-format off
+        rowBottom[2 * i + 1] = (T)((std::int16_t)(2 * y +  2 * cd +  4 * cm +  2 * co) >> 3) << lossyBits;   // gr
+        rowBottom[2 * i]     = (T)((std::int16_t)(2 * y +  2 * cd + -4 * cm +  2 * co) >> 3) << lossyBits;   // r
+        rowTop[2 * i + 1]    = (T)((std::int16_t)(2 * y +  2 * cd + -4 * cm + -6 * co) >> 3) << lossyBits;   // b
+        rowTop[2 * i]        = (T)((std::int16_t)(2 * y + -6 * cd +  4 * cm +  2 * co) >> 3) << lossyBits;   // gb
+        // clang-format on
+    }
+}
+
+static void inclusivePrefixSum_row_scalar(std::int16_t* data, std::size_t first, std::size_t length)
+{
+    for(std::size_t i = (first == 0 ? 1 : first); i < length; i++) {
+        data[i] = data[i - 1] + data[i];
+    }
+}
+
+#ifdef COLOR_TRANSFORM_X86
+
+/**
+ * 4 quads per vector, one quad in each 32 bit element. Computed in 32 bits and truncated to 16 bits,
+ * same as the scalar code.
+*/
+static void bayerGBToYCCC_row_sse2(
+   const std::uint16_t* rowTop,
+   const std::uint16_t* rowBottom,
+   std::int16_t* YCCC,
+   std::size_t width,
+   std::size_t lossyBits)
+{
+    const __m128i mask  = _mm_set1_epi32(0xFFFF);
+    const __m128i shift = _mm_cvtsi32_si128((int)lossyBits);
+
+    std::size_t i = 0;
+    for(; i + 4 <= width; i += 4) {
+        __m128i t = _mm_loadu_si128((const __m128i*)(rowTop + 2 * i));
+        __m128i u = _mm_loadu_si128((const __m128i*)(rowBottom + 2 * i));
+
+        __m128i gb = _mm_and_si128(t, mask);
+        __m128i b  = _mm_srli_epi32(t, 16);
+        __m128i r  = _mm_and_si128(u, mask);
+        __m128i gr = _mm_srli_epi32(u, 16);
+
+        __m128i y  = _mm_sra_epi32(_mm_add_epi32(_mm_add_epi32(gb, b), _mm_add_epi32(r, gr)), shift);
+        __m128i cd = _mm_sra_epi32(_mm_sub_epi32(gr, gb), shift);
+        __m128i cm = _mm_sra_epi32(_mm_sub_epi32(gr, r), shift);
+        __m128i co = _mm_sra_epi32(_mm_sub_epi32(r, b), shift);
+
+        __m128i ycd  = _mm_or_si128(_mm_and_si128(y, mask), _mm_slli_epi32(cd, 16));
+        __m128i cmco = _mm_or_si128(_mm_and_si128(cm, mask), _mm_slli_epi32(co, 16));
+
+        _mm_storeu_si128((__m128i*)(YCCC + 4 * i), _mm_unpacklo_epi32(ycd, cmco));
+        _mm_storeu_si128((__m128i*)(YCCC + 4 * i + 8), _mm_unpackhi_epi32(ycd, cmco));
+    }
+    bayerGBToYCCC_row_scalar(rowTop, rowBottom, YCCC, i, width, lossyBits);
+}
+
+/**
+ * 16 quads per iteration, two vectors of 8 quads.
+*/
+TARGET_AVX2 static void bayerGBToYCCC_row_avx2(
+   const std::uint16_t* rowTop,
+   const std::uint16_t* rowBottom,
+   std::int16_t* YCCC,
+   std::size_t width,
+   std::size_t lossyBits)
+{
+    const __m256i mask  = _mm256_set1_epi32(0xFFFF);
+    const __m128i shift = _mm_cvtsi32_si128((int)lossyBits);
+
+    std::size_t i = 0;
+    for(; i + 16 <= width; i += 16) {
+        for(std::size_t half = 0; half < 16; half += 8) {
+            __m256i t = _mm256_loadu_si256((const __m256i*)(rowTop + 2 * (i + half)));
+            __m256i u = _mm256_loadu_si256((const __m256i*)(rowBottom + 2 * (i + half)));
+
+            __m256i gb = _mm256_and_si256(t, mask);
+            __m256i b  = _mm256_srli_epi32(t, 16);
+            __m256i r  = _mm256_and_si256(u, mask);
+            __m256i gr = _mm256_srli_epi32(u, 16);
+
+            __m256i y  = _mm256_sra_epi32(_mm256_add_epi32(_mm256_add_epi32(gb, b), _mm256_add_epi32(r, gr)), shift);
+            __m256i cd = _mm256_sra_epi32(_mm256_sub_epi32(gr, gb), shift);
+            __m256i cm = _mm256_sra_epi32(_mm256_sub_epi32(gr, r), shift);
+            __m256i co = _mm256_sra_epi32(_mm256_sub_epi32(r, b), shift);
+
+            __m256i ycd  = _mm256_or_si256(_mm256_and_si256(y, mask), _mm256_slli_epi32(cd, 16));
+            __m256i cmco = _mm256_or_si256(_mm256_and_si256(cm, mask), _mm256_slli_epi32(co, 16));
+
+            // unpack works within 128 bit lanes: lo = q0 q1 | q4 q5, hi = q2 q3 | q6 q7
+            __m256i lo = _mm256_unpacklo_epi32(ycd, cmco);
+            __m256i hi = _mm256_unpackhi_epi32(ycd, cmco);
+            _mm256_storeu_si256((__m256i*)(YCCC + 4 * (i + half)), _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256((__m256i*)(YCCC + 4 * (i + half) + 16), _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+    }
+    bayerGBToYCCC_row_scalar(rowTop, rowBottom, YCCC, i, width, lossyBits);
+}
+
+/**
+ * Inverse transform of 8 quads held in Y, Cd, Cm, Co vectors and store to 2 * 8 pixels of each row.
+ * 16 bit arithmetic wraps the same as the int16 cast in scalar code.
+*/
+template<typename T>
+static inline void YCCC_to_BayerGB_sse2_8(
+   __m128i y,
+   __m128i cd,
+   __m128i cm,
+   __m128i co,
+   __m128i shift,
+   T* rowTop,
+   T* rowBottom)
+{
+    __m128i base = _mm_slli_epi16(_mm_add_epi16(_mm_add_epi16(y, cd), co), 1);   // 2y + 2cd + 2co
+    __m128i cm4  = _mm_slli_epi16(cm, 2);
+
+    __m128i gr = _mm_sll_epi16(_mm_srai_epi16(_mm_add_epi16(base, cm4), 3), shift);
+    __m128i r  = _mm_sll_epi16(_mm_srai_epi16(_mm_sub_epi16(base, cm4), 3), shift);
+    __m128i bl =
+       _mm_sll_epi16(_mm_srai_epi16(_mm_sub_epi16(_mm_sub_epi16(base, cm4), _mm_slli_epi16(co, 3)), 3), shift);
+    __m128i gb =
+       _mm_sll_epi16(_mm_srai_epi16(_mm_sub_epi16(_mm_add_epi16(base, cm4), _mm_slli_epi16(cd, 3)), 3), shift);
+
+    __m128i top_lo    = _mm_unpacklo_epi16(gb, bl);   // gb0 b0 .. gb3 b3
+    __m128i top_hi    = _mm_unpackhi_epi16(gb, bl);
+    __m128i bottom_lo = _mm_unpacklo_epi16(r, gr);
+    __m128i bottom_hi = _mm_unpackhi_epi16(r, gr);
+
+    if constexpr(sizeof(T) == 1) {
+        const __m128i mask8 = _mm_set1_epi16(0xFF);
+        _mm_storeu_si128(
+           (__m128i*)rowTop,
+           _mm_packus_epi16(_mm_and_si128(top_lo, mask8), _mm_and_si128(top_hi, mask8)));
+        _mm_storeu_si128(
+           (__m128i*)rowBottom,
+           _mm_packus_epi16(_mm_and_si128(bottom_lo, mask8), _mm_and_si128(bottom_hi, mask8)));
+    } else {
+        _mm_storeu_si128((__m128i*)rowTop, top_lo);
+        _mm_storeu_si128((__m128i*)(rowTop + 8), top_hi);
+        _mm_storeu_si128((__m128i*)rowBottom, bottom_lo);
+        _mm_storeu_si128((__m128i*)(rowBottom + 8), bottom_hi);
+    }
+}
+
+/**
+ * Separates 8 interleaved quads (a: q0 q1, b: q2 q3, c: q4 q5, d: q6 q7) to Y, Cd, Cm, Co vectors.
+*/
+static inline void deinterleaveYCCC_sse2(
+   __m128i a,
+   __m128i b,
+   __m128i c,
+   __m128i d,
+   __m128i& y,
+   __m128i& cd,
+   __m128i& cm,
+   __m128i& co)
+{
+    __m128i t0 = _mm_unpacklo_epi16(a, b);   // y0 y2 cd0 cd2 cm0 cm2 co0 co2
+    __m128i t1 = _mm_unpackhi_epi16(a, b);   // y1 y3 ...
+    __m128i t2 = _mm_unpacklo_epi16(c, d);
+    __m128i t3 = _mm_unpackhi_epi16(c, d);
+    __m128i u0 = _mm_unpacklo_epi16(t0, t1);   // y0 y1 y2 y3 cd0 cd1 cd2 cd3
+    __m128i u1 = _mm_unpackhi_epi16(t0, t1);   // cm0 .. cm3 co0 .. co3
+    __m128i u2 = _mm_unpacklo_epi16(t2, t3);
+    __m128i u3 = _mm_unpackhi_epi16(t2, t3);
+
+    y  = _mm_unpacklo_epi64(u0, u2);
+    cd = _mm_unpackhi_epi64(u0, u2);
+    cm = _mm_unpacklo_epi64(u1, u3);
+    co = _mm_unpackhi_epi64(u1, u3);
+}
+
+template<typename T>
+static void YCCC_to_BayerGB_row_sse2(
+   const std::int16_t* YCCC,
+   T* rowTop,
+   T* rowBottom,
+   std::size_t width,
+   std::size_t lossyBits)
+{
+    const __m128i shift = _mm_cvtsi32_si128((int)lossyBits);
+
+    std::size_t i = 0;
+    for(; i + 8 <= width; i += 8) {
+        __m128i y, cd, cm, co;
+        deinterleaveYCCC_sse2(
+           _mm_loadu_si128((const __m128i*)(YCCC + 4 * i)),
+           _mm_loadu_si128((const __m128i*)(YCCC + 4 * i + 8)),
+           _mm_loadu_si128((const __m128i*)(YCCC + 4 * i + 16)),
+           _mm_loadu_si128((const __m128i*)(YCCC + 4 * i + 24)),
+           y,
+           cd,
+           cm,
+           co);
+        YCCC_to_BayerGB_sse2_8<T>(y, cd, cm, co, shift, rowTop + 2 * i, rowBottom + 2 * i);
+    }
+    const std::int16_t* const ch[4] = {YCCC, YCCC + 1, YCCC + 2, YCCC + 3};
+    YCCC_to_BayerGB_row_scalar<T>(ch, 4, rowTop, rowBottom, i, width, lossyBits);
+}
+
+template<typename T>
+static void YCCC_to_BayerGB_planes_sse2(
+   const std::int16_t* const ch[4],
+   T* rowTop,
+   T* rowBottom,
+   std::size_t width,
+   std::size_t lossyBits)
+{
+    const __m128i shift = _mm_cvtsi32_si128((int)lossyBits);
+
+    std::size_t i = 0;
+    for(; i + 8 <= width; i += 8) {
+        YCCC_to_BayerGB_sse2_8<T>(
+           _mm_loadu_si128((const __m128i*)(ch[0] + i)),
+           _mm_loadu_si128((const __m128i*)(ch[1] + i)),
+           _mm_loadu_si128((const __m128i*)(ch[2] + i)),
+           _mm_loadu_si128((const __m128i*)(ch[3] + i)),
+           shift,
+           rowTop + 2 * i,
+           rowBottom + 2 * i);
+    }
+    YCCC_to_BayerGB_row_scalar<T>(ch, 1, rowTop, rowBottom, i, width, lossyBits);
+}
+
+/**
+ * Loads 8 int16 from @param lo to low 128 bit lane and 8 from @param hi to high lane.
+*/
+TARGET_AVX2 static inline __m256i load2x128(const std::int16_t* lo, const std::int16_t* hi)
+{
+    return _mm256_inserti128_si256(
+       _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)lo)),
+       _mm_loadu_si128((const __m128i*)hi),
+       1);
+}
+
+/**
+ * Inverse transform of 16 quads (q0 .. q15 in element order) and store to 2 * 16 pixels of each row.
+*/
+template<typename T>
+TARGET_AVX2 static inline void YCCC_to_BayerGB_avx2_16(
+   __m256i y,
+   __m256i cd,
+   __m256i cm,
+   __m256i co,
+   __m128i shift,
+   T* rowTop,
+   T* rowBottom)
+{
+    __m256i base = _mm256_slli_epi16(_mm256_add_epi16(_mm256_add_epi16(y, cd), co), 1);
+    __m256i cm4  = _mm256_slli_epi16(cm, 2);
+
+    __m256i gr = _mm256_sll_epi16(_mm256_srai_epi16(_mm256_add_epi16(base, cm4), 3), shift);
+    __m256i r  = _mm256_sll_epi16(_mm256_srai_epi16(_mm256_sub_epi16(base, cm4), 3), shift);
+    __m256i bl = _mm256_sll_epi16(
+       _mm256_srai_epi16(_mm256_sub_epi16(_mm256_sub_epi16(base, cm4), _mm256_slli_epi16(co, 3)), 3),
+       shift);
+    __m256i gb = _mm256_sll_epi16(
+       _mm256_srai_epi16(_mm256_sub_epi16(_mm256_add_epi16(base, cm4), _mm256_slli_epi16(cd, 3)), 3),
+       shift);
+
+    // lo = q0..q3 | q8..q11, hi = q4..q7 | q12..q15
+    __m256i top_lo    = _mm256_unpacklo_epi16(gb, bl);
+    __m256i top_hi    = _mm256_unpackhi_epi16(gb, bl);
+    __m256i bottom_lo = _mm256_unpacklo_epi16(r, gr);
+    __m256i bottom_hi = _mm256_unpackhi_epi16(r, gr);
+
+    if constexpr(sizeof(T) == 1) {
+        // in-lane pack puts q0..q7 to low lane and q8..q15 to high lane, which is already in order
+        const __m256i mask8 = _mm256_set1_epi16(0xFF);
+        _mm256_storeu_si256(
+           (__m256i*)rowTop,
+           _mm256_packus_epi16(_mm256_and_si256(top_lo, mask8), _mm256_and_si256(top_hi, mask8)));
+        _mm256_storeu_si256(
+           (__m256i*)rowBottom,
+           _mm256_packus_epi16(_mm256_and_si256(bottom_lo, mask8), _mm256_and_si256(bottom_hi, mask8)));
+    } else {
+        _mm256_storeu_si256((__m256i*)rowTop, _mm256_permute2x128_si256(top_lo, top_hi, 0x20));
+        _mm256_storeu_si256((__m256i*)(rowTop + 16), _mm256_permute2x128_si256(top_lo, top_hi, 0x31));
+        _mm256_storeu_si256((__m256i*)rowBottom, _mm256_permute2x128_si256(bottom_lo, bottom_hi, 0x20));
+        _mm256_storeu_si256((__m256i*)(rowBottom + 16), _mm256_permute2x128_si256(bottom_lo, bottom_hi, 0x31));
+    }
+}
+
+/**
+ * 16 quads per iteration. Loads are arranged so that low 128 bit lane holds q0 .. q7 and high lane q8 .. q15,
+ * then the in-lane unpacks of the SSE2 version apply unchanged.
+*/
+template<typename T>
+TARGET_AVX2 static void YCCC_to_BayerGB_row_avx2(
+   const std::int16_t* YCCC,
+   T* rowTop,
+   T* rowBottom,
+   std::size_t width,
+   std::size_t lossyBits)
+{
+    const __m128i shift = _mm_cvtsi32_si128((int)lossyBits);
+
+    std::size_t i = 0;
+    for(; i + 16 <= width; i += 16) {
+        const std::int16_t* p = YCCC + 4 * i;
+        __m256i a             = load2x128(p + 0, p + 32);
+        __m256i b             = load2x128(p + 8, p + 40);
+        __m256i c             = load2x128(p + 16, p + 48);
+        __m256i d             = load2x128(p + 24, p + 56);
+
+        __m256i t0 = _mm256_unpacklo_epi16(a, b);
+        __m256i t1 = _mm256_unpackhi_epi16(a, b);
+        __m256i t2 = _mm256_unpacklo_epi16(c, d);
+        __m256i t3 = _mm256_unpackhi_epi16(c, d);
+        __m256i u0 = _mm256_unpacklo_epi16(t0, t1);
+        __m256i u1 = _mm256_unpackhi_epi16(t0, t1);
+        __m256i u2 = _mm256_unpacklo_epi16(t2, t3);
+        __m256i u3 = _mm256_unpackhi_epi16(t2, t3);
+
+        YCCC_to_BayerGB_avx2_16<T>(
+           _mm256_unpacklo_epi64(u0, u2),
+           _mm256_unpackhi_epi64(u0, u2),
+           _mm256_unpacklo_epi64(u1, u3),
+           _mm256_unpackhi_epi64(u1, u3),
+           shift,
+           rowTop + 2 * i,
+           rowBottom + 2 * i);
+    }
+    YCCC_to_BayerGB_row_sse2<T>(YCCC + 4 * i, rowTop + 2 * i, rowBottom + 2 * i, width - i, lossyBits);
+}
+
+template<typename T>
+TARGET_AVX2 static void YCCC_to_BayerGB_planes_avx2(
+   const std::int16_t* const ch[4],
+   T* rowTop,
+   T* rowBottom,
+   std::size_t width,
+   std::size_t lossyBits)
+{
+    const __m128i shift = _mm_cvtsi32_si128((int)lossyBits);
+
+    std::size_t i = 0;
+    for(; i + 16 <= width; i += 16) {
+        YCCC_to_BayerGB_avx2_16<T>(
+           _mm256_loadu_si256((const __m256i*)(ch[0] + i)),
+           _mm256_loadu_si256((const __m256i*)(ch[1] + i)),
+           _mm256_loadu_si256((const __m256i*)(ch[2] + i)),
+           _mm256_loadu_si256((const __m256i*)(ch[3] + i)),
+           shift,
+           rowTop + 2 * i,
+           rowBottom + 2 * i);
+    }
+    const std::int16_t* const rest[4] = {ch[0] + i, ch[1] + i, ch[2] + i, ch[3] + i};
+    YCCC_to_BayerGB_planes_sse2<T>(rest, rowTop + 2 * i, rowBottom + 2 * i, width - i, lossyBits);
+}
+
+/**
+ * Inclusive prefix sum of 8 int16 with log2(8) shifted adds, @param carry holds the last sum of previous vector
+ * in all elements. Returns new carry.
+*/
+static inline __m128i prefixSum_sse2_8(std::int16_t* data, __m128i carry)
+{
+    __m128i x = _mm_loadu_si128((const __m128i*)data);
+    x         = _mm_add_epi16(x, _mm_slli_si128(x, 2));
+    x         = _mm_add_epi16(x, _mm_slli_si128(x, 4));
+    x         = _mm_add_epi16(x, _mm_slli_si128(x, 8));
+    x         = _mm_add_epi16(x, carry);
+    _mm_storeu_si128((__m128i*)data, x);
+    __m128i last = _mm_shufflehi_epi16(x, 0xFF);   // element 7 to upper 4 elements
+    return _mm_unpackhi_epi64(last, last);
+}
+
+static void inclusivePrefixSum_row_sse2(std::int16_t* data, std::size_t length)
+{
+    __m128i carry = _mm_setzero_si128();
+
+    std::size_t i = 0;
+    for(; i + 8 <= length; i += 8) {
+        carry = prefixSum_sse2_8(data + i, carry);
+    }
+    inclusivePrefixSum_row_scalar(data, i, length);
+}
+
+/**
+ * Same as SSE2 version on 16 elements. Shifts work within 128 bit lanes, last sum of the low lane is then
+ * added to the high lane.
+*/
+TARGET_AVX2 static void inclusivePrefixSum_row_avx2(std::int16_t* data, std::size_t length)
+{
+    __m256i carry = _mm256_setzero_si256();
+
+    std::size_t i = 0;
+    for(; i + 16 <= length; i += 16) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(data + i));
+        x         = _mm256_add_epi16(x, _mm256_slli_si256(x, 2));
+        x         = _mm256_add_epi16(x, _mm256_slli_si256(x, 4));
+        x         = _mm256_add_epi16(x, _mm256_slli_si256(x, 8));
+
+        __m256i low = _mm256_permute2x128_si256(x, x, 0x08);   // zero | low lane
+        low         = _mm256_shufflehi_epi16(low, 0xFF);
+        x           = _mm256_add_epi16(x, _mm256_unpackhi_epi64(low, low));
+        x           = _mm256_add_epi16(x, carry);
+        _mm256_storeu_si256((__m256i*)(data + i), x);
+
+        __m256i last = _mm256_shufflehi_epi16(x, 0xFF);
+        last         = _mm256_unpackhi_epi64(last, last);
+        carry        = _mm256_permute2x128_si256(last, last, 0x11);   // element 15 to both lanes
+    }
+    if(i + 8 <= length) {
+        (void)prefixSum_sse2_8(data + i, _mm256_castsi256_si128(carry));
+        i += 8;
+    }
+    inclusivePrefixSum_row_scalar(data, i, length);
+}
+
+#endif
+
+ColorTransform::isa ColorTransform::getIsa()
+{
+    static const isa detected = []() {
+#ifdef COLOR_TRANSFORM_X86
+#    if defined(__GNUC__)
+        if(__builtin_cpu_supports("avx2")) {
+            return isa::avx2;
+        }
+#    endif
+        return isa::sse2;   // baseline on x86-64
+#else
+        return isa::scalar;
+#endif
+    }();
+    return detected;
+}
+
+const char* ColorTransform::getIsaName()
+{
+    switch(getIsa()) {
+        case isa::avx2:
+            return "AVX2";
+        case isa::sse2:
+            return "SSE2";
+        default:
+            return "scalar";
+    }
+}
+
+void ColorTransform::bayerGBToYCCC_row(
+   const std::uint16_t* rowTop,
+   const std::uint16_t* rowBottom,
+   std::int16_t* YCCC,
+   std::size_t width,
+   std::size_t lossyBits)
+{
+#ifdef COLOR_TRANSFORM_X86
+    switch(getIsa()) {
+        case isa::avx2:
+            return bayerGBToYCCC_row_avx2(rowTop, rowBottom, YCCC, width, lossyBits);
+        case isa::sse2:
+            return bayerGBToYCCC_row_sse2(rowTop, rowBottom, YCCC, width, lossyBits);
+        default:
+            break;
+    }
+#endif
+    bayerGBToYCCC_row_scalar(rowTop, rowBottom, YCCC, 0, width, lossyBits);
+}
+
+template<typename T>
+static void YCCC_to_BayerGB_row_dispatch(
+   const std::int16_t* YCCC,
+   T* rowTop,
+   T* rowBottom,
+   std::size_t width,
+   std::size_t lossyBits)
+{
+#ifdef COLOR_TRANSFORM_X86
+    switch(ColorTransform::getIsa()) {
+        case ColorTransform::isa::avx2:
+            return YCCC_to_BayerGB_row_avx2<T>(YCCC, rowTop, rowBottom, width, lossyBits);
+        case ColorTransform::isa::sse2:
+            return YCCC_to_BayerGB_row_sse2<T>(YCCC, rowTop, rowBottom, width, lossyBits);
+        default:
+            break;
+    }
+#endif
+    const std::int16_t* const ch[4] = {YCCC, YCCC + 1, YCCC + 2, YCCC + 3};
+    YCCC_to_BayerGB_row_scalar<T>(ch, 4, rowTop, rowBottom, 0, width, lossyBits);
+}
+
+template<typename T>
+static void YCCC_to_BayerGB_planes_dispatch(
+   const std::int16_t* const ch[4],
+   T* rowTop,
+   T* rowBottom,
+   std::size_t width,
+   std::size_t lossyBits)
+{
+#ifdef COLOR_TRANSFORM_X86
+    switch(ColorTransform::getIsa()) {
+        case ColorTransform::isa::avx2:
+            return YCCC_to_BayerGB_planes_avx2<T>(ch, rowTop, rowBottom, width, lossyBits);
+        case ColorTransform::isa::sse2:
+            return YCCC_to_BayerGB_planes_sse2<T>(ch, rowTop, rowBottom, width, lossyBits);
+        default:
+            break;
+    }
+#endif
+    YCCC_to_BayerGB_row_scalar<T>(ch, 1, rowTop, rowBottom, 0, width, lossyBits);
+}
+
+void ColorTransform::YCCC_to_BayerGB_row(
+   const std::int16_t* YCCC,
+   std::uint8_t* rowTop,
+   std::uint8_t* rowBottom,
+   std::size_t width,
+   std::size_t lossyBits)
+{
+    YCCC_to_BayerGB_row_dispatch(YCCC, rowTop, rowBottom, width, lossyBits);
+}
+
+void ColorTransform::YCCC_to_BayerGB_row(
+   const std::int16_t* YCCC,
+   std::uint16_t* rowTop,
+   std::uint16_t* rowBottom,
+   std::size_t width,
+   std::size_t lossyBits)
+{
+    YCCC_to_BayerGB_row_dispatch(YCCC, rowTop, rowBottom, width, lossyBits);
+}
+
+void ColorTransform::YCCC_to_BayerGB_row(
+   const std::int16_t* const YCCC_planes[4],
+   std::uint8_t* rowTop,
+   std::uint8_t* rowBottom,
+   std::size_t width,
+   std::size_t lossyBits)
+{
+    YCCC_to_BayerGB_planes_dispatch(YCCC_planes, rowTop, rowBottom, width, lossyBits);
+}
+
+void ColorTransform::YCCC_to_BayerGB_row(
+   const std::int16_t* const YCCC_planes[4],
+   std::uint16_t* rowTop,
+   std::uint16_t* rowBottom,
+   std::size_t width,
+   std::size_t lossyBits)
+{
+    YCCC_to_BayerGB_planes_dispatch(YCCC_planes, rowTop, rowBottom, width, lossyBits);
+}
+
+void ColorTransform::inclusivePrefixSum_row(std::int16_t* data, std::size_t length)
+{
+#ifdef COLOR_TRANSFORM_X86
+    switch(getIsa()) {
+        case isa::avx2:
+            return inclusivePrefixSum_row_avx2(data, length);
+        case isa::sse2:
+            return inclusivePrefixSum_row_sse2(data, length);
+        default:
+            break;
+    }
+#endif
+    inclusivePrefixSum_row_scalar(data, 0, length);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Row kernels of the Bayer GB <-> YCdCmCo color transform. Whole row of quads is converted at once,
+ * with AVX2 or SSE2 when CPU supports it (selected at runtime), otherwise scalar.
+ * Results are bit exact with Helpers::transformColorGB and DecoderBase::YCCC_to_BayerGB.
+ *
+ * Gb | Bl =>  Y  | Cd
+ * ---+--- =>  ---+---
+ * Rd | Gr =>  Cm | Co
+ *
+ * YCCC holds channels interleaved per quad: Y0 Cd0 Cm0 Co0 Y1 Cd1 Cm1 Co1 ...
+ * YCCC_planes holds pointers to Y, Cd, Cm and Co rows of separate planes (sQuadChannelCS layout).
+ * rowTop holds Gb0 B0 Gb1 B1 ..., rowBottom R0 Gr0 R1 Gr1 ...; width is number of quads in a row.
+ */
+class ColorTransform
+{
+  public:
+    enum class isa
+    {
+        scalar,
+        sse2,
+        avx2
+    };
+
+    static isa getIsa();
+    static const char* getIsaName();
+
+    static void bayerGBToYCCC_row(
+       const std::uint16_t* rowTop,
+       const std::uint16_t* rowBottom,
+       std::int16_t* YCCC,
+       std::size_t width,
+       std::size_t lossyBits);
+
+    static void YCCC_to_BayerGB_row(
+       const std::int16_t* YCCC,
+       std::uint8_t* rowTop,
+       std::uint8_t* rowBottom,
+       std::size_t width,
+       std::size_t lossyBits);
+    static void YCCC_to_BayerGB_row(
+       const std::int16_t* YCCC,
+       std::uint16_t* rowTop,
+       std::uint16_t* rowBottom,
+       std::size_t width,
+       std::size_t lossyBits);
+    static void YCCC_to_BayerGB_row(
+       const std::int16_t* const YCCC_planes[4],
+       std::uint8_t* rowTop,
+       std::uint8_t* rowBottom,
+       std::size_t width,
+       std::size_t lossyBits);
+    static void YCCC_to_BayerGB_row(
+       const std::int16_t* const YCCC_planes[4],
+       std::uint16_t* rowTop,
+       std::uint16_t* rowBottom,
+       std::size_t width,
+       std::size_t lossyBits);
+
+    /**
+     * DPCM to YCCC along a row of one plane: data[i] += data[i - 1], in place, wrapping as int16.
+     * Data must start with the reconstructed first column pixel.
+     */
+    static void inclusivePrefixSum_row(std::int16_t* data, std::size_t length);
+};
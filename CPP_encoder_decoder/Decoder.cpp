@@ -52,32 +52,38 @@ Decoder::Decoder(const char* fileName, std::uint32_t A_init, std::uint32_t N_thr
 };
 
 /**
- * This one cannot be used for decoding data with channels that are encoded in parallel.
+ * Parallel decoders decode to <workspace> and use its scratch buffers, so that a streaming decoder
+ * (one workspace for many frames) does not allocate per frame. Decoded image stays in the workspace until
+ * the next decode, exportBayerImage must be called before that. Workspace must outlive the decoder.
+ * Without it, decoder allocates its own workspace on first decode.
 */
-void Decoder::decodeSequentially(std::size_t lossyBits)
+void Decoder::setWorkspace(DecodeWorkspace_s* workspace)
 {
-    std::cout << "\nSequential decoding: " << unsigned(m_width) << " x " << unsigned(m_height) << std::endl;
-    decodeBitstreamAll(m_N_threshold, m_A_init);
-    toFullAll();
-    toBayerGB(lossyBits);
+    m_pWorkspace = workspace;
+}
+
+DecodeWorkspace_s& Decoder::getWorkspace()
+{
+    if(m_pWorkspace == nullptr) {
+        m_pOwnWorkspace = std::make_unique<DecodeWorkspace_s>();
+        m_pWorkspace    = m_pOwnWorkspace.get();
+    }
+    return *m_pWorkspace;
 }
 
 /**
- * Decodes data with channels that are encoded in parallel.
+ * Reads header of compressed image (24 bytes). Throws if header is invalid.
 */
-headerData_t Decoder::decodeParallel()
+headerData_t Decoder::readHeader(std::span<std::uint8_t const> bitStream)
 {
-
-    // std::vector<std::uint8_t> bayerGB(2 * width * 2 * height);
-    // a) here we need info about size to allocate vector
-    // b) we need to be able to accept unique_ptr to vector
-
     headerData_t headerData;
 
-    auto data = m_pFileData.get();
+    if(bitStream.size() < 24) {
+        throw std::runtime_error("Compressed image is shorter than its header.");
+    }
 
     auto status = Reader::getTimestampAndCompressionInfoFromHeader(   //
-       data->data(),
+       bitStream.data(),
        headerData.timestamp,
        headerData.roi,
        headerData.width,
@@ -86,116 +92,591 @@ headerData_t Decoder::decodeParallel()
        headerData.bpp,
        headerData.lossyBits,
        headerData.reserved);
-
-    m_width  = headerData.width / 2;
-    m_height = headerData.height / 2;
-
     if(status) {
+        handleReturnValue(status);
         throw std::runtime_error("Error while reading header.");
     }
+    return headerData;
+}
 
-    std::cout << "\nUsing CPU: Parallel decoding image size W x H : " << unsigned(headerData.width) << " x "
-              << unsigned(headerData.height) << std::endl;
-
-    if(headerData.bpp == 8) {
-        std::vector<std::uint8_t> out_buffer(headerData.width * headerData.height);
+/**
+ * Reads block index of compressed image to @param blockSizes (empty for image without blocks) and @param blockRows
+ * (first rows of blocks, empty for equal split), or checkpoint index of image encoded as one AGOR stream
+ * to @param checkpoints (empty without it), and returns offset of the payload. Throws if index is invalid.
+*/
+std::size_t Decoder::readBlockIndex(
+   std::span<std::uint8_t const> bitStream,
+   const headerData_t& headerData,
+   std::vector<std::uint32_t>& blockSizes,
+   std::vector<std::uint32_t>& blockRows,
+   std::vector<AgorCheckpoint_s>& checkpoints)
+{
+    std::size_t payloadOffset = 0;
+
+    blockSizes.clear();
+    blockRows.clear();
+    checkpoints.clear();
+    STATUS_t status;
+    if((headerData.reserved & C_HEADER_FLAG_CHECKPOINT_INDEX) == 0) {
+        status = Reader::getBlockIndex(   //
+           bitStream.data(),
+           bitStream.size(),
+           headerData.reserved,
+           blockSizes,
+           blockRows,
+           payloadOffset);
+        // only trailing blocks may be empty, as with equal split
+        for(std::size_t block = 1; status == BASE_SUCCESS && block < blockRows.size(); block++) {
+            if(blockRows[block] > headerData.height / 2u
+               || (blockRows[block] == blockRows[block - 1] && blockRows[block] != headerData.height / 2u)) {
+                status = BASE_ERROR_BLOCK_SIZES_INVALID;
+            }
+        }
+    } else if((headerData.reserved & C_HEADER_FLAG_BLOCK_INDEX) == 0) {
+        status = Reader::getCheckpointIndex(   //
+           bitStream.data(),
+           bitStream.size(),
+           headerData.reserved,
+           checkpoints,
+           payloadOffset);
+        if(status == BASE_SUCCESS && checkpoints.back().row >= headerData.height / 2u) {
+            status = BASE_ERROR_BLOCK_SIZES_INVALID;
+        }
+    } else {
+        status = BASE_ERROR_HEADER_DATA_INVALID;   // image has either blocks or checkpoints
+    }
+    if(status) {
+        handleReturnValue(status);
+        throw std::runtime_error("Error while reading block index.");
+    }
+    return payloadOffset;
+}
 
-        status = DecoderBase::decodeBitstreamParallel_actual<std::uint8_t>(
+/**
+ * Decodes payload of compressed image, in blocks when @param blockSizes is not empty,
+ * from checkpoints when @param checkpoints is not empty.
+*/
+template<typename T>
+static void decodePayloadT(
+   const headerData_t& headerData,
+   std::span<std::uint8_t const> payload,
+   const std::vector<std::uint32_t>& blockSizes,
+   const std::vector<std::uint32_t>& blockRows,
+   const std::vector<AgorCheckpoint_s>& checkpoints,
+   T* bayerGB,
+   std::size_t bayerGBSize,
+   std::size_t nrOfThreads,
+   DecodeWorkspace_s* workspace)
+{
+    STATUS_t status;
+    if(!checkpoints.empty()) {
+        status = DecoderBase::decodeCheckpointRows_actual<T>(
            headerData.width,
            headerData.height,
            headerData.lossyBits,
            headerData.unaryMaxWidth,
            headerData.bpp,
-           data->data() + 24,
-           data->size() - 24,
-           out_buffer.data(),
-           out_buffer.size());
-        if(status) {
-            handleReturnValue(status);
-            // printf("Error while decoding bitstream, error code: %d.\n", status);
-            throw std::runtime_error("Parallel decoding unsuccessful.");
-        };
+           payload.data(),
+           payload.size(),
+           bayerGB,
+           bayerGBSize,
+           checkpoints,
+           0,
+           headerData.height,
+           nrOfThreads,
+           workspace);
+    } else if(blockSizes.empty()) {
+        status = DecoderBase::decodeBitstreamParallel_actual<T>(
+           headerData.width,
+           headerData.height,
+           headerData.lossyBits,
+           headerData.unaryMaxWidth,
+           headerData.bpp,
+           payload.data(),
+           payload.size(),
+           bayerGB,
+           bayerGBSize,
+           workspace == nullptr ? nullptr : workspace->getRows(1, headerData.width / 2));
+    } else {
+        status = DecoderBase::decodeBlocksParallel_actual<T>(
+           headerData.width,
+           headerData.height,
+           headerData.lossyBits,
+           headerData.unaryMaxWidth,
+           headerData.bpp,
+           payload.data(),
+           payload.size(),
+           bayerGB,
+           bayerGBSize,
+           blockSizes,
+           blockRows,
+           nrOfThreads,
+           workspace);
+    }
+    if(status) {
+        DecoderBase::handleReturnValue(status);
+        throw std::runtime_error("Parallel decoding unsuccessful.");
+    };
+}
+
+/**
+ * Decodes compressed image from memory to caller owned buffer, on the calling thread.
+ * bayerGB must have exactly width x height elements; 8 BPP images decode to std::uint8_t, others to std::uint16_t.
+*/
+template<typename T>
+static headerData_t decodeToBufferT(std::span<std::uint8_t const> bitStream, std::span<T> bayerGB)
+{
+    headerData_t headerData = Decoder::readHeader(bitStream);
+
+    if((headerData.bpp == 8) != (sizeof(T) == 1)) {
+        char msg[200];
+        sprintf(msg, "Output buffer element size %zu B does not match %u BPP image.", sizeof(T), headerData.bpp);
+        throw std::runtime_error(msg);
+    }
 
-        m_pBayer_8bit =
-           std::make_unique<std::vector<std::uint8_t>>(std::forward<std::vector<std::uint8_t>>(out_buffer));
-        m_pBayer_16bit.reset();
+    std::vector<std::uint32_t> blockSizes;
+    std::vector<std::uint32_t> blockRows;
+    std::vector<AgorCheckpoint_s> checkpoints;
+    std::size_t payloadOffset = Decoder::readBlockIndex(bitStream, headerData, blockSizes, blockRows, checkpoints);
+    decodePayloadT<T>(
+       headerData,
+       bitStream.subspan(payloadOffset),
+       blockSizes,
+       blockRows,
+       checkpoints,
+       bayerGB.data(),
+       bayerGB.size(),
+       1,
+       nullptr);
+    return headerData;
+}
 
-    } else {
-        std::vector<std::uint16_t> out_buffer(headerData.width * headerData.height);
-        status = DecoderBase::decodeBitstreamParallel_actual<std::uint16_t>(
+/**
+ * Decodes BayerCFA rows [rowFirst, rowFirst + rows) of payload, only blocks (or checkpoint segments) that hold them
+ * are decoded. Image without blocks is decoded as a single block, from its first row down to the last requested one.
+*/
+template<typename T>
+static void decodePayloadRowsT(
+   const headerData_t& headerData,
+   std::span<std::uint8_t const> payload,
+   const std::vector<std::uint32_t>& blockSizes,
+   const std::vector<std::uint32_t>& blockRows,
+   const std::vector<AgorCheckpoint_s>& checkpoints,
+   std::size_t rowFirst,
+   std::size_t rows,
+   T* bayerGB,
+   std::size_t bayerGBSize,
+   std::size_t nrOfThreads,
+   DecodeWorkspace_s* workspace)
+{
+    if(!checkpoints.empty()) {
+        auto status = DecoderBase::decodeCheckpointRows_actual<T>(
            headerData.width,
            headerData.height,
            headerData.lossyBits,
            headerData.unaryMaxWidth,
            headerData.bpp,
-           data->data() + 24,
-           data->size() - 24,
-           out_buffer.data(),
-           out_buffer.size());
+           payload.data(),
+           payload.size(),
+           bayerGB,
+           bayerGBSize,
+           checkpoints,
+           rowFirst,
+           rows,
+           nrOfThreads,
+           workspace);
         if(status) {
-            handleReturnValue(status);
-            // printf("Error while decoding bitstream, error code: %d.\n", status);
-            throw std::runtime_error("Parallel decoding unsuccessful.");
+            DecoderBase::handleReturnValue(status);
+            throw std::runtime_error("Decoding of rows unsuccessful.");
         };
+        return;
+    }
 
-        m_pBayer_16bit =
-           std::make_unique<std::vector<std::uint16_t>>(std::forward<std::vector<std::uint16_t>>(out_buffer));
-        m_pBayer_8bit.reset();
+    std::vector<std::uint32_t> wholeImage;
+    if(blockSizes.empty()) {
+        wholeImage.push_back(payload.size());
     }
 
+    auto status = DecoderBase::decodeBlockRows_actual<T>(
+       headerData.width,
+       headerData.height,
+       headerData.lossyBits,
+       headerData.unaryMaxWidth,
+       headerData.bpp,
+       payload.data(),
+       payload.size(),
+       bayerGB,
+       bayerGBSize,
+       blockSizes.empty() ? wholeImage : blockSizes,
+       blockRows,
+       rowFirst,
+       rows,
+       nrOfThreads,
+       workspace);
+    if(status) {
+        DecoderBase::handleReturnValue(status);
+        throw std::runtime_error("Decoding of rows unsuccessful.");
+    };
+}
+
+/**
+ * Header of rows [rowFirst, rowFirst + rows) of image with @param headerData: height and ROI height are the
+ * number of rows, ROI y offset is moved by rowFirst.
+*/
+static headerData_t cropHeaderToRows(headerData_t headerData, std::size_t rowFirst, std::size_t rows)
+{
+    // roi: height << 48 | width << 32 | offset_y << 16 | offset_x
+    std::uint64_t height   = rows & 0xFFFF;
+    std::uint64_t offset_y = (((headerData.roi >> 16) & 0xFFFF) + rowFirst) & 0xFFFF;
+
+    headerData.height = rows;
+    headerData.roi    = (headerData.roi & 0x0000FFFF0000FFFFLLU) | height << 48 | offset_y << 16;
     return headerData;
 }
 
+/**
+ * Decodes BayerCFA rows [rowFirst, rowFirst + rows) of compressed image from memory to caller owned buffer,
+ * on the calling thread. bayerGB must have exactly width x rows elements. Returns header of the decoded rows.
+*/
+template<typename T>
+static headerData_t decodeRowsToBufferT(
+   std::span<std::uint8_t const> bitStream,
+   std::size_t rowFirst,
+   std::size_t rows,
+   std::span<T> bayerGB)
+{
+    headerData_t headerData = Decoder::readHeader(bitStream);
+
+    if((headerData.bpp == 8) != (sizeof(T) == 1)) {
+        char msg[200];
+        sprintf(msg, "Output buffer element size %zu B does not match %u BPP image.", sizeof(T), headerData.bpp);
+        throw std::runtime_error(msg);
+    }
+
+    std::vector<std::uint32_t> blockSizes;
+    std::vector<std::uint32_t> blockRows;
+    std::vector<AgorCheckpoint_s> checkpoints;
+    std::size_t payloadOffset = Decoder::readBlockIndex(bitStream, headerData, blockSizes, blockRows, checkpoints);
+    decodePayloadRowsT<T>(
+       headerData,
+       bitStream.subspan(payloadOffset),
+       blockSizes,
+       blockRows,
+       checkpoints,
+       rowFirst,
+       rows,
+       bayerGB.data(),
+       bayerGB.size(),
+       1,
+       nullptr);
+    return cropHeaderToRows(headerData, rowFirst, rows);
+}
+
+headerData_t Decoder::decodeToBuffer(std::span<std::uint8_t const> bitStream, std::span<std::uint8_t> bayerGB)
+{
+    return decodeToBufferT(bitStream, bayerGB);
+}
+
+headerData_t Decoder::decodeToBuffer(std::span<std::uint8_t const> bitStream, std::span<std::uint16_t> bayerGB)
+{
+    return decodeToBufferT(bitStream, bayerGB);
+}
+
+headerData_t Decoder::decodeRowsToBuffer(
+   std::span<std::uint8_t const> bitStream,
+   std::size_t rowFirst,
+   std::size_t rows,
+   std::span<std::uint8_t> bayerGB)
+{
+    return decodeRowsToBufferT(bitStream, rowFirst, rows, bayerGB);
+}
+
+headerData_t Decoder::decodeRowsToBuffer(
+   std::span<std::uint8_t const> bitStream,
+   std::size_t rowFirst,
+   std::size_t rows,
+   std::span<std::uint16_t> bayerGB)
+{
+    return decodeRowsToBufferT(bitStream, rowFirst, rows, bayerGB);
+}
+
+/**
+ * This one cannot be used for decoding data with channels that are encoded in parallel.
+*/
+void Decoder::decodeSequentially(std::size_t lossyBits)
+{
+    std::cout << "\nSequential decoding: " << unsigned(m_width) << " x " << unsigned(m_height) << std::endl;
+    decodeBitstreamAll(m_N_threshold, m_A_init);
+    toFullAll();
+    toBayerGB(lossyBits);
+}
+
 /**
  * Decodes data with channels that are encoded in parallel.
+ * Image compressed in blocks is decoded by blocks on <nrOfThreads> CPU threads (0: all available).
 */
-headerData_t Decoder::decodeParallelGPU(std::vector<std::uint32_t>& blockSizes)
+headerData_t Decoder::decodeParallel(std::size_t nrOfThreads)
 {
+    std::span<std::uint8_t const> data = m_pFileData->getDataView();
 
-    // std::vector<std::uint8_t> bayerGB(2 * width * 2 * height);
-    // a) here we need info about size to allocate vector
-    // b) we need to be able to accept unique_ptr to vector
+    headerData_t headerData   = readHeader(data);
+    std::size_t payloadOffset = readBlockIndex(data, headerData, m_blockSizes, m_blockRows, m_checkpoints);
+    if(m_blockSizes.empty() && m_checkpoints.empty()) {
+        m_checkpoints = m_sidecarCheckpoints;
+    }
 
-    std::uint16_t nrOfBlocks = blockSizes.size();
-    headerData_t headerData;
+    m_width  = headerData.width / 2;
+    m_height = headerData.height / 2;
 
-    auto data = m_pFileData.get();
+    if(!m_checkpoints.empty()) {
+        std::cout << "\nUsing CPU: Parallel decoding from " << m_checkpoints.size()
+                  << " checkpoints, image size W x H : " << unsigned(headerData.width) << " x "
+                  << unsigned(headerData.height) << std::endl;
+    } else if(m_blockSizes.empty()) {
+        std::cout << "\nUsing CPU: Parallel decoding image size W x H : " << unsigned(headerData.width) << " x "
+                  << unsigned(headerData.height) << std::endl;
+    } else {
+        std::cout << "\nUsing CPU: Parallel decoding of " << m_blockSizes.size()
+                  << " blocks, image size W x H : " << unsigned(headerData.width) << " x "
+                  << unsigned(headerData.height) << std::endl;
+    }
 
-    auto status = Reader::getTimestampAndCompressionInfoFromHeader(   //
-       data->data(),
-       headerData.timestamp,
-       headerData.roi,
+    DecodeWorkspace_s& ws = getWorkspace();
+    std::size_t pixels    = headerData.width * headerData.height;
+    m_pBayer              = nullptr;
+
+    // out is std::uint8_t* for 8 BPP and std::uint16_t* above
+    auto decodeCPU = [&](auto* out) {
+        decodePayloadT(
+           headerData,
+           data.subspan(payloadOffset),
+           m_blockSizes,
+           m_blockRows,
+           m_checkpoints,
+           out,
+           pixels,
+           nrOfThreads,
+           &ws);
+        m_pBayer     = (const std::uint8_t*)out;
+        m_bayerBytes = sizeof(*out) * pixels;
+    };
+
+    if(headerData.bpp == 8) {
+        decodeCPU(ws.getBayer<std::uint8_t>(pixels));
+    } else {
+        decodeCPU(ws.getBayer<std::uint16_t>(pixels));
+    }
+
+    return headerData;
+}
+
+/**
+ * Decodes only BayerCFA rows [rowFirst, rowFirst + rows) of the image (e.g. region of interest of a large frame).
+ * With blocks, only blocks that hold the rows are decoded, on <nrOfThreads> CPU threads (0: all available).
+ * Row range must be even. Decoded rows are exported by exportBayerImage, returned header describes them.
+*/
+headerData_t Decoder::decodeRows(std::size_t rowFirst, std::size_t rows, std::size_t nrOfThreads)
+{
+    std::span<std::uint8_t const> data = m_pFileData->getDataView();
+
+    headerData_t headerData   = readHeader(data);
+    std::size_t payloadOffset = readBlockIndex(data, headerData, m_blockSizes, m_blockRows, m_checkpoints);
+    if(m_blockSizes.empty() && m_checkpoints.empty()) {
+        m_checkpoints = m_sidecarCheckpoints;
+    }
+
+    m_width  = headerData.width / 2;
+    m_height = rows / 2;
+
+    std::cout << "\nUsing CPU: Decoding rows " << rowFirst << " - " << rowFirst + rows << " of "
+              << m_blockSizes.size() << " blocks, image size W x H : " << unsigned(headerData.width) << " x "
+              << unsigned(headerData.height) << std::endl;
+
+    DecodeWorkspace_s& ws = getWorkspace();
+    std::size_t pixels    = headerData.width * rows;
+    m_pBayer              = nullptr;
+
+    // out is std::uint8_t* for 8 BPP and std::uint16_t* above
+    auto decodeCPU = [&](auto* out) {
+        decodePayloadRowsT(
+           headerData,
+           data.subspan(payloadOffset),
+           m_blockSizes,
+           m_blockRows,
+           m_checkpoints,
+           rowFirst,
+           rows,
+           out,
+           pixels,
+           nrOfThreads,
+           &ws);
+        m_pBayer     = (const std::uint8_t*)out;
+        m_bayerBytes = sizeof(*out) * pixels;
+    };
+
+    if(headerData.bpp == 8) {
+        decodeCPU(ws.getBayer<std::uint8_t>(pixels));
+    } else {
+        decodeCPU(ws.getBayer<std::uint16_t>(pixels));
+    }
+
+    return cropHeaderToRows(headerData, rowFirst, rows);
+}
+
+/**
+ * Parses the loaded image once (without blocks or index, e.g. encoded by encodeParallel) and records AGOR state
+ * at the start of every <rowsPerCheckpoint> BayerCFA rows (must be even). decodeParallel and decodeRows of this
+ * decoder then decode from the checkpoints on multiple threads; exportCheckpointIndex stores them for later decodes.
+ * Returns number of checkpoints.
+*/
+std::size_t Decoder::buildCheckpointIndex(std::size_t rowsPerCheckpoint)
+{
+    std::span<std::uint8_t const> data = m_pFileData->getDataView();
+
+    headerData_t headerData   = readHeader(data);
+    std::size_t payloadOffset = readBlockIndex(data, headerData, m_blockSizes, m_blockRows, m_checkpoints);
+
+    if(!m_blockSizes.empty() || !m_checkpoints.empty()) {
+        throw std::runtime_error("Image already has block or checkpoint index.");
+    }
+    if(rowsPerCheckpoint == 0 || rowsPerCheckpoint % 2 != 0) {
+        throw std::runtime_error("Rows per checkpoint must be even and greater than 0.");
+    }
+
+    auto status = DecoderBase::buildCheckpoints_actual(
        headerData.width,
        headerData.height,
        headerData.unaryMaxWidth,
        headerData.bpp,
-       headerData.lossyBits,
-       headerData.reserved);
+       data.data() + payloadOffset,
+       data.size() - payloadOffset,
+       rowsPerCheckpoint / 2,
+       m_sidecarCheckpoints);
+    if(status) {
+        handleReturnValue(status);
+        throw std::runtime_error("Building of checkpoint index unsuccessful.");
+    }
+    return m_sidecarCheckpoints.size();
+}
 
-    m_width  = headerData.width / 2;
-    m_height = headerData.height / 2;
+/**
+ * Writes checkpoints of buildCheckpointIndex to sidecar file: header of the image with C_HEADER_FLAG_CHECKPOINT_INDEX
+ * followed by checkpoint index (same layout as in the file written by Encoder::encodeToBufferWithCheckpoints, so
+ * sidecar followed by payload of the image is a valid image with checkpoint index).
+*/
+void Decoder::exportCheckpointIndex(const char* fileName)
+{
+    if(m_sidecarCheckpoints.empty()) {
+        throw std::runtime_error("No checkpoint index available.");
+    }
+    std::span<std::uint8_t const> data = m_pFileData->getDataView();
+
+    std::uint64_t header[3];
+    std::memcpy(header, data.data(), sizeof(header));
+    header[2] |= (std::uint64_t)C_HEADER_FLAG_CHECKPOINT_INDEX << 56;
+    std::uint32_t count[] = {(std::uint32_t)m_sidecarCheckpoints.size(), 0};
+
+    std::ofstream wf(fileName, std::ios::out | std::ios::binary);
+    if(!wf) {
+        char msg[200];
+        sprintf(msg, "Cannot open specified file: %s", fileName);
+        throw std::runtime_error(msg);
+    }
+    wf.write((const char*)header, sizeof(header));
+    wf.write((const char*)count, sizeof(count));
+    wf.write((const char*)m_sidecarCheckpoints.data(), m_sidecarCheckpoints.size() * sizeof(AgorCheckpoint_s));
+
+    std::size_t bytes = sizeof(header) + sizeof(count) + m_sidecarCheckpoints.size() * sizeof(AgorCheckpoint_s);
+    const char zeros[16] = {};
+    wf.write(zeros, (16 - bytes % 16) % 16);
+    if(!wf) {
+        char msg[200];
+        sprintf(msg, "Cannot write specified file: %s", fileName);
+        throw std::runtime_error(msg);
+    }
+}
 
+/**
+ * Reads sidecar checkpoint index written by exportCheckpointIndex for the loaded image. Throws when the sidecar
+ * belongs to another image (headers differ) or is invalid.
+*/
+void Decoder::importCheckpointIndex(const char* fileName)
+{
+    std::unique_ptr<MappedFile> pSidecar;
+    STATUS_t status = DecoderBase::importBitstream(fileName, pSidecar);
     if(status) {
-        throw std::runtime_error("Error while reading header.");
+        char msg[200];
+        sprintf(msg, "OMLS Error: %u:Error while importing checkpoint index: %s", status, fileName);
+        throw std::runtime_error(msg);
+    }
+    std::span<std::uint8_t const> sidecar = pSidecar->getDataView();
+    std::span<std::uint8_t const> data    = m_pFileData->getDataView();
+
+    std::uint64_t header[3];
+    std::uint64_t sidecarHeader[3];
+    if(sidecar.size() < sizeof(sidecarHeader) || data.size() < sizeof(header)) {
+        throw std::runtime_error("Error while reading checkpoint index.");
+    }
+    std::memcpy(header, data.data(), sizeof(header));
+    std::memcpy(sidecarHeader, sidecar.data(), sizeof(sidecarHeader));
+    sidecarHeader[2] &= ~((std::uint64_t)C_HEADER_FLAG_CHECKPOINT_INDEX << 56);
+    if(std::memcmp(header, sidecarHeader, sizeof(header)) != 0) {
+        throw std::runtime_error("Checkpoint index does not belong to the image.");
     }
 
+    headerData_t headerData = readHeader(sidecar);
+    std::vector<std::uint32_t> blockSizes;
+    std::vector<std::uint32_t> blockRows;
+    readBlockIndex(sidecar, headerData, blockSizes, blockRows, m_sidecarCheckpoints);
+    if(m_sidecarCheckpoints.empty()) {
+        throw std::runtime_error("Error while reading checkpoint index.");
+    }
+}
+
+/**
+ * Decodes data with channels that are encoded in parallel.
+ * With blocks, <kernels> selects the OpenCL kernels (see DecoderBase::blockKernels).
+ * Image with checkpoint index is decoded as one stream, its payload is the same as without blocks.
+*/
+headerData_t Decoder::decodeParallelGPU(DecoderBase::blockKernels kernels)
+{
+
+    // std::vector<std::uint8_t> bayerGB(2 * width * 2 * height);
+    // a) here we need info about size to allocate vector
+    // b) we need to be able to accept unique_ptr to vector
+
+    std::span<std::uint8_t const> data = m_pFileData->getDataView();
+
+    headerData_t headerData     = readHeader(data);
+    std::size_t payloadOffset   = readBlockIndex(data, headerData, m_blockSizes, m_blockRows, m_checkpoints);
+    const std::uint8_t* payload = data.data() + payloadOffset;
+    std::size_t payloadSize     = data.size() - payloadOffset;
+    STATUS_t status;
+
+    m_width  = headerData.width / 2;
+    m_height = headerData.height / 2;
+
     std::cout << "\nUsing GPU: Parallel decoding image size W x H : " << unsigned(headerData.width) << " x "
               << unsigned(headerData.height) << std::endl;
 
-    if(headerData.bpp == 8) {
-        std::vector<std::uint8_t> out_buffer(headerData.width * headerData.height);
+    DecodeWorkspace_s& ws = getWorkspace();
+    std::size_t pixels    = headerData.width * headerData.height;
+    m_pBayer              = nullptr;
 
-        if(nrOfBlocks == 0) {
+    // out is std::uint8_t* for 8 BPP and std::uint16_t* above
+    auto decodeGPU = [&](auto* out) {
+        if(m_blockSizes.empty()) {
             status = DecoderBase::decodeBitstreamParallel_pseudo_gpu(
                headerData.width,
                headerData.height,
                headerData.lossyBits,
                headerData.unaryMaxWidth,
                headerData.bpp,
-               data->data() + 24,
-               data->size() - 24,
-               out_buffer.data(),
-               out_buffer.size());
+               payload,
+               payloadSize,
+               out,
+               pixels,
+               &ws);
             if(status) {
                 handleReturnValue(status);
                 // printf("Error while decoding bitstream, error code: %d.\n", status);
@@ -208,10 +689,11 @@ headerData_t Decoder::decodeParallelGPU(std::vector<std::uint32_t>& blockSizes)
                headerData.lossyBits,
                headerData.unaryMaxWidth,
                headerData.bpp,
-               data->data() + 24,
-               data->size() - 24,
-               out_buffer.data(),
-               out_buffer.size());
+               payload,
+               payloadSize,
+               out,
+               pixels,
+               &ws);
             if(status) {
                 handleReturnValue(status);
                 // printf("Error while decoding bitstream, error code: %d.\n", status);
@@ -224,11 +706,13 @@ headerData_t Decoder::decodeParallelGPU(std::vector<std::uint32_t>& blockSizes)
                headerData.lossyBits,
                headerData.unaryMaxWidth,
                headerData.bpp,
-               data->data() + 24,
-               data->size() - 24,
-               out_buffer.data(),
-               out_buffer.size(),
-               blockSizes);
+               payload,
+               payloadSize,
+               out,
+               pixels,
+               m_blockSizes,
+               m_blockRows,
+               kernels);
             if(status) {
                 handleReturnValue(status);
                 // printf("Error while decoding bitstream, error code: %d.\n", status);
@@ -236,60 +720,106 @@ headerData_t Decoder::decodeParallelGPU(std::vector<std::uint32_t>& blockSizes)
             };
         }
 
-        m_pBayer_8bit =
-           std::make_unique<std::vector<std::uint8_t>>(std::forward<std::vector<std::uint8_t>>(out_buffer));
-        m_pBayer_16bit.reset();
+        m_pBayer     = (const std::uint8_t*)out;
+        m_bayerBytes = sizeof(*out) * pixels;
+    };
 
+    if(headerData.bpp == 8) {
+        decodeGPU(ws.getBayer<std::uint8_t>(pixels));
     } else {
-
-        throw std::runtime_error("10 and 12 BPP GPU decoding not yet supported.");
-
-        // std::vector<std::uint16_t> out_buffer(headerData.width * headerData.height);
-        // status = DecoderBase::decodeBitstreamParallel_actual<std::uint16_t>(
-        //    headerData.width,
-        //    headerData.height,
-        //    headerData.lossyBits,
-        //    headerData.unaryMaxWidth,
-        //    headerData.bpp,
-        //    data->data() + 24,
-        //    data->size() - 24,
-        //    out_buffer.data(),
-        //    out_buffer.size());
-        // if(status) {
-        //     handleReturnValue(status);
-        //     // printf("Error while decoding bitstream, error code: %d.\n", status);
-        //     throw std::runtime_error("Parallel decoding unsuccessful.");
-        // };
-
-        // m_pBayer_16bit =
-        //    std::make_unique<std::vector<std::uint16_t>>(std::forward<std::vector<std::uint16_t>>(out_buffer));
-        // m_pBayer_8bit.reset();
+        decodeGPU(ws.getBayer<std::uint16_t>(pixels));
     }
 
     return headerData;
 }
 
-void Decoder::exportBayerImage(const char* fileName, std::uint64_t header, std::uint64_t roi, std::uint64_t timestamp)
+#ifdef INCLUDE_OPENCL
+/**
+ * Starts decoding of the loaded image (in blocks) on OpenCL slot <slot> and returns while the device works.
+ * Bitstream is staged by the time this returns. Result is collected with finishParallelGPU; the slot must not be
+ * used by another frame until then. <kernels> selects the OpenCL kernels (see DecoderBase::blockKernels).
+*/
+void Decoder::enqueueParallelGPU(std::size_t slot, DecoderBase::blockKernels kernels)
+{
+    std::span<std::uint8_t const> data = m_pFileData->getDataView();
+
+    m_gpuHeaderData           = readHeader(data);
+    std::size_t payloadOffset = readBlockIndex(data, m_gpuHeaderData, m_blockSizes, m_blockRows, m_checkpoints);
+    m_width                   = m_gpuHeaderData.width / 2;
+    m_height                  = m_gpuHeaderData.height / 2;
+
+    if(m_blockSizes.empty()) {
+        throw std::runtime_error("Streaming GPU decoding requires an image compressed in blocks.");
+    }
+
+    m_pGpuFrame = std::make_unique<OpenCLFrame_s>();
+    auto status = DecoderBase::enqueueBitstreamParallel_opencl(
+       *m_pGpuFrame,
+       slot,
+       m_gpuHeaderData.width,
+       m_gpuHeaderData.height,
+       m_gpuHeaderData.lossyBits,
+       m_gpuHeaderData.unaryMaxWidth,
+       m_gpuHeaderData.bpp,
+       data.data() + payloadOffset,
+       data.size() - payloadOffset,
+       m_gpuHeaderData.width * m_gpuHeaderData.height,
+       m_blockSizes,
+       m_blockRows,
+       kernels);
+    if(status) {
+        m_pGpuFrame.reset();
+        handleReturnValue(status);
+        throw std::runtime_error("Parallel decoding unsuccessful.");
+    }
+}
+
+/**
+ * Waits for the frame started by enqueueParallelGPU, decoded image is then available to exportBayerImage.
+*/
+headerData_t Decoder::finishParallelGPU()
 {
-    if(m_pBayer_8bit != nullptr) {
-        DecoderBase::exportImage(
-           fileName,
-           m_pBayer_8bit->data(),
-           (2 * getWidth() * 2 * getHeight()),
-           header,
-           roi,
-           timestamp);
-    } else if(m_pBayer_16bit != nullptr) {
-        DecoderBase::exportImage(
-           fileName,
-           (std::uint8_t*)m_pBayer_16bit->data(),
-           2 * (2 * getWidth() * 2 * getHeight()),
-           header,
-           roi,
-           timestamp);
+    if(m_pGpuFrame == nullptr) {
+        throw std::runtime_error("No GPU decoding in flight.");
+    }
+    DecodeWorkspace_s& ws = getWorkspace();
+    std::size_t pixels    = m_gpuHeaderData.width * m_gpuHeaderData.height;
+    m_pBayer              = nullptr;
+
+    STATUS_t status;
+    if(m_gpuHeaderData.bpp == 8) {
+        std::uint8_t* out = ws.getBayer<std::uint8_t>(pixels);
+        status            = DecoderBase::finishBitstreamParallel_opencl(*m_pGpuFrame, out, pixels);
+        m_pBayer          = out;
+        m_bayerBytes      = pixels;
     } else {
+        std::uint16_t* out = ws.getBayer<std::uint16_t>(pixels);
+        status             = DecoderBase::finishBitstreamParallel_opencl(*m_pGpuFrame, out, pixels);
+        m_pBayer           = (const std::uint8_t*)out;
+        m_bayerBytes       = 2 * pixels;
+    }
+    m_pGpuFrame.reset();
+    if(status) {
+        m_pBayer = nullptr;
+        handleReturnValue(status);
+        throw std::runtime_error("Parallel decoding unsuccessful.");
+    }
+
+    return m_gpuHeaderData;
+}
+#endif
+
+void Decoder::exportBayerImage(const char* fileName, std::uint64_t header, std::uint64_t roi, std::uint64_t timestamp)
+{
+    if(m_pBayer == nullptr) {
         throw std::runtime_error("No bayer image data available.");
     }
+    STATUS_t status = DecoderBase::exportImage(fileName, m_pBayer, m_bayerBytes, header, roi, timestamp);
+    if(status) {
+        char msg[200];
+        sprintf(msg, "OMLS Error: %u:Error while exporting image: %s", status, fileName);
+        throw std::runtime_error(msg);
+    }
 }
 
 /**
@@ -340,6 +870,8 @@ void Decoder::toBayerGB(std::size_t lossyBits)
 // clang-format on
 #endif
     m_pBayer_16bit = std::make_unique<std::vector<std::uint16_t>>(std::forward<std::vector<std::uint16_t>>(bayerGB));
+    m_pBayer       = (const std::uint8_t*)m_pBayer_16bit->data();
+    m_bayerBytes   = 2 * m_pBayer_16bit->size();
 };
 
 /**
@@ -534,8 +1066,8 @@ std::size_t Decoder::decodeBitstream(
 }
 
 /**
- * Reads bitstream from fileName. Interprets first 4 bytes as image resolution.
- * The pointer to the bitstream data is then assigned to member m_pFileData.
+ * Maps bitstream from fileName to memory.
+ * The pointer to the mapped bitstream is then assigned to member m_pFileData.
 */
 void Decoder::importBitstream(const char* fileName)
 {
@@ -8,6 +8,7 @@
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <span>
 
 struct headerData_t {
     std::uint64_t timestamp;
@@ -32,15 +33,30 @@ class Decoder : public DecoderBase
     std::size_t m_N_threshold  = 0;
     std::size_t m_A_init       = 0;
 
-    std::unique_ptr<std::vector<std::uint8_t>> m_pFileData;
+    std::unique_ptr<MappedFile> m_pFileData;
     std::unique_ptr<sQuadChannelCS> m_pQuotients;
     std::unique_ptr<sQuadChannelCS> m_pRemainders;
     std::unique_ptr<sQuadChannelCS> m_pkValues;
     std::unique_ptr<sQuadChannelCS> m_pAbs;
     std::unique_ptr<sQuadChannelCS> m_pDpcm;
     std::unique_ptr<sQuadChannelCS> m_pFull;
-    std::unique_ptr<std::vector<std::uint8_t>> m_pBayer_8bit;
-    std::unique_ptr<std::vector<std::uint16_t>> m_pBayer_16bit;
+    std::unique_ptr<std::vector<std::uint16_t>> m_pBayer_16bit;   // output of decodeSequentially
+    std::vector<std::uint32_t> m_blockSizes;                      // block index of the image, empty without blocks
+    std::vector<std::uint32_t> m_blockRows;                       // first rows of blocks, empty for equal split
+    std::vector<AgorCheckpoint_s> m_checkpoints;                  // checkpoint index of the image, empty without it
+    std::vector<AgorCheckpoint_s> m_sidecarCheckpoints;           // image without index, see buildCheckpointIndex
+
+    DecodeWorkspace_s* m_pWorkspace = nullptr;   // not owned, see setWorkspace
+    std::unique_ptr<DecodeWorkspace_s> m_pOwnWorkspace;
+    const std::uint8_t* m_pBayer = nullptr;   // decoded image, in m_pBayer_16bit or in workspace
+    std::size_t m_bayerBytes     = 0;
+
+#ifdef INCLUDE_OPENCL
+    std::unique_ptr<OpenCLFrame_s> m_pGpuFrame;   // frame in flight between enqueueParallelGPU and finishParallelGPU
+    headerData_t m_gpuHeaderData;
+#endif
+
+    DecodeWorkspace_s& getWorkspace();
 
   public:
     Decoder();
@@ -52,9 +68,39 @@ class Decoder : public DecoderBase
        std::uint32_t N_threshold);
     Decoder(const char* fileName, std::uint32_t A_init, std::uint32_t N_threshold);
 
+    void setWorkspace(DecodeWorkspace_s* workspace);
+
+    static headerData_t readHeader(std::span<std::uint8_t const> bitStream);
+    static std::size_t readBlockIndex(
+       std::span<std::uint8_t const> bitStream,
+       const headerData_t& headerData,
+       std::vector<std::uint32_t>& blockSizes,
+       std::vector<std::uint32_t>& blockRows,
+       std::vector<AgorCheckpoint_s>& checkpoints);
+    static headerData_t decodeToBuffer(std::span<std::uint8_t const> bitStream, std::span<std::uint8_t> bayerGB);
+    static headerData_t decodeToBuffer(std::span<std::uint8_t const> bitStream, std::span<std::uint16_t> bayerGB);
+    static headerData_t decodeRowsToBuffer(
+       std::span<std::uint8_t const> bitStream,
+       std::size_t rowFirst,
+       std::size_t rows,
+       std::span<std::uint8_t> bayerGB);
+    static headerData_t decodeRowsToBuffer(
+       std::span<std::uint8_t const> bitStream,
+       std::size_t rowFirst,
+       std::size_t rows,
+       std::span<std::uint16_t> bayerGB);
+
     void decodeSequentially(std::size_t lossyBits);
-    headerData_t decodeParallel();
-    headerData_t decodeParallelGPU(std::vector<std::uint32_t>& blockSizes);
+    headerData_t decodeParallel(std::size_t nrOfThreads = 0);
+    headerData_t decodeRows(std::size_t rowFirst, std::size_t rows, std::size_t nrOfThreads = 0);
+    std::size_t buildCheckpointIndex(std::size_t rowsPerCheckpoint);
+    void exportCheckpointIndex(const char* fileName);
+    void importCheckpointIndex(const char* fileName);
+    headerData_t decodeParallelGPU(DecoderBase::blockKernels kernels = DecoderBase::blockKernels::four);
+#ifdef INCLUDE_OPENCL
+    void enqueueParallelGPU(std::size_t slot, DecoderBase::blockKernels kernels = DecoderBase::blockKernels::four);
+    headerData_t finishParallelGPU();
+#endif
     std::size_t decodeBitstream(
        Reader& reader,
        std::uint32_t N_threshold,
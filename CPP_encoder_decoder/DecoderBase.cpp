@@ -612,6 +612,129 @@ STATUS_t Reader::getTimestampAndCompressionInfoFromHeader(
     return BASE_SUCCESS;
 }
 
+STATUS_t Reader::getBlockIndex(
+   const std::uint8_t* bitStream,
+   std::size_t bitStreamSize,
+   std::uint8_t reserved,
+   std::vector<std::uint32_t>& blockSizes,
+   std::vector<std::uint32_t>& blockRows,
+   std::size_t& payloadOffset)
+{
+    const std::size_t headerSize = 24;
+
+    blockSizes.clear();
+    blockRows.clear();
+    payloadOffset = headerSize;
+    if((reserved & C_HEADER_FLAG_BLOCK_INDEX) == 0) {
+        return BASE_SUCCESS;
+    }
+
+    // uint32 nrOfBlocks, uint32 offset[nrOfBlocks + 1], with C_HEADER_FLAG_BLOCK_ROWS uint32 rowFirst[nrOfBlocks],
+    // padding to 16 bytes (see Encoder::pushBlockIndex)
+    std::uint32_t nrOfBlocks = 0;
+    if(bitStreamSize < headerSize + sizeof(nrOfBlocks)) {
+        return BASE_ERROR_BLOCK_SIZES_INVALID;
+    }
+    std::memcpy(&nrOfBlocks, bitStream + headerSize, sizeof(nrOfBlocks));
+
+    bool withRows        = (reserved & C_HEADER_FLAG_BLOCK_ROWS) != 0;
+    std::size_t indexEnd = headerSize + sizeof(std::uint32_t) * (2 + std::size_t(nrOfBlocks) * (withRows ? 2 : 1));
+    if(nrOfBlocks == 0 || indexEnd > bitStreamSize) {
+        return BASE_ERROR_BLOCK_SIZES_INVALID;
+    }
+    payloadOffset = (indexEnd + 15) / 16 * 16;
+
+    const std::uint8_t* pOffsets = bitStream + headerSize + sizeof(nrOfBlocks);
+    std::uint32_t offset         = 0;
+    std::memcpy(&offset, pOffsets, sizeof(offset));
+    if(offset != 0) {
+        return BASE_ERROR_BLOCK_SIZES_INVALID;
+    }
+    blockSizes.resize(nrOfBlocks);
+    for(std::size_t block = 0; block < nrOfBlocks; block++) {
+        std::uint32_t next = 0;
+        std::memcpy(&next, pOffsets + sizeof(next) * (block + 1), sizeof(next));
+        if(next < offset) {
+            return BASE_ERROR_BLOCK_SIZES_INVALID;
+        }
+        blockSizes[block] = next - offset;
+        offset            = next;
+    }
+    if(payloadOffset > bitStreamSize || offset > bitStreamSize - payloadOffset) {
+        return BASE_ERROR_BLOCK_SIZES_INVALID;
+    }
+
+    // first block starts at row 0, rows are not checked against height here
+    if(withRows) {
+        blockRows.resize(nrOfBlocks);
+        std::memcpy(
+           blockRows.data(),
+           pOffsets + sizeof(std::uint32_t) * (nrOfBlocks + 1),
+           sizeof(std::uint32_t) * nrOfBlocks);
+        if(blockRows[0] != 0) {
+            return BASE_ERROR_BLOCK_SIZES_INVALID;
+        }
+        for(std::size_t block = 1; block < nrOfBlocks; block++) {
+            if(blockRows[block] < blockRows[block - 1]) {
+                return BASE_ERROR_BLOCK_SIZES_INVALID;
+            }
+        }
+    }
+
+    return BASE_SUCCESS;
+}
+
+STATUS_t Reader::getCheckpointIndex(
+   const std::uint8_t* bitStream,
+   std::size_t bitStreamSize,
+   std::uint8_t reserved,
+   std::vector<AgorCheckpoint_s>& checkpoints,
+   std::size_t& payloadOffset)
+{
+    const std::size_t headerSize = 24;
+
+    checkpoints.clear();
+    payloadOffset = headerSize;
+    if((reserved & C_HEADER_FLAG_CHECKPOINT_INDEX) == 0) {
+        return BASE_SUCCESS;
+    }
+
+    // uint32 nrOfCheckpoints, uint32 reserved, AgorCheckpoint_s checkpoint[nrOfCheckpoints], padding to 16 bytes
+    // (see Encoder::pushCheckpointIndex)
+    std::uint32_t nrOfCheckpoints = 0;
+    if(bitStreamSize < headerSize + 2 * sizeof(nrOfCheckpoints)) {
+        return BASE_ERROR_BLOCK_SIZES_INVALID;
+    }
+    std::memcpy(&nrOfCheckpoints, bitStream + headerSize, sizeof(nrOfCheckpoints));
+
+    std::size_t indexEnd = headerSize + 2 * sizeof(std::uint32_t) + sizeof(AgorCheckpoint_s) * nrOfCheckpoints;
+    if(nrOfCheckpoints == 0 || indexEnd > bitStreamSize) {
+        return BASE_ERROR_BLOCK_SIZES_INVALID;
+    }
+    payloadOffset = (indexEnd + 15) / 16 * 16;
+    if(payloadOffset > bitStreamSize) {
+        return BASE_ERROR_BLOCK_SIZES_INVALID;
+    }
+
+    checkpoints.resize(nrOfCheckpoints);
+    std::memcpy(
+       checkpoints.data(),
+       bitStream + headerSize + 2 * sizeof(std::uint32_t),
+       sizeof(AgorCheckpoint_s) * nrOfCheckpoints);
+
+    // first checkpoint is the seed, the rest follow the stream
+    if(checkpoints[0].row != 0 || checkpoints[0].bitOffset != 0) {
+        return BASE_ERROR_BLOCK_SIZES_INVALID;
+    }
+    for(std::size_t i = 1; i < nrOfCheckpoints; i++) {
+        if(checkpoints[i].row <= checkpoints[i - 1].row || checkpoints[i].bitOffset < checkpoints[i - 1].bitOffset) {
+            return BASE_ERROR_BLOCK_SIZES_INVALID;
+        }
+    }
+
+    return BASE_SUCCESS;
+}
+
 std::uint64_t Reader::fetch8bytes(const std::uint8_t* bitStream, std::size_t byteOffset)
 {
     // std::cout << "Align of bitStream: " << alignof(decltype(bitStream)) << "-byte." << std::endl;
@@ -654,24 +777,16 @@ std::int16_t DecoderBase::fromAbs(std::uint16_t absValue)
 };
 
 /**
- * Reads bitstream from fileName. Interprets first 4 bytes as image resolution.
- * The pointer to the bitstream data is then assigned to member m_pFileData.
+ * Maps bitstream file fileName to memory. Nothing is copied, data is read directly from the mapping.
+ * The pointer to the mapped bitstream is then assigned to outData.
 */
-STATUS_t DecoderBase::importBitstream(const char* fileName, std::unique_ptr<std::vector<std::uint8_t>>& outData)
+STATUS_t DecoderBase::importBitstream(const char* fileName, std::unique_ptr<MappedFile>& outData)
 {
-    std::ifstream rf(fileName, std::ios::in | std::ios::binary);
-    if(!rf) {
+    auto pFile = std::make_unique<MappedFile>();
+    if(!pFile->open(fileName)) {
         return BASE_CANNOT_OPEN_INPUT_FILE;
     }
-
-    std::vector<std::uint8_t> inputBytes(
-       (std::istreambuf_iterator<char>(rf)),   //
-       (std::istreambuf_iterator<char>()));
-
-    outData =
-       std::move(std::make_unique<std::vector<std::uint8_t>>(std::forward<std::vector<std::uint8_t>>(inputBytes)));
-
-    rf.close();
+    outData = std::move(pFile);
 
     return BASE_SUCCESS;
 };
@@ -711,6 +826,9 @@ STATUS_t DecoderBase::handleReturnValue(STATUS_t status)
         case BASE_OPENCL_ERROR:
             std::cout << "DecoderBase: OpenCL error." << std::endl;
             break;
+        case BASE_ERROR_BLOCK_SIZES_INVALID:
+            std::cout << "DecoderBase: Block sizes do not match the bitstream." << std::endl;
+            break;
         default:
             std::cout << "DecoderBase: Unknown error." << std::endl;
             break;
@@ -1,9 +1,19 @@
 #pragma once
 
+#include "Channels.hpp"
+#include "ColorTransform.hpp"
+#include "MappedFile.hpp"
 #include "globalDefines.hpp"
+#include "helpers.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include <filesystem>
@@ -12,8 +22,10 @@
 
 #ifdef INCLUDE_OPENCL
 #    define CL_TARGET_OPENCL_VERSION 200
+#    include "OpenCL_sources/opencl_engine.hpp"
 #    include "OpenCL_sources/opencl_platforms.hpp"
 #    include <CL/cl.h>
+#    include <chrono>
 #    include <emmintrin.h>   // For SIMD operations
 #    include <immintrin.h>   // For SIMD operations
 
@@ -24,7 +36,6 @@
 #endif
 
 #define USE_SIMD
-// #define USE_LUT
 
 void createMissingDirectory(const char* folder_out);
 
@@ -50,17 +61,39 @@ enum
     BASE_ERROR_HEADER_NOT_ALIGNED     = 10,
     BASE_ERROR_HEADER_DATA_INVALID    = 11,
     BASE_OPENCL_ERROR                 = 12,
+    BASE_ERROR_BLOCK_SIZES_INVALID    = 13,
 };
 
-struct lut_data_t {
-    std::uint16_t quotient;
-    bool q_done;
-    std::uint16_t remainder;
-    std::uint8_t r_count;
-    std::uint16_t truncated_coding_value;
-    std::uint8_t t_count;
-    std::uint8_t offset_o;
-};
+/**
+ * Bit reversed value of each byte. Used to translate LSB first remainders to MSB first.
+ */
+constexpr std::array<std::uint8_t, 256> c_reversedByte = []() {
+    std::array<std::uint8_t, 256> table{};
+    for(std::size_t i = 0; i < 256; i++) {
+        std::uint8_t rev = 0;
+        for(std::size_t b = 0; b < 8; b++) {   //
+            rev |= ((i >> b) & 1) << (7 - b);
+        }
+        table[i] = rev;
+    }
+    return table;
+}();
+
+/**
+     * Translates to MSB first and shifts to get actual value. This function will not be needed if remainders are encoded in MSB first.
+     * Reverses byte by byte through c_reversedByte. validBits <= 32.
+     */
+inline std::uint32_t getMSBfirst(std::uint32_t lsb, std::size_t validBits)
+{
+    if(validBits == 0) {
+        return 0;
+    }
+    std::uint32_t msb = (std::uint32_t)c_reversedByte[lsb & 0xFF] << 24 |   //
+                        (std::uint32_t)c_reversedByte[(lsb >> 8) & 0xFF] << 16 |   //
+                        (std::uint32_t)c_reversedByte[(lsb >> 16) & 0xFF] << 8 |   //
+                        (std::uint32_t)c_reversedByte[(lsb >> 24) & 0xFF];
+    return msb >> (32 - validBits);
+}
 
 /*
 * Struct that manages bitstream reading. It keeps internal state of bitstream pointer.
@@ -75,6 +108,11 @@ struct Reader {
 
     alignas(16) std::uint32_t m_bits_single_bfr[32][4]  = {0};
     alignas(16) std::uint32_t m_bits_shifted_bfr[32][4] = {0};
+
+    /* Bit window: next unread bits are MSB aligned in m_window. */
+    std::uint64_t m_window       = 0;
+    std::size_t m_windowBits     = 0;   // number of valid bits in m_window
+    std::size_t m_windowNextByte = 0;   // next byte to be loaded into m_window
     /*
     * Reader constructor.
     */
@@ -179,6 +217,128 @@ struct Reader {
            nBits);
     };
 
+    /**
+     * Tops up bit window to at least 56 valid bits. Loads 8 bytes at once when available,
+     * bytes past the end of bitstream are read as 0.
+     */
+    void refillWindow()
+    {
+        if(m_windowNextByte + 8 <= m_bitStreamSize) {
+            std::uint64_t bytes;
+            memcpy(&bytes, m_bitStream + m_windowNextByte, sizeof(bytes));
+            m_window |= __builtin_bswap64(bytes) >> m_windowBits;   // first byte to MSB
+            std::size_t bytesLoaded = (63 - m_windowBits) >> 3;
+            m_windowNextByte += bytesLoaded;
+            m_windowBits += 8 * bytesLoaded;
+        } else {
+            while(m_windowBits < 56) {
+                std::uint64_t byte = m_windowNextByte < m_bitStreamSize ? m_bitStream[m_windowNextByte] : 0;
+                m_window |= byte << (56 - m_windowBits);
+                m_windowNextByte++;
+                m_windowBits += 8;
+            }
+        }
+    }
+
+    /**
+     * Starts reading bitstream through bit window from bit offset (default from first byte).
+     */
+    void loadWindow(std::size_t bitOffset = 0)
+    {
+        m_window         = 0;
+        m_windowBits     = 0;
+        m_windowNextByte = bitOffset / 8;
+        refillWindow();
+        skipBits(bitOffset % 8);
+    }
+
+    /**
+     * Drops n bits (n < 64) from bit window.
+     */
+    void skipBits(std::size_t n)
+    {
+        m_window <<= n;
+        m_windowBits -= n;
+    }
+
+    /**
+     * Fetches n bits (n <= 32), first bit in bitstream is MSB of returned value.
+     */
+    std::uint32_t fetchBits(std::size_t n)
+    {
+        if(n == 0) {
+            return 0;
+        }
+        refillWindow();
+        std::uint32_t bits = (std::uint32_t)(m_window >> (64 - n));
+        skipBits(n);
+        return bits;
+    }
+
+    /**
+     * Fetches n bits (n <= 32), first bit in bitstream is LSB of returned value.
+     */
+    std::uint32_t fetchBitsLSBfirst(std::size_t n)
+    {
+        return getMSBfirst(fetchBits(n), n);
+    }
+
+    /**
+     * Decodes unary code: counts '1' until '0' is found (and consumed) or until maxOnes '1' are read.
+     * Whole run within the bit window is counted with single count leading ones.
+     */
+    std::uint32_t fetchUnary(std::uint32_t maxOnes)
+    {
+        if(maxOnes == 0) {   // same as bit by bit decoding, one bit is always read
+            return fetchBits(1);
+        }
+        std::uint32_t ones = 0;
+        while(true) {
+            refillWindow();
+            std::uint32_t run = std::countl_one(m_window);
+            run               = run < m_windowBits ? run : m_windowBits;
+            if(ones + run >= maxOnes) {
+                skipBits(maxOnes - ones);
+                return maxOnes;
+            }
+            if(run < m_windowBits) {
+                skipBits(run + 1);   // run of '1' and delimiter '0'
+                return ones + run;
+            }
+            skipBits(run);
+            ones += run;
+        }
+    }
+
+    /**
+     * Decodes one AGOR code: unary quotient and LSB first remainder of k bits.
+     * unaryMaxWidth '1' indicate escape, absolute value is then coded in k_seed bits.
+     */
+    std::uint32_t fetchGolombRice(std::uint32_t k, std::uint32_t unaryMaxWidth, std::uint32_t k_seed)
+    {
+        std::uint32_t quotient = fetchUnary(unaryMaxWidth);
+        if(quotient >= unaryMaxWidth) {   //
+            return fetchBitsLSBfirst(k_seed);
+        }
+        return (quotient << k) + fetchBitsLSBfirst(k);
+    }
+
+    /**
+     * Number of bits consumed through bit window.
+     */
+    std::size_t getWindowBitOffset() const
+    {
+        return 8 * m_windowNextByte - m_windowBits;
+    }
+
+    /**
+     * True if bit window consumed more bits than there are in bitstream.
+     */
+    bool windowOverrun() const
+    {
+        return getWindowBitOffset() > 8 * m_bitStreamSize;
+    }
+
     /*
     * Gets timestamp from bitstream[0:7]
     */
@@ -220,31 +380,251 @@ struct Reader {
        std::uint8_t& bpp,
        std::uint8_t& lossyBits,
        std::uint8_t& reserved);
+
+    /*
+    * Gets block sizes from block index that follows the 24 byte header when @param reserved (from header) has
+    * C_HEADER_FLAG_BLOCK_INDEX set. Without it @param blockSizes is empty and payload starts right after the header.
+    * @param blockRows receives first row of quadruplets of each block when C_HEADER_FLAG_BLOCK_ROWS is set as well,
+    * it is empty for blocks of equal row count (see DecoderBase::getBlockRows).
+    * @param payloadOffset receives offset of the first block from bitStream[0].
+    */
+    static STATUS_t getBlockIndex(
+       const std::uint8_t* bitStream,
+       std::size_t bitStreamSize,
+       std::uint8_t reserved,
+       std::vector<std::uint32_t>& blockSizes,
+       std::vector<std::uint32_t>& blockRows,
+       std::size_t& payloadOffset);
+
+    /*
+    * Same as getBlockIndex, for checkpoint index of an image encoded as one AGOR stream
+    * (@param reserved has C_HEADER_FLAG_CHECKPOINT_INDEX set). Also reads sidecar checkpoint index (header and
+    * index without payload, see Decoder::exportCheckpointIndex), so rows and bit offsets of checkpoints are not
+    * checked against height and payload size here.
+    */
+    static STATUS_t getCheckpointIndex(
+       const std::uint8_t* bitStream,
+       std::size_t bitStreamSize,
+       std::uint8_t reserved,
+       std::vector<AgorCheckpoint_s>& checkpoints,
+       std::size_t& payloadOffset);
 };
 
 /**
-     * Translates to MSB first and shifts to get actual value. This function will not be needed if remainders are encoded in MSB first.
+     * Inverts byte order. Used to calculate how much time could be saved if byte order is changed on FPGA.
      */
-inline std::uint32_t getMSBfirst(std::uint32_t lsb, std::size_t validBits)
-{
-    std::uint32_t msb = 0;
-    for(std::size_t i = 0; i < validBits; i++) {
-        msb |= ((lsb >> i) & 1) << (validBits - 1 - i);
+inline void reverseByteOrder_16bytes(const std::uint8_t* bitStream, std::uint8_t* dest);
+
+/**
+ * Duration of decoding stages of the last decode call in microseconds, filled only when TIMING_EN is defined.
+ * Stages that a backend does not have stay 0.
+ */
+struct StageTimes_s {
+    std::uint64_t memBitstream    = 0;   // host to device transfer of bitstream or DPCM values
+    std::uint64_t parsing         = 0;
+    std::uint64_t firstColumn     = 0;
+    std::uint64_t dpcmToYccc      = 0;
+    std::uint64_t ycccToBayer     = 0;
+    std::uint64_t memDeviceToHost = 0;
+    std::uint64_t total           = 0;
+};
+
+/**
+ * Scratch and output memory of the decoders, reused from frame to frame, so that decoding a stream of frames
+ * does not allocate (and page fault) per frame. Buffers only grow: reserve() sizes them for the largest frame
+ * geometry, smaller frames use the beginning. Buffers of decoders that are not reserved up front grow on first use.
+ * One workspace must not be used by two decodes at the same time.
+ */
+struct DecodeWorkspace_s {
+    std::vector<std::int16_t> YCCC;        // interleaved YCCC (pseudo GPU, OpenCL host side)
+    std::vector<std::int16_t> YCCC_dpcm;   // interleaved DPCM (pseudo GPU, OpenCL host side)
+    sQuadChannelCS planes;                 // DPCM / YCCC planes (planar decoder)
+    std::vector<std::int16_t> rowsYCCC;    // one row of interleaved YCCC per thread (CPU decoders)
+    std::vector<std::uint8_t> bayer_8bit;
+    std::vector<std::uint16_t> bayer_16bit;
+
+    /**
+     * Sizes output and row buffers of the CPU decoders for @param width_a x @param height_a BayerCFA image.
+     * @param nrOfThreads that decode blocks concurrently, 0 for all hardware threads.
+     */
+    void reserve(std::size_t width_a, std::size_t height_a, std::uint8_t bpp, std::size_t nrOfThreads = 0)
+    {
+        if(nrOfThreads == 0) {
+            nrOfThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        getRows(nrOfThreads, width_a / 2);
+        if(bpp > 8) {
+            getBayer<std::uint16_t>(width_a * height_a);
+        } else {
+            getBayer<std::uint8_t>(width_a * height_a);
+        }
     }
-    // msb >>= (16 - validBits);
-    return msb;
-}
 
+    template<typename T>
+    T* getBayer(std::size_t size)
+    {
+        if constexpr(sizeof(T) == 1) {
+            return grow(bayer_8bit, size);
+        } else {
+            return grow(bayer_16bit, size);
+        }
+    }
+
+    /**
+     * Row buffers for @param nrOfThreads threads, thread t uses 4 * width elements from t * 4 * width.
+     */
+    std::int16_t* getRows(std::size_t nrOfThreads, std::size_t width)
+    {
+        return grow(rowsYCCC, nrOfThreads * 4 * width);
+    }
+
+    std::int16_t* getPlane(std::size_t ch, std::size_t length)
+    {
+        std::vector<std::int16_t>* plane[] = {&planes.Y, &planes.Cd, &planes.Cm, &planes.Co};
+        return grow(*plane[ch], length);
+    }
+
+    template<typename V>
+    static typename V::value_type* grow(V& buffer, std::size_t size)
+    {
+        if(buffer.size() < size) {
+            buffer.resize(size);
+        }
+        return buffer.data();
+    }
+};
+
+#ifdef INCLUDE_OPENCL
 /**
-     * Inverts byte order. Used to calculate how much time could be saved if byte order is changed on FPGA.
+ * Frame enqueued by DecoderBase::enqueueBitstreamParallel_opencl on an OpenCL slot, collected by
+ * finishBitstreamParallel_opencl. Events mark the stages on the slot's queue, they are profiled for stage times.
+ * release() (also on destruction) waits for the last enqueued stage, so the slot may be reused afterwards
+ * even when enqueueing failed half way.
+ */
+struct OpenCLFrame_s {
+    enum stage
+    {
+        bitStream,
+        bitstreamToDpcm,
+        firstColumnAllRows,
+        dpcmAcrossRows,
+        ycccToBayerGB,
+        bitstreamToBayerGB,   // fused kernel, replaces the four stages above
+        readBack,
+        count
+    };
+
+    std::size_t slot        = 0;
+    std::size_t nrOfBlocks  = 0;
+    std::size_t width       = 0;
+    std::size_t height      = 0;
+    std::size_t bayerGBSize = 0;   // bytes
+    std::size_t pixelBytes  = 1;   // 1 for 8 BPP, 2 above
+    std::chrono::steady_clock::time_point begin;
+    cl_event events[count] = {};
+
+    OpenCLFrame_s() = default;
+
+    OpenCLFrame_s(const OpenCLFrame_s&)            = delete;
+    OpenCLFrame_s& operator=(const OpenCLFrame_s&) = delete;
+    ~OpenCLFrame_s()
+    {
+        release();
+    }
+
+    /**
+     * Device execution time of stage @param s in microseconds, 0 when it was not profiled.
      */
-inline void reverseByteOrder_16bytes(const std::uint8_t* bitStream, std::uint8_t* dest);
+    std::uint64_t getDeviceTime(stage s) const
+    {
+        cl_ulong start = 0;
+        cl_ulong end   = 0;
+        if(events[s] == nullptr
+           || clGetEventProfilingInfo(events[s], CL_PROFILING_COMMAND_START, sizeof(start), &start, NULL) != CL_SUCCESS
+           || clGetEventProfilingInfo(events[s], CL_PROFILING_COMMAND_END, sizeof(end), &end, NULL) != CL_SUCCESS) {
+            return 0;
+        }
+        return (end - start) / 1000;
+    }
+
+    void release()
+    {
+        for(std::size_t s = count; s > 0; s--) {
+            if(events[s - 1] != nullptr) {
+                clWaitForEvents(1, &events[s - 1]);   // in-order queue: all earlier stages are done as well
+                break;
+            }
+        }
+        for(cl_event& event : events) {
+            if(event != nullptr) {
+                clReleaseEvent(event);
+                event = nullptr;
+            }
+        }
+    }
+};
+#endif
 
 struct DecoderBase {
 
+    /**
+     * Kernels of OpenCL decoding in blocks, selectable for A/B comparison.
+     */
+    enum class blockKernels
+    {
+        four,           // bitstream_to_dpcm, first_column_all_rows, dpcm_across_rows, yccc_to_bayergb_8bit/16bit
+        localParsing,   // same, bitstream parsed from local memory by bitstream_to_dpcm_local
+        fused           // bitstream_to_bayergb_8bit/16bit
+    };
+
+    // bytes of bitstream per work-item that bitstream_to_dpcm_local stages in local memory in one round
+    static constexpr std::size_t c_parsingWindowBytes = 256;
+
+    StageTimes_s m_stageTimes;
+
+    /**
+     * GPU and pseudo GPU decoders write std::uint8_t pixels for 8 BPP and std::uint16_t pixels above,
+     * same as the CPU decoders. Returns BASE_ERROR when @param bpp does not match output type T.
+     */
+    template<typename T>
+    static STATUS_t checkGpuOutputType(std::size_t bpp)
+    {
+        if(bpp > 8 * sizeof(std::uint16_t) || sizeof(T) != (bpp > 8 ? sizeof(std::uint16_t) : sizeof(std::uint8_t))) {
+            fprintf(
+               stdout,
+               "DecoderBase: %zu BPP image cannot be GPU decoded to %zu bit pixels.\n",
+               bpp,
+               8 * sizeof(T));
+            return BASE_ERROR;
+        }
+        return BASE_SUCCESS;
+    }
+
+    /**
+     * Rows of quadruplets of blocks: returns @param nrOfBlocks + 1 entries, block i holds rows [entry i, entry i + 1),
+     * last entry is @param height (rows of quadruplets). @param blockRows holds first row of each block from block
+     * index (C_HEADER_FLAG_BLOCK_ROWS). When it is empty, rows are split equally as in encodeParallelInBlocks,
+     * so the last block may be shorter and trailing blocks empty.
+     */
+    static std::vector<std::size_t> getBlockRows(
+       std::size_t height,
+       std::size_t nrOfBlocks,
+       const std::vector<std::uint32_t>& blockRows)
+    {
+        std::vector<std::size_t> rows(nrOfBlocks + 1, height);
+        std::size_t rowsPerBlock = (height + (nrOfBlocks - 1)) / nrOfBlocks;
+        for(std::size_t block = 0; block < nrOfBlocks; block++) {
+            rows[block] = std::min<std::size_t>(blockRows.empty() ? block * rowsPerBlock : blockRows[block], height);
+        }
+        return rows;
+    }
+
     /**
  * @param width_a and @param height_a are full image width and height.
  * BayerCFA image.
+ * @param rowYCCC_scratch holds one row of YCCC (4 * (width_a / 2) elements), allocated per call when nullptr.
+ * @param checkpoint when given, decoding starts at its bit offset of @param bitStream with its AGOR state instead of
+ * a seed pixel, and @param height_a rows are decoded (see decodeCheckpointRows_actual).
  */
     template<typename T>
     static STATUS_t decodeBitstreamParallel_actual(
@@ -256,23 +636,12 @@ struct DecoderBase {
        const std::uint8_t* bitStream,
        const std::size_t bitStreamSize,
        T* bayerGB,
-       std::size_t bayerGBSize)
+       std::size_t bayerGBSize,
+       std::int16_t* rowYCCC_scratch = nullptr,
+       const AgorCheckpoint_s* checkpoint = nullptr)
     {
-        std::uint32_t N_threshold = 8;
-        std::uint32_t A_init      = 32;
-
-        Reader reader{bitStream, bitStreamSize};
-
-        std::size_t width;
-        std::size_t height;
-        std::size_t lossyBits;
-        std::size_t unaryMaxWidth;
-        unaryMaxWidth        = unaryMaxWidth_a;
-        width                = width_a / 2;
-        height               = height_a / 2;
-        lossyBits            = lossyBits_a;
-        unaryMaxWidth        = unaryMaxWidth_a;
-        std::uint32_t k_seed = bpp_a + 3;   // max 12 BPP + 3 = 15
+        std::size_t width  = width_a / 2;
+        std::size_t height = height_a / 2;
 
         // Check if full decompressed image buffer is large enough. Multply by 4 because there are Gb,B,R & Gr channels.
         if(2 * width * 2 * height != bayerGBSize) {
@@ -285,7 +654,124 @@ struct DecoderBase {
             return BASE_OUTPUT_BUFFER_FALSE_SIZE;
         }
 
-        reader.loadFirstByte();
+        // YCCC of the current row, converted to BayerGB when row is complete
+        std::vector<std::int16_t> rowYCCC_local(rowYCCC_scratch == nullptr ? 4 * width : 0);
+        std::int16_t* rowYCCC = rowYCCC_scratch == nullptr ? rowYCCC_local.data() : rowYCCC_scratch;
+        auto rowToBayer = [&](std::size_t row) {
+            ColorTransform::YCCC_to_BayerGB_row(
+               rowYCCC,
+               bayerGB + row * width * 4,
+               bayerGB + row * width * 4 + 2 * width,
+               width,
+               lossyBits_a);
+        };
+
+        return DecoderBase::decodeAgorRows_actual(
+           width_a,
+           height_a,
+           unaryMaxWidth_a,
+           bpp_a,
+           bitStream,
+           bitStreamSize,
+           rowYCCC,
+           checkpoint,
+           rowToBayer);
+    }
+
+    /**
+ * Decodes bitstream to YCCC of the whole image, @param YCCC holds 4 * (width_a / 2) elements per row of quadruplets
+ * (width_a * height_a elements). Same stream as decodeBitstreamParallel_actual, without color transform.
+ * Image compressed in blocks is decoded block after block when @param blockSizes is not empty
+ * (@param bitStream is then the payload after block index), @param blockRows as in getBlockRows.
+ * Used to transcode compressed images.
+ */
+    static STATUS_t decodeToYCCC_actual(
+       std::size_t width_a,
+       std::size_t height_a,
+       std::size_t unaryMaxWidth_a,
+       std::size_t bpp_a,
+       const std::uint8_t* bitStream,
+       const std::size_t bitStreamSize,
+       std::int16_t* YCCC,
+       std::size_t YCCCSize,
+       const std::vector<std::uint32_t>& blockSizes,
+       const std::vector<std::uint32_t>& blockRows)
+    {
+        std::size_t width  = width_a / 2;
+        std::size_t height = height_a / 2;
+
+        if(4 * width * height != YCCCSize) {
+            fprintf(
+               stdout,
+               "DecoderBase: expected size of YCCC buffer: %zu, actual size: %zu\n",
+               4 * width * height,
+               YCCCSize);
+            return BASE_OUTPUT_BUFFER_FALSE_SIZE;
+        }
+
+        // Without blocks the whole payload is one block.
+        std::size_t nrOfBlocks               = std::max<std::size_t>(blockSizes.size(), 1);
+        std::vector<std::size_t> blockFirsts = DecoderBase::getBlockRows(height, nrOfBlocks, blockRows);
+        std::size_t blockOffset              = 0;
+        std::vector<std::int16_t> rowYCCC(4 * width);
+        for(std::size_t block = 0; block < nrOfBlocks && blockFirsts[block] < height; block++) {
+            std::size_t rowFirst  = blockFirsts[block];
+            std::size_t rows      = blockFirsts[block + 1] - rowFirst;
+            std::size_t blockSize = blockSizes.empty() ? bitStreamSize : blockSizes[block];
+            if(blockOffset + blockSize > bitStreamSize) {
+                return BASE_ERROR_BLOCK_SIZES_INVALID;
+            }
+
+            auto rowToYCCC = [&](std::size_t row) {
+                std::copy(rowYCCC.begin(), rowYCCC.end(), YCCC + 4 * width * (rowFirst + row));
+            };
+            STATUS_t status = DecoderBase::decodeAgorRows_actual(
+               width_a,
+               2 * rows,
+               unaryMaxWidth_a,
+               bpp_a,
+               bitStream + blockOffset,
+               blockSize,
+               rowYCCC.data(),
+               nullptr,
+               rowToYCCC);
+            if(status != BASE_SUCCESS) {
+                return status;
+            }
+            blockOffset += blockSize;
+        }
+        return BASE_SUCCESS;
+    }
+
+    /**
+ * AGOR decoding loop shared by decodeBitstreamParallel_actual and decodeToYCCC_actual.
+ * Quadruplets of a row are decoded to @param rowYCCC (4 * (width_a / 2) elements), then @param rowDone(row)
+ * is called. See decodeBitstreamParallel_actual for @param checkpoint.
+ */
+    template<typename F>
+    static STATUS_t decodeAgorRows_actual(
+       std::size_t width_a,
+       std::size_t height_a,
+       std::size_t unaryMaxWidth_a,
+       std::size_t bpp_a,
+       const std::uint8_t* bitStream,
+       const std::size_t bitStreamSize,
+       std::int16_t* rowYCCC,
+       const AgorCheckpoint_s* checkpoint,
+       F rowDone)
+    {
+        std::uint32_t N_threshold = 8;
+        std::uint32_t A_init      = 32;
+
+        Reader reader{bitStream, bitStreamSize};
+
+        std::size_t width;
+        std::size_t height;
+        std::size_t unaryMaxWidth;
+        width                = width_a / 2;
+        height               = height_a / 2;
+        unaryMaxWidth        = unaryMaxWidth_a;
+        std::uint32_t k_seed = bpp_a + 3;   // max 12 BPP + 3 = 15
 
         std::uint32_t A[]        = {A_init, A_init, A_init, A_init};
         std::uint32_t N          = N_START;
@@ -293,87 +779,53 @@ struct DecoderBase {
         std::int16_t YCCC_prev[] = {0, 0, 0, 0};
         std::int16_t YCCC_up[]   = {0, 0, 0, 0};
 
-        // 1.) decode 4 seed pixels
-        // Seed pixel
-        std::uint16_t posValue[] = {0, 0, 0, 0};
-        for(std::size_t ch = 0; ch < 4; ch++) {
-            // for(std::uint32_t n = k_SEED + 1; n > 0; n--) { // MSB first
-            //     std::uint32_t lastBit = fetchBit(reader);
-            //     posValue[ch]          = (posValue[ch] << 1) | lastBit;
-            // }
-            (void)reader.fetchBit();   // read delimiter
-            for(std::uint32_t n = 0; n < k_seed; n++) {   // LSB first
-                std::uint32_t lastBit = reader.fetchBit();
-                posValue[ch]          = posValue[ch] | ((std::uint16_t)lastBit << n);
-            };
-            YCCC[ch] = DecoderBase::fromAbs(posValue[ch]);
-        }
+        std::size_t idxFirst = 1;
+        if(checkpoint != nullptr) {
+            // continue the stream at the first quadruplet of a row, it is predicted from YCCC_up
+            reader.loadWindow(checkpoint->bitOffset);
+            memcpy(A, checkpoint->A, sizeof(A));
+            N = checkpoint->N;
+            memcpy(YCCC_up, checkpoint->YCCC_up, sizeof(YCCC_up));
+            idxFirst = 0;
+        } else {
+            reader.loadWindow();
+
+            // 1.) decode 4 seed pixels
+            // Seed pixel
+            std::uint16_t posValue[] = {0, 0, 0, 0};
+            for(std::size_t ch = 0; ch < 4; ch++) {
+                (void)reader.fetchBits(1);   // read delimiter
+                posValue[ch] = (std::uint16_t)reader.fetchBitsLSBfirst(k_seed);
+                YCCC[ch]     = DecoderBase::fromAbs(posValue[ch]);
+            }
 
-        for(std::size_t ch = 0; ch < 4; ch++) {   //
-            A[ch] += YCCC[ch] > 0 ? YCCC[ch] : -YCCC[ch];
-        }
+            for(std::size_t ch = 0; ch < 4; ch++) {   //
+                A[ch] += YCCC[ch] > 0 ? YCCC[ch] : -YCCC[ch];
+            }
 
-        RETURN_ON_FAILURE(DecoderBase::YCCC_to_BayerGB<T>(
-           YCCC[0],
-           YCCC[1],
-           YCCC[2],
-           YCCC[3],
-           bayerGB[0],
-           bayerGB[1],
-           bayerGB[2 * width],
-           bayerGB[2 * width + 1],
-           lossyBits))
+            memcpy(rowYCCC, YCCC, sizeof(YCCC));
+            if(width == 1) {
+                rowDone(0);
+            }
 
-        memcpy(YCCC_up, YCCC, sizeof(YCCC));
-        memcpy(YCCC_prev, YCCC, sizeof(YCCC));
+            memcpy(YCCC_up, YCCC, sizeof(YCCC));
+            memcpy(YCCC_prev, YCCC, sizeof(YCCC));
+        }
 
-        for(std::size_t idx = 1; idx < height * width; idx++) {
+        for(std::size_t idx = idxFirst; idx < height * width; idx++) {
 
             // 2.) AGOR
-            std::uint16_t quotient[]  = {0, 0, 0, 0};
-            std::uint16_t remainder[] = {0, 0, 0, 0};
-            std::uint16_t k[]         = {0, 0, 0, 0};
-            std::int16_t dpcm_curr[]  = {0, 0, 0, 0};
+            std::uint16_t k[]        = {0, 0, 0, 0};
+            std::int16_t dpcm_curr[] = {0, 0, 0, 0};
 
             for(std::size_t ch = 0; ch < 4; ch++) {
-                // for(std::size_t it = 0; it < 10; it++) {
-                for(std::size_t it = 0; it < (bpp_a + 2); it++) {
-                    if((N << k[ch]) < A[ch]) {
-                        k[ch] = k[ch] + 1;
-                    } else {
-                        k[ch] = k[ch];
-                    }
+                while(k[ch] < (bpp_a + 2) && (N << k[ch]) < A[ch]) {   // (N << k) grows, stop at first k that fits
+                    k[ch]++;
                 }
-                std::uint32_t lastBit;
-
-                std::uint16_t absVal = 0;
-                do {   // decode quotient: unary coding
-                    lastBit = reader.fetchBit();
-                    if(lastBit == 1) {   //
-                        quotient[ch]++;
-                    }
-                } while(lastBit == 1 && quotient[ch] < unaryMaxWidth);
 
                 /* m_unaryMaxWidth * '1' -> indicates binary coding of positive value */
-                if(quotient[ch] >= unaryMaxWidth) {
-                    // for(std::uint32_t n = 0; n < k_MAX; n++) {   //decode remainder
-                    for(std::uint32_t n = 0; n < k_seed; n++) {   //decode remainder
-                        lastBit = reader.fetchBit();
-                        absVal  = absVal | ((std::uint16_t)lastBit << n); /* LSB first */
-                        // absVal  = (absVal << 1) | lastBit; /* MSB first*/
-                    };
-                    // absVal = reader.fetchBits_buffered(k_seed);
-
-                } else {
-                    for(std::uint32_t n = 0; n < k[ch]; n++) {   //decode remainder
-                        lastBit       = reader.fetchBit();
-                        remainder[ch] = remainder[ch] | ((std::uint16_t)lastBit << n); /* LSB first*/
-                        // remainder[ch] = (remainder[ch] << 1) | lastBit; /* MSB first*/
-                    };
-                    // remainder[ch] = reader.fetchBits_buffered(k[ch]);
-                    absVal = (quotient[ch] << k[ch]) + remainder[ch];
-                }
-                dpcm_curr[ch] = DecoderBase::fromAbs(absVal);
+                std::uint16_t absVal = (std::uint16_t)reader.fetchGolombRice(k[ch], unaryMaxWidth, k_seed);
+                dpcm_curr[ch]        = DecoderBase::fromAbs(absVal);
 
                 A[ch] += dpcm_curr[ch] > 0 ? dpcm_curr[ch] : -dpcm_curr[ch];
                 YCCC[ch] = YCCC_prev[ch] + dpcm_curr[ch];
@@ -384,17 +836,279 @@ struct DecoderBase {
                 YCCC_prev[ch] = YCCC[ch];   // save pixel to be used as a reference for the next pixel
             }
 
-            std::size_t idxGB = (idx / width) * width * 4 + 2 * (idx % width);
-            RETURN_ON_FAILURE(DecoderBase::YCCC_to_BayerGB<T>(
-                                 YCCC[0],   //
-                                 YCCC[1],
-                                 YCCC[2],
-                                 YCCC[3],
-                                 bayerGB[idxGB],
-                                 bayerGB[idxGB + 1],
-                                 bayerGB[idxGB + 2 * width],
-                                 bayerGB[idxGB + 2 * width + 1],
-                                 lossyBits);)
+            memcpy(&rowYCCC[4 * (idx % width)], YCCC, sizeof(YCCC));
+            if(idx % width == width - 1) {
+                rowDone(idx / width);
+            }
+            N += 1;
+            if(N >= N_threshold) {
+                N >>= 1;
+                A[0] >>= 1;
+                A[1] >>= 1;
+                A[2] >>= 1;
+                A[3] >>= 1;
+            }
+            A[0] = A[0] < A_MIN ? A_MIN : A[0];
+            A[1] = A[1] < A_MIN ? A_MIN : A[1];
+            A[2] = A[2] < A_MIN ? A_MIN : A[2];
+            A[3] = A[3] < A_MIN ? A_MIN : A[3];
+        }
+        if(reader.windowOverrun()) {
+            std::cout << "All bytes have been read." << std::endl;
+            return BASE_ERROR_ALL_BYTES_ALREADY_READ;
+        }
+        return BASE_SUCCESS;
+    }
+
+    /**
+ * Decodes bitstream compressed in blocks (*_blocks.bin) on multiple CPU threads.
+ * Every block starts with a seed pixel and fresh A, N, so it is decoded by decodeBitstreamParallel_actual
+ * directly into its own row range of @param bayerGB. Threads pick blocks from a shared counter.
+ * @param width_a and @param height_a are full image width and height.
+ * @param bitStream points to the first block (payload after block index), @param blockSizes holds block sizes in bytes.
+ * @param blockRows holds first rows of the blocks, empty for equal split (see getBlockRows).
+ * @param nrOfThreads number of worker threads, 0 for all hardware threads.
+ * @param workspace provides row buffers of the threads, they are allocated per block when nullptr.
+ */
+    template<typename T>
+    static STATUS_t decodeBlocksParallel_actual(
+       std::size_t width_a,
+       std::size_t height_a,
+       std::size_t lossyBits_a,
+       std::size_t unaryMaxWidth_a,
+       std::size_t bpp_a,
+       const std::uint8_t* bitStream,
+       const std::size_t bitStreamSize,
+       T* bayerGB,
+       std::size_t bayerGBSize,
+       const std::vector<std::uint32_t>& blockSizes,
+       const std::vector<std::uint32_t>& blockRows,
+       std::size_t nrOfThreads = 0,
+       DecodeWorkspace_s* workspace = nullptr)
+    {
+        return DecoderBase::decodeBlockRows_actual<T>(
+           width_a,
+           height_a,
+           lossyBits_a,
+           unaryMaxWidth_a,
+           bpp_a,
+           bitStream,
+           bitStreamSize,
+           bayerGB,
+           bayerGBSize,
+           blockSizes,
+           blockRows,
+           0,
+           height_a,
+           nrOfThreads,
+           workspace);
+    }
+
+    /**
+ * Decodes BayerCFA rows [@param rowFirst_a, @param rowFirst_a + @param rows_a) of bitstream compressed in blocks
+ * to @param bayerGB of width_a x rows_a. Only blocks that intersect the rows are decoded and decoding of a block
+ * stops at the last requested row. Block that starts above the rows is decoded to a temporary buffer and copied.
+ * Row range must be even (whole quadruplet rows). Other parameters are the same as in decodeBlocksParallel_actual.
+ */
+    template<typename T>
+    static STATUS_t decodeBlockRows_actual(
+       std::size_t width_a,
+       std::size_t height_a,
+       std::size_t lossyBits_a,
+       std::size_t unaryMaxWidth_a,
+       std::size_t bpp_a,
+       const std::uint8_t* bitStream,
+       const std::size_t bitStreamSize,
+       T* bayerGB,
+       std::size_t bayerGBSize,
+       const std::vector<std::uint32_t>& blockSizes,
+       const std::vector<std::uint32_t>& blockRows,
+       std::size_t rowFirst_a,
+       std::size_t rows_a,
+       std::size_t nrOfThreads = 0,
+       DecodeWorkspace_s* workspace = nullptr)
+    {
+        std::size_t nrOfBlocks = blockSizes.size();
+        std::size_t height     = height_a / 2;
+
+        if(nrOfBlocks == 0) {
+            return BASE_ERROR;
+        }
+
+        // rows of quadruplets, trailing blocks may be empty
+        std::vector<std::size_t> blockFirsts = DecoderBase::getBlockRows(height, nrOfBlocks, blockRows);
+
+        std::vector<std::size_t> blockOffsets(nrOfBlocks + 1, 0);
+        for(std::size_t i = 0; i < nrOfBlocks; i++) {
+            blockOffsets[i + 1] = blockOffsets[i] + blockSizes[i];
+        }
+        if(blockOffsets[nrOfBlocks] > bitStreamSize) {
+            fprintf(
+               stdout,
+               "DecoderBase: sum of block sizes %zu B exceeds bitstream size %zu B\n",
+               blockOffsets[nrOfBlocks],
+               bitStreamSize);
+            return BASE_ERROR_BLOCK_SIZES_INVALID;
+        }
+
+        return DecoderBase::decodeSegmentRows_actual<T>(
+           width_a,
+           height_a,
+           bpp_a,
+           bayerGB,
+           bayerGBSize,
+           blockFirsts,
+           rowFirst_a,
+           rows_a,
+           nrOfThreads,
+           workspace,
+           [&](std::size_t block, std::size_t rowsInBlock, T* out, std::int16_t* rowYCCC) {
+               return DecoderBase::decodeBitstreamParallel_actual<T>(
+                  width_a,
+                  2 * rowsInBlock,
+                  lossyBits_a,
+                  unaryMaxWidth_a,
+                  bpp_a,
+                  bitStream + blockOffsets[block],
+                  blockSizes[block],
+                  out,
+                  2 * rowsInBlock * width_a,
+                  rowYCCC);
+           });
+    }
+
+    /**
+ * Decodes bitstream encoded as one AGOR stream with checkpoint index on multiple CPU threads.
+ * Each thread starts at a checkpoint with its AGOR state and decodes rows up to the next checkpoint, so the output
+ * is the same as of the serial decode of the whole stream.
+ * @param bitStream points to the payload (after checkpoint index), checkpoint bit offsets are relative to it.
+ * Row range and other parameters are the same as in decodeBlockRows_actual.
+ */
+    template<typename T>
+    static STATUS_t decodeCheckpointRows_actual(
+       std::size_t width_a,
+       std::size_t height_a,
+       std::size_t lossyBits_a,
+       std::size_t unaryMaxWidth_a,
+       std::size_t bpp_a,
+       const std::uint8_t* bitStream,
+       const std::size_t bitStreamSize,
+       T* bayerGB,
+       std::size_t bayerGBSize,
+       const std::vector<AgorCheckpoint_s>& checkpoints,
+       std::size_t rowFirst_a,
+       std::size_t rows_a,
+       std::size_t nrOfThreads = 0,
+       DecodeWorkspace_s* workspace = nullptr)
+    {
+        std::size_t nrOfCheckpoints = checkpoints.size();
+
+        if(nrOfCheckpoints == 0 || checkpoints[0].row != 0 || checkpoints.back().row >= height_a / 2
+           || checkpoints.back().bitOffset > 8 * std::uint64_t(bitStreamSize)) {
+            return BASE_ERROR_BLOCK_SIZES_INVALID;
+        }
+
+        std::vector<std::size_t> checkpointRows(nrOfCheckpoints + 1, height_a / 2);
+        for(std::size_t i = 0; i < nrOfCheckpoints; i++) {
+            checkpointRows[i] = checkpoints[i].row;
+        }
+
+        return DecoderBase::decodeSegmentRows_actual<T>(
+           width_a,
+           height_a,
+           bpp_a,
+           bayerGB,
+           bayerGBSize,
+           checkpointRows,
+           rowFirst_a,
+           rows_a,
+           nrOfThreads,
+           workspace,
+           [&](std::size_t segment, std::size_t rowsInSegment, T* out, std::int16_t* rowYCCC) {
+               return DecoderBase::decodeBitstreamParallel_actual<T>(
+                  width_a,
+                  2 * rowsInSegment,
+                  lossyBits_a,
+                  unaryMaxWidth_a,
+                  bpp_a,
+                  bitStream,
+                  bitStreamSize,
+                  out,
+                  2 * rowsInSegment * width_a,
+                  rowYCCC,
+                  segment == 0 ? nullptr : &checkpoints[segment]);   // first checkpoint is the seed
+           });
+    }
+
+    /**
+ * Parses bitstream encoded as one AGOR stream without blocks once, without color transform or output, and records
+ * AGOR state at the start of every @param rowsPerCheckpoint rows of quadruplets to @param checkpoints (first one is
+ * the seed at row 0). Checkpoints are the same as written by Encoder::encodeToBufferWithCheckpoints, so the stream
+ * can then be decoded by decodeCheckpointRows_actual.
+ * @param width_a and @param height_a are full image width and height.
+ */
+    static STATUS_t buildCheckpoints_actual(
+       std::size_t width_a,
+       std::size_t height_a,
+       std::size_t unaryMaxWidth_a,
+       std::size_t bpp_a,
+       const std::uint8_t* bitStream,
+       const std::size_t bitStreamSize,
+       std::size_t rowsPerCheckpoint,
+       std::vector<AgorCheckpoint_s>& checkpoints)
+    {
+        std::uint32_t N_threshold = 8;
+        std::uint32_t A_init      = 32;
+
+        std::size_t width    = width_a / 2;
+        std::size_t height   = height_a / 2;
+        std::uint32_t k_seed = bpp_a + 3;
+
+        checkpoints.clear();
+        if(rowsPerCheckpoint == 0 || width == 0 || height == 0) {
+            return BASE_ERROR;
+        }
+
+        Reader reader{bitStream, bitStreamSize};
+        reader.loadWindow();
+
+        std::uint32_t A[]      = {A_init, A_init, A_init, A_init};
+        std::uint32_t N        = N_START;
+        std::int16_t YCCC_up[] = {0, 0, 0, 0};
+
+        // seed pixel, only the first column is reconstructed, the rest of the row is just parsed
+        for(std::size_t ch = 0; ch < 4; ch++) {
+            (void)reader.fetchBits(1);   // read delimiter
+            YCCC_up[ch] = DecoderBase::fromAbs((std::uint16_t)reader.fetchBitsLSBfirst(k_seed));
+            A[ch] += YCCC_up[ch] > 0 ? YCCC_up[ch] : -YCCC_up[ch];
+        }
+        checkpoints.emplace_back();
+
+        for(std::size_t idx = 1; idx < height * width; idx++) {
+            if(idx % width == 0 && (idx / width) % rowsPerCheckpoint == 0) {
+                AgorCheckpoint_s checkpoint;
+                checkpoint.bitOffset = reader.getWindowBitOffset();
+                checkpoint.N         = N;
+                checkpoint.row       = idx / width;
+                memcpy(checkpoint.A, A, sizeof(checkpoint.A));
+                memcpy(checkpoint.YCCC_up, YCCC_up, sizeof(checkpoint.YCCC_up));
+                checkpoints.push_back(checkpoint);
+            }
+
+            for(std::size_t ch = 0; ch < 4; ch++) {
+                std::uint16_t k = 0;
+                while(k < (bpp_a + 2) && (N << k) < A[ch]) {
+                    k++;
+                }
+                std::uint16_t absVal = (std::uint16_t)reader.fetchGolombRice(k, unaryMaxWidth_a, k_seed);
+                std::int16_t dpcm    = DecoderBase::fromAbs(absVal);
+
+                A[ch] += dpcm > 0 ? dpcm : -dpcm;
+                if(idx % width == 0) {
+                    YCCC_up[ch] = YCCC_up[ch] + dpcm;
+                }
+            }
+
             N += 1;
             if(N >= N_threshold) {
                 N >>= 1;
@@ -408,13 +1122,133 @@ struct DecoderBase {
             A[2] = A[2] < A_MIN ? A_MIN : A[2];
             A[3] = A[3] < A_MIN ? A_MIN : A[3];
         }
+        if(reader.windowOverrun()) {
+            std::cout << "All bytes have been read." << std::endl;
+            checkpoints.clear();
+            return BASE_ERROR_ALL_BYTES_ALREADY_READ;
+        }
         return BASE_SUCCESS;
     }
 
+    /**
+ * Common part of decodeBlockRows_actual and decodeCheckpointRows_actual. Image is split into segments of rows of
+ * quadruplets [@param segmentRows[i], segmentRows[i + 1]), last entry is height_a / 2 (empty segments are allowed).
+ * Segments that intersect the requested rows are decoded on @param nrOfThreads threads by
+ * @param decodeSegment(segment, rowsInSegment, out, rowYCCC_scratch), rows below the range are not decoded.
+ * Segment that starts above the rows is decoded to a temporary buffer and copied.
+ */
+    template<typename T, typename F>
+    static STATUS_t decodeSegmentRows_actual(
+       std::size_t width_a,
+       std::size_t height_a,
+       std::size_t bpp_a,
+       T* bayerGB,
+       std::size_t bayerGBSize,
+       const std::vector<std::size_t>& segmentRows,
+       std::size_t rowFirst_a,
+       std::size_t rows_a,
+       std::size_t nrOfThreads,
+       DecodeWorkspace_s* workspace,
+       F decodeSegment)
+    {
+        if(rowFirst_a % 2 != 0 || rows_a % 2 != 0 || rows_a == 0 || rows_a > height_a ||
+           rowFirst_a > height_a - rows_a) {
+            fprintf(
+               stdout,
+               "DecoderBase: invalid row range %zu + %zu of %zu rows (must be even)\n",
+               rowFirst_a,
+               rows_a,
+               height_a);
+            return BASE_ERROR;
+        }
+        if(width_a * rows_a != bayerGBSize) {
+            fprintf(
+               stdout,
+               "DecoderBase: expected size of output buffer: %zu, actual size: %zu (bpp: %zu)\n",
+               width_a * rows_a,
+               bayerGBSize,
+               bpp_a);
+            return BASE_OUTPUT_BUFFER_FALSE_SIZE;
+        }
+
+        // requested rows of quadruplets and segments that hold them
+        std::size_t rowBegin     = rowFirst_a / 2;
+        std::size_t rowEnd       = (rowFirst_a + rows_a) / 2;
+        std::size_t segmentFirst = std::upper_bound(segmentRows.begin(), segmentRows.end(), rowBegin)
+                                 - segmentRows.begin() - 1;
+        std::size_t segmentEnd = std::lower_bound(segmentRows.begin(), segmentRows.end(), rowEnd) - segmentRows.begin();
+
+        if(nrOfThreads == 0) {
+            nrOfThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        nrOfThreads = std::min(nrOfThreads, segmentEnd - segmentFirst);
+
+        std::int16_t* rowsYCCC = workspace == nullptr ? nullptr : workspace->getRows(nrOfThreads, width_a / 2);
+
+        std::atomic<std::size_t> nextSegment{segmentFirst};
+        std::atomic<STATUS_t> status{BASE_SUCCESS};
+
+        auto worker = [&](std::size_t thread) {
+            for(std::size_t segment = nextSegment++; segment < segmentEnd; segment = nextSegment++) {
+                if(status.load(std::memory_order_relaxed) != BASE_SUCCESS) {
+                    return;
+                }
+                std::size_t rowFirst      = segmentRows[segment];
+                std::size_t copyFirst     = std::max(rowFirst, rowBegin);
+                std::size_t copyEnd       = std::min(segmentRows[segment + 1], rowEnd);
+                std::size_t rowsInSegment = copyEnd - rowFirst;   // rows below the range are not decoded
+
+                std::vector<T> partialSegment;
+                T* out;
+                if(copyFirst == rowFirst) {
+                    out = bayerGB + 2 * (rowFirst - rowBegin) * width_a;
+                } else {
+                    partialSegment.resize(2 * rowsInSegment * width_a);
+                    out = partialSegment.data();
+                }
+
+                STATUS_t segmentStatus = decodeSegment(
+                   segment,
+                   rowsInSegment,
+                   out,
+                   rowsYCCC == nullptr ? nullptr : rowsYCCC + thread * 4 * (width_a / 2));
+                if(segmentStatus != BASE_SUCCESS) {
+                    STATUS_t expected = BASE_SUCCESS;
+                    status.compare_exchange_strong(expected, segmentStatus);
+                    fprintf(
+                       stdout,
+                       "DecoderBase: decoding of segment %zu failed with status %u\n",
+                       segment,
+                       segmentStatus);
+                } else if(!partialSegment.empty()) {
+                    std::copy(
+                       partialSegment.begin() + 2 * (copyFirst - rowFirst) * width_a,
+                       partialSegment.end(),
+                       bayerGB + 2 * (copyFirst - rowBegin) * width_a);
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(nrOfThreads - 1);
+        for(std::size_t t = 1; t < nrOfThreads; t++) {
+            threads.emplace_back(worker, t);
+        }
+        worker(0);   // calling thread works as well
+        for(auto& thread : threads) {
+            thread.join();
+        }
+
+        return status.load();
+    }
+
     /**
  * @param width_a and @param height_a are related to channel size which is one half of the actual BayerCFA image.
  * BayerCFA image.
+ * @param workspace holds YCCC and DPCM buffers, they are allocated per call when nullptr.
+ * T is std::uint8_t for 8 BPP and std::uint16_t for more (see checkGpuOutputType).
  */
+    template<typename T>
     STATUS_t decodeBitstreamParallel_pseudo_gpu(
        std::size_t width_a,
        std::size_t height_a,
@@ -423,17 +1257,14 @@ struct DecoderBase {
        std::size_t bpp_a,
        const std::uint8_t* bitStream,
        const std::size_t bitStreamSize,
-       std::uint8_t* bayerGB,
-       std::size_t bayerGBSize)
+       T* bayerGB,
+       std::size_t bayerGBSize,
+       DecodeWorkspace_s* workspace = nullptr)
     {
 
         printf("Pseudo GPU decoding started!\n");
 
-        if(bpp_a != 8) {
-            fprintf(
-               stdout,
-               "DecoderBase: bpp is not 8, but %zu. GPU decompression implemented only for 8 BPP.\n",
-               bpp_a);
+        if(checkGpuOutputType<T>(bpp_a)) {
             return BASE_ERROR;
         }
 
@@ -475,15 +1306,15 @@ struct DecoderBase {
         // std::uint32_t N   = N_START;
         std::uint32_t N = N_START - 1;
         //std::int16_t YCCC[]      = {0, 0, 0, 0};
-        std::vector<std::int16_t> YCCC(4 * (height * width));
-        std::vector<std::int16_t> YCCC_prev_debug(4 * (height * width));
+        DecodeWorkspace_s localWorkspace;
+        DecodeWorkspace_s& ws   = workspace == nullptr ? localWorkspace : *workspace;
+        std::int16_t* YCCC      = DecodeWorkspace_s::grow(ws.YCCC, 4 * (height * width));
+        std::int16_t* YCCC_dpcm = DecodeWorkspace_s::grow(ws.YCCC_dpcm, 4 * (height * width));
         // std::int16_t YCCC_prev[] = {0, 0, 0, 0};
         //std::int16_t YCCC_up[]   = {0, 0, 0, 0};
 
         // 1.) decode 4 seed pixels
 
-        std::vector<std::int16_t> YCCC_dpcm(4 * (height * width));
-
         // 2.) AGOR
         // this will cause switch to unary coding and will decode seed pixel appropriatelly
         std::uint16_t quotient[] = {
@@ -588,14 +1419,10 @@ struct DecoderBase {
                 width);   // 4*width (because there are 4 channels of each width (which is half of the actual image width))
             auto idx_prev = (row - 1) * (4 * width);
 
-            YCCC_prev_debug[idx_curr + 0] = YCCC[idx_prev + 0];
-            YCCC_prev_debug[idx_curr + 1] = YCCC[idx_prev + 1];
-            YCCC_prev_debug[idx_curr + 2] = YCCC[idx_prev + 2];
-            YCCC_prev_debug[idx_curr + 3] = YCCC[idx_prev + 3];
-            YCCC[idx_curr + 0]            = YCCC[idx_prev + 0] + YCCC_dpcm[idx_curr + 0];
-            YCCC[idx_curr + 1]            = YCCC[idx_prev + 1] + YCCC_dpcm[idx_curr + 1];
-            YCCC[idx_curr + 2]            = YCCC[idx_prev + 2] + YCCC_dpcm[idx_curr + 2];
-            YCCC[idx_curr + 3]            = YCCC[idx_prev + 3] + YCCC_dpcm[idx_curr + 3];
+            YCCC[idx_curr + 0] = YCCC[idx_prev + 0] + YCCC_dpcm[idx_curr + 0];
+            YCCC[idx_curr + 1] = YCCC[idx_prev + 1] + YCCC_dpcm[idx_curr + 1];
+            YCCC[idx_curr + 2] = YCCC[idx_prev + 2] + YCCC_dpcm[idx_curr + 2];
+            YCCC[idx_curr + 3] = YCCC[idx_prev + 3] + YCCC_dpcm[idx_curr + 3];
         }
 
 #ifdef TIMING_EN
@@ -607,16 +1434,12 @@ struct DecoderBase {
 
             auto row_offset = row * (4 * width);
             for(std::size_t col = 1; col < width; col++) {
-                auto idx_curr                 = row_offset + 4 * col;
-                auto idx_prev                 = row_offset + 4 * (col - 1);
-                YCCC_prev_debug[idx_curr + 0] = YCCC[idx_prev + 0];
-                YCCC_prev_debug[idx_curr + 1] = YCCC[idx_prev + 1];
-                YCCC_prev_debug[idx_curr + 2] = YCCC[idx_prev + 2];
-                YCCC_prev_debug[idx_curr + 3] = YCCC[idx_prev + 3];
-                YCCC[idx_curr + 0]            = YCCC[idx_prev + 0] + YCCC_dpcm[idx_curr + 0];
-                YCCC[idx_curr + 1]            = YCCC[idx_prev + 1] + YCCC_dpcm[idx_curr + 1];
-                YCCC[idx_curr + 2]            = YCCC[idx_prev + 2] + YCCC_dpcm[idx_curr + 2];
-                YCCC[idx_curr + 3]            = YCCC[idx_prev + 3] + YCCC_dpcm[idx_curr + 3];
+                auto idx_curr      = row_offset + 4 * col;
+                auto idx_prev      = row_offset + 4 * (col - 1);
+                YCCC[idx_curr + 0] = YCCC[idx_prev + 0] + YCCC_dpcm[idx_curr + 0];
+                YCCC[idx_curr + 1] = YCCC[idx_prev + 1] + YCCC_dpcm[idx_curr + 1];
+                YCCC[idx_curr + 2] = YCCC[idx_prev + 2] + YCCC_dpcm[idx_curr + 2];
+                YCCC[idx_curr + 3] = YCCC[idx_prev + 3] + YCCC_dpcm[idx_curr + 3];
             }
         }
 
@@ -625,20 +1448,13 @@ struct DecoderBase {
         std::chrono::steady_clock::time_point begin_yccc_to_bayer = std::chrono::steady_clock::now();
 #endif
 
-        // TODO: OPPORTUNITY: can be done in parallel
-        // for(std::size_t idx = 1; idx < height * width; idx++) {
-        for(std::size_t idx = 0; idx < height * width; idx++) {
-            std::size_t idxGB = (idx / width) * width * 4 + 2 * (idx % width);
-            RETURN_ON_FAILURE(DecoderBase::YCCC_to_BayerGB(
-                                 YCCC[4 * idx + 0],   //
-                                 YCCC[4 * idx + 1],
-                                 YCCC[4 * idx + 2],
-                                 YCCC[4 * idx + 3],
-                                 bayerGB[idxGB],
-                                 bayerGB[idxGB + 1],
-                                 bayerGB[idxGB + 2 * width],
-                                 bayerGB[idxGB + 2 * width + 1],
-                                 lossyBits);)
+        for(std::size_t row = 0; row < height; row++) {
+            ColorTransform::YCCC_to_BayerGB_row(
+               &YCCC[row * 4 * width],
+               bayerGB + row * width * 4,
+               bayerGB + row * width * 4 + 2 * width,
+               width,
+               lossyBits);
         }
 
         // char outputFile[200];
@@ -699,34 +1515,37 @@ struct DecoderBase {
                   << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]" << std::endl;
         std::cout << "Pseudo GPU decoding done!" << std::endl;
         std::cout << std::endl;
+
+        m_stageTimes = StageTimes_s{};
+        m_stageTimes.parsing =
+           std::chrono::duration_cast<std::chrono::microseconds>(end_parsing - begin_parsing).count();
+        m_stageTimes.firstColumn =
+           std::chrono::duration_cast<std::chrono::microseconds>(begin_dpcm_to_yccc - end_parsing).count();
+        m_stageTimes.dpcmToYccc =
+           std::chrono::duration_cast<std::chrono::microseconds>(end_dpcm_to_yccc - begin_dpcm_to_yccc).count();
+        m_stageTimes.ycccToBayer =
+           std::chrono::duration_cast<std::chrono::microseconds>(end_yccc_to_bayer - begin_yccc_to_bayer).count();
+        m_stageTimes.total = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
 #endif
 
         printf("Pseudo GPU decoding done!\n");
         return BASE_SUCCESS;
     }
 
-#ifdef INCLUDE_OPENCL
-
-    std::size_t getLocalWorkSize(std::size_t globalWorkSize)
-    {
-        std::size_t localWorkSize = 1;
-        while((localWorkSize < globalWorkSize) && (localWorkSize < 256)) {
-            localWorkSize <<= 1;
-        }
-        return localWorkSize;
-    }
-
-    void getLocalAndGlobalWorkSize(std::size_t requiredThreads, std::size_t& localWorkSize, std::size_t& globalWorkSize)
-    {
-        localWorkSize  = getLocalWorkSize(requiredThreads);
-        globalWorkSize = ((requiredThreads + localWorkSize - 1) / localWorkSize) * localWorkSize;
-    }
-
     /**
- * @param width_a and @param height_a are related to channel size which is one half of the actual BayerCFA image.
- * BayerCFA image.
+ * Same bitstream as decodeBitstreamParallel_actual, decoded in the stages of the GPU decoder
+ * on CPU threads, with DPCM and YCCC kept in separate Y, Cd, Cm, Co planes (sQuadChannelCS):
+ * 1.) parse all DPCM values (serial),
+ * 2.) reconstruct first column of each plane (serial, height elements),
+ * 3.) rows are independent then: each thread takes next row, reconstructs it with SIMD prefix sum
+ *     and converts it to BayerGB while it is still in cache.
+ * Stage 3 is reported as DPCM to YCCC, YCCC to Bayer is part of it.
+ * @param width_a and @param height_a are full image width and height.
+ * @param nrOfThreads number of threads for stage 3, 0 for all hardware threads.
+ * @param workspace holds the planes, they are allocated per call when nullptr.
  */
-    STATUS_t decodeBitstreamParallel_opencl(
+    template<typename T>
+    STATUS_t decodeBitstreamParallel_planar(
        std::size_t width_a,
        std::size_t height_a,
        std::size_t lossyBits_a,
@@ -734,37 +1553,22 @@ struct DecoderBase {
        std::size_t bpp_a,
        const std::uint8_t* bitStream,
        const std::size_t bitStreamSize,
-       std::uint8_t* bayerGB,
+       T* bayerGB,
        std::size_t bayerGBSize,
-       std::vector<std::uint32_t>& blockSizes)
+       std::size_t nrOfThreads = 0,
+       DecodeWorkspace_s* workspace = nullptr)
     {
-
-        std::size_t nrOfBlocks = blockSizes.size();
-        printf("OpenCL decoding in blocks started!\n");
-        identify_platforms();
-
-        if(bpp_a != 8) {
-            fprintf(
-               stdout,
-               "DecoderBase: bpp is not 8, but %zu. GPU decompression implemented only for 8 BPP.\n",
-               bpp_a);
-            return BASE_ERROR;
-        }
+        std::uint32_t N_threshold = 8;
+        std::uint32_t A_init      = 32;
 
         Reader reader{bitStream, bitStreamSize};
 
-        std::size_t width;
-        std::size_t height;
-        std::size_t lossyBits;
-        std::size_t unaryMaxWidth;
-        unaryMaxWidth        = unaryMaxWidth_a;
-        width                = width_a / 2;   // half size of the actual BayerCFA image
-        height               = height_a / 2;
-        lossyBits            = lossyBits_a;
-        unaryMaxWidth        = unaryMaxWidth_a;
-        std::uint32_t k_seed = bpp_a + 3;   // max 12 BPP + 3 = 15
+        std::size_t width         = width_a / 2;
+        std::size_t height        = height_a / 2;
+        std::size_t lossyBits     = lossyBits_a;
+        std::size_t unaryMaxWidth = unaryMaxWidth_a;
+        std::uint32_t k_seed      = bpp_a + 3;   // max 12 BPP + 3 = 15
 
-        // Check if full decompressed image buffer is large enough. Multply by 4 because there are Gb,B,R & Gr channels.
         if(2 * width * 2 * height != bayerGBSize) {
             fprintf(
                stdout,
@@ -775,336 +1579,580 @@ struct DecoderBase {
             return BASE_OUTPUT_BUFFER_FALSE_SIZE;
         }
 
-        // reader.loadFirstByte();
-        reader.loadFirstFourBytes();
+#ifdef TIMING_EN
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+#endif
 
-        //***************************************************
-        // STEP 1: Discover and initialize the platforms
-        //***************************************************
+        // DPCM values, reconstructed to YCCC in place
+        DecodeWorkspace_s localWorkspace;
+        DecodeWorkspace_s& ws = workspace == nullptr ? localWorkspace : *workspace;
+        std::int16_t* plane[] = {
+           ws.getPlane(0, height * width),
+           ws.getPlane(1, height * width),
+           ws.getPlane(2, height * width),
+           ws.getPlane(3, height * width)};
 
-        cl_int status = 0;
-        cl_uint numPlatforms;
-        // cl_platform_id* platforms = NULL;
+        reader.loadWindow();
 
-        // Get platforms
-        status = clGetPlatformIDs(0, NULL, &numPlatforms);
-        if(evaluateReturnStatus(status)) {
-            return BASE_OPENCL_ERROR;
-        };
-        auto platforms = new cl_platform_id[numPlatforms];
-        status         = clGetPlatformIDs(numPlatforms, platforms, NULL);
-        evaluateReturnStatus(status);
+        // 1.) parse, seed pixel is DPCM against 0
+        std::uint32_t A[] = {A_init, A_init, A_init, A_init};
+        std::uint32_t N   = N_START;
+        for(std::size_t ch = 0; ch < 4; ch++) {
+            (void)reader.fetchBits(1);   // read delimiter
+            plane[ch][0] = DecoderBase::fromAbs((std::uint16_t)reader.fetchBitsLSBfirst(k_seed));
+            A[ch] += plane[ch][0] > 0 ? plane[ch][0] : -plane[ch][0];
+        }
 
-        //***************************************************
-        // STEP 2: Discover and initialize the devices
-        //***************************************************
+        for(std::size_t idx = 1; idx < height * width; idx++) {
+            for(std::size_t ch = 0; ch < 4; ch++) {
+                std::uint16_t k = 0;
+                while(k < (bpp_a + 2) && (N << k) < A[ch]) {
+                    k++;
+                }
+                std::uint16_t absVal = (std::uint16_t)reader.fetchGolombRice(k, unaryMaxWidth, k_seed);
+                std::int16_t dpcm    = DecoderBase::fromAbs(absVal);
+                plane[ch][idx]       = dpcm;
+                A[ch] += dpcm > 0 ? dpcm : -dpcm;
+            }
+            N += 1;
+            if(N >= N_threshold) {
+                N >>= 1;
+                A[0] >>= 1;
+                A[1] >>= 1;
+                A[2] >>= 1;
+                A[3] >>= 1;
+            }
+            A[0] = A[0] < A_MIN ? A_MIN : A[0];
+            A[1] = A[1] < A_MIN ? A_MIN : A[1];
+            A[2] = A[2] < A_MIN ? A_MIN : A[2];
+            A[3] = A[3] < A_MIN ? A_MIN : A[3];
+        }
+        if(reader.windowOverrun()) {
+            std::cout << "All bytes have been read." << std::endl;
+            return BASE_ERROR_ALL_BYTES_ALREADY_READ;
+        }
 
-        cl_uint numDevices;
-        // Use clGetDeviceIDs() to retrieve the number of
-        // devices present
-        status = clGetDeviceIDs(platforms[0], CL_DEVICE_TYPE_GPU, 0, NULL, &numDevices);
-        evaluateReturnStatus(status);
-        auto devices = new cl_device_id[numDevices];
-
-        // Fill in devices with clGetDeviceIDs()
-        status = clGetDeviceIDs(platforms[0], CL_DEVICE_TYPE_GPU, numDevices, devices, NULL);
-        evaluateReturnStatus(status);
+#ifdef TIMING_EN
+        std::chrono::steady_clock::time_point end_parsing = std::chrono::steady_clock::now();
+#endif
 
-        //***************************************************
-        // STEP 3: Create a context
-        //***************************************************
+        // 2.) first column, pixel one row up is the reference
+        for(std::size_t row = 1; row < height; row++) {
+            for(std::size_t ch = 0; ch < 4; ch++) {
+                plane[ch][row * width] += plane[ch][(row - 1) * width];
+            }
+        }
 
-        cl_context context = NULL;
-        // Create a context using clCreateContext() and
-        // associate it with the devices
-        context = clCreateContext(NULL, numDevices, devices, NULL, NULL, &status);
-        evaluateReturnStatus(status);
+#ifdef TIMING_EN
+        std::chrono::steady_clock::time_point begin_dpcm_to_yccc = std::chrono::steady_clock::now();
+#endif
 
-        //***************************************************
-        // STEP 4: Create a command queue
-        //***************************************************
-        cl_command_queue cmdQueue;
-        // Create a command queue using clCreateCommandQueue(),
-        // and associate it with the device you want to execute
-        // on
-        // Command queue properties
-        cl_queue_properties queue_properties[] = {CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0};
-        cmdQueue = clCreateCommandQueueWithProperties(context, devices[0], queue_properties, &status);
-        evaluateReturnStatus(status);
+        // 3.) rows
+        if(nrOfThreads == 0) {
+            nrOfThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        nrOfThreads = std::max<std::size_t>(1, std::min(nrOfThreads, height));
+
+        std::atomic<std::size_t> nextRow{0};
+        auto worker = [&]() {
+            for(std::size_t row = nextRow++; row < height; row = nextRow++) {
+                const std::int16_t* rowYCCC[4];
+                for(std::size_t ch = 0; ch < 4; ch++) {
+                    ColorTransform::inclusivePrefixSum_row(plane[ch] + row * width, width);
+                    rowYCCC[ch] = plane[ch] + row * width;
+                }
+                ColorTransform::YCCC_to_BayerGB_row(
+                   rowYCCC,
+                   bayerGB + row * width * 4,
+                   bayerGB + row * width * 4 + 2 * width,
+                   width,
+                   lossyBits);
+            }
+        };
 
-        //***************************************************
-        // STEP 5: Create device buffers
-        //***************************************************
+        std::vector<std::thread> threads;
+        threads.reserve(nrOfThreads - 1);
+        for(std::size_t t = 1; t < nrOfThreads; t++) {
+            threads.emplace_back(worker);
+        }
+        worker();   // calling thread works as well
+        for(auto& thread : threads) {
+            thread.join();
+        }
 
-        cl_mem YCCC_d;   // output buffer
-        cl_mem YCCC_dpcm_d;   // input buffer
-        cl_mem bayerGB_d;   // output buffer
-        size_t iNumElements         = 4 * (height * width);
-        size_t datasize_YCCC_d      = sizeof(std::int16_t) * iNumElements;
-        size_t datasize_YCCC_dpcm_d = sizeof(std::int16_t) * iNumElements;
-        size_t datasize_BayerGB     = 2 * width * 2 * height;
-        YCCC_d                      = clCreateBuffer(context, CL_MEM_READ_WRITE, datasize_YCCC_d, NULL, &status);
-        evaluateReturnStatus(status);
-        YCCC_dpcm_d = clCreateBuffer(context, CL_MEM_READ_WRITE, datasize_YCCC_dpcm_d, NULL, &status);
-        evaluateReturnStatus(status);
-        bayerGB_d = clCreateBuffer(context, CL_MEM_WRITE_ONLY, datasize_BayerGB, NULL, &status);
+#ifdef TIMING_EN
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
 
-        //***************************************************
-        // STEP 6: Create a program object for the context
-        //***************************************************
+        m_stageTimes = StageTimes_s{};
+        m_stageTimes.parsing = std::chrono::duration_cast<std::chrono::microseconds>(end_parsing - begin).count();
+        m_stageTimes.firstColumn =
+           std::chrono::duration_cast<std::chrono::microseconds>(begin_dpcm_to_yccc - end_parsing).count();
+        m_stageTimes.dpcmToYccc =
+           std::chrono::duration_cast<std::chrono::microseconds>(end - begin_dpcm_to_yccc).count();
+        m_stageTimes.total = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+#endif
 
-        FILE* programHandle;   // File that contains kernel functions
-        size_t programSize;
-        char* programBuffer;
-        cl_program cpProgram;
+        return BASE_SUCCESS;
+    }
 
-        std::filesystem::path cwd = std::filesystem::current_path();
-        std::cout << "Current working dir: " << cwd << std::endl;
+#ifdef INCLUDE_OPENCL
 
-        // Construct the full path to the kernel file
-        std::filesystem::path kernelFilePath = cwd / "OpenCL_sources/kernels.cl";
-        std::cout << "Kernel file will be searched for at: " << kernelFilePath << std::endl;
+    std::size_t getLocalWorkSize(std::size_t globalWorkSize)
+    {
+        std::size_t localWorkSize = 1;
+        while((localWorkSize < globalWorkSize) && (localWorkSize < 256)) {
+            localWorkSize <<= 1;
+        }
+        return localWorkSize;
+    }
 
-        programHandle = fopen(kernelFilePath.string().c_str(), "rb");
-        // programHandle = fopen("OpenCL_sources/kernel_dpcm_row.cl", "r");
-        fseek(programHandle, 0, SEEK_END);
-        programSize = ftell(programHandle);
-        rewind(programHandle);
+    void getLocalAndGlobalWorkSize(std::size_t requiredThreads, std::size_t& localWorkSize, std::size_t& globalWorkSize)
+    {
+        localWorkSize  = getLocalWorkSize(requiredThreads);
+        globalWorkSize = ((requiredThreads + localWorkSize - 1) / localWorkSize) * localWorkSize;
+    }
 
-        printf("Program size = %llu B \n", programSize);
+    /**
+ * Work sizes for kernel @param kernel with one work-item per block, each needing @param localBytesPerItem of local
+ * memory. Work-group is halved until it fits into the device local memory and until there is at least one work-group
+ * per compute unit, so that blocks are spread over the whole device.
+ */
+    void getBlockLocalAndGlobalWorkSize(
+       std::size_t nrOfBlocks,
+       cl_kernel kernel,
+       std::size_t localBytesPerItem,
+       std::size_t& localWorkSize,
+       std::size_t& globalWorkSize)
+    {
+        OpenCLEngine& engine = OpenCLEngine::getInstance();
+
+        std::size_t kernelWorkGroupSize = engine.getMaxWorkGroupSize();
+        clGetKernelWorkGroupInfo(
+           kernel,
+           engine.getDevice(),
+           CL_KERNEL_WORK_GROUP_SIZE,
+           sizeof(kernelWorkGroupSize),
+           &kernelWorkGroupSize,
+           NULL);
 
-        // 6 b: read the kernel source into the buffer programBuffer
-        //      add null-termination-required by clCreateProgramWithSource
-        programBuffer = (char*)malloc(programSize + 1);
+        localWorkSize = getLocalWorkSize(nrOfBlocks);
+        while(localWorkSize > 1
+              && (localWorkSize > kernelWorkGroupSize || localWorkSize * localBytesPerItem > engine.getLocalMemSize()
+                  || (nrOfBlocks + localWorkSize - 1) / localWorkSize < engine.getComputeUnits())) {
+            localWorkSize >>= 1;
+        }
+        globalWorkSize = ((nrOfBlocks + localWorkSize - 1) / localWorkSize) * localWorkSize;
+    }
 
-        programBuffer[programSize] = '\0';   // add null-termination
-        fread(programBuffer, sizeof(char), programSize, programHandle);
-        fclose(programHandle);
+    /**
+ * @param width_a and @param height_a are related to channel size which is one half of the actual BayerCFA image.
+ * BayerCFA image.
+ * Synchronous decode on OpenCL slot 0: enqueueBitstreamParallel_opencl followed by finishBitstreamParallel_opencl.
+ * T is std::uint8_t for 8 BPP and std::uint16_t for more (see checkGpuOutputType).
+ */
+    template<typename T>
+    STATUS_t decodeBitstreamParallel_opencl(
+       std::size_t width_a,
+       std::size_t height_a,
+       std::size_t lossyBits_a,
+       std::size_t unaryMaxWidth_a,
+       std::size_t bpp_a,
+       const std::uint8_t* bitStream,
+       const std::size_t bitStreamSize,
+       T* bayerGB,
+       std::size_t bayerGBSize,
+       std::vector<std::uint32_t>& blockSizes,
+       const std::vector<std::uint32_t>& blockRows,
+       blockKernels kernels = blockKernels::four)
+    {
+        if(checkGpuOutputType<T>(bpp_a)) {
+            return BASE_ERROR;
+        }
 
-        // 6 c: Create the program from the source
-        //
-        cpProgram = clCreateProgramWithSource(context, 1, (const char**)&programBuffer, &programSize, &status);
-        evaluateReturnStatus(status);
-        free(programBuffer);
-        //***************************************************
-        // STEP 7: Build the program
-        //***************************************************
+        OpenCLFrame_s frame;
+        STATUS_t status = enqueueBitstreamParallel_opencl(
+           frame,
+           0,
+           width_a,
+           height_a,
+           lossyBits_a,
+           unaryMaxWidth_a,
+           bpp_a,
+           bitStream,
+           bitStreamSize,
+           bayerGBSize,
+           blockSizes,
+           blockRows,
+           kernels);
+        if(status) {
+            return status;
+        }
+        return finishBitstreamParallel_opencl(frame, bayerGB, bayerGBSize);
+    }
 
-        status = clBuildProgram(cpProgram, 0, NULL, NULL, NULL, NULL);
+    /**
+ * Enqueues decoding of one frame in blocks on OpenCL slot @param slot and returns without waiting for the device.
+ * Bitstream is copied to the slot's pinned staging buffer and uploaded with one transfer, kernels and readback
+ * follow on the slot's in-order queue, so no stage waits for the host. Frames on different slots overlap.
+ * Result is collected with finishBitstreamParallel_opencl, which must be called before the slot is used again.
+ * @param width_a and @param height_a are full image width and height.
+ * @param kernels selects the four kernel pipeline with YCCC and YCCC_dpcm device buffers (bitstream parsed from global
+ * or local memory) or the single kernel bitstream_to_bayergb_8bit, which keeps YCCC and DPCM values in private memory.
+ * Images of more than 8 BPP are decoded with the 16 bit variants of the output kernels to std::uint16_t pixels.
+ * @param blockRows holds first rows of the blocks, empty for equal split (see getBlockRows). Blocks are uploaded
+ * back to back as they are in the file, kernels find them through a prefix sum of block sizes (blockOffsets).
+ */
+    STATUS_t enqueueBitstreamParallel_opencl(
+       OpenCLFrame_s& frame,
+       std::size_t slot,
+       std::size_t width_a,
+       std::size_t height_a,
+       std::size_t lossyBits_a,
+       std::size_t unaryMaxWidth_a,
+       std::size_t bpp_a,
+       const std::uint8_t* bitStream,
+       const std::size_t bitStreamSize,
+       std::size_t bayerGBSize,
+       std::vector<std::uint32_t>& blockSizes,
+       const std::vector<std::uint32_t>& blockRows,
+       blockKernels kernels = blockKernels::four)
+    {
 
-        if(status != CL_SUCCESS) {
-            size_t len;
+        std::size_t nrOfBlocks = blockSizes.size();
+        bool fused             = kernels == blockKernels::fused;
+        printf("OpenCL decoding in blocks started (slot %zu%s)!\n", slot, fused ? ", fused kernel" : "");
 
-            printf("Error: Failed to build program executable!\n");
-            // Firstly, get the length of the error message:
-            status = clGetProgramBuildInfo(cpProgram, devices[0], CL_PROGRAM_BUILD_LOG, 0, NULL, &len);
-            evaluateReturnStatus(status);
+        if(bpp_a > 8 * sizeof(std::uint16_t)) {
+            fprintf(stdout, "DecoderBase: GPU decompression implemented for up to 16 BPP, not %zu.\n", bpp_a);
+            return BASE_ERROR;
+        }
+        if(nrOfBlocks == 0) {
+            return BASE_ERROR;
+        }
 
-            // allocate enough memory to store the error message:
-            char* err_buffer = (char*)malloc(len * sizeof(char));
+        std::size_t width;
+        std::size_t height;
+        std::size_t lossyBits;
+        std::size_t unaryMaxWidth;
+        width                = width_a / 2;   // half size of the actual BayerCFA image
+        height               = height_a / 2;
+        lossyBits            = lossyBits_a;
+        unaryMaxWidth        = unaryMaxWidth_a;
+        std::uint32_t k_seed = bpp_a + 3;   // max 12 BPP + 3 = 15
 
-            // Secondly, copy the error message into buffer
-            status =
-               clGetProgramBuildInfo(cpProgram, devices[0], CL_PROGRAM_BUILD_LOG, len * sizeof(char), err_buffer, NULL);
-            evaluateReturnStatus(status);
-            printf("%s\n", err_buffer);
-            free(err_buffer);
-            exit(1);
+        // Check if full decompressed image buffer is large enough. Multply by 4 because there are Gb,B,R & Gr channels.
+        if(2 * width * 2 * height != bayerGBSize) {
+            fprintf(
+               stdout,
+               "DecoderBase: expected size of output buffer: %zu, actual size: %zu (bpp: %zu)\n",
+               2 * width * 2 * height,
+               bayerGBSize,
+               bpp_a);
+            return BASE_OUTPUT_BUFFER_FALSE_SIZE;
         }
 
         //***************************************************
-        // STEP 8: Create and compile the kernel
+        // STEP 1-8: Device, context, queue, program and kernels are set up once per process by OpenCLEngine
         //***************************************************
 
-        cl_kernel ckBitstreamToDpcm;
-        ckBitstreamToDpcm = clCreateKernel(cpProgram, "bitstream_to_dpcm", &status);
-        evaluateReturnStatus(status);
-
-        cl_kernel ckFirstColumnAllRows;
-        ckFirstColumnAllRows = clCreateKernel(cpProgram, "first_column_all_rows", &status);
-        evaluateReturnStatus(status);
+        OpenCLEngine& engine = OpenCLEngine::getInstance();
+        cl_int status        = engine.init();
+        if(status == CL_SUCCESS) {
+            status = engine.setNrOfSlots(slot + 1);
+        }
+        if(status != CL_SUCCESS) {
+            return BASE_OPENCL_ERROR;
+        }
+        cl_command_queue cmdQueue = engine.getQueue(slot);
 
-        cl_kernel ckDpcmAcrossRows;
-        ckDpcmAcrossRows = clCreateKernel(cpProgram, "dpcm_across_rows", &status);
-        evaluateReturnStatus(status);
+        // Device buffers are pooled by the engine, they are reallocated only when a larger image arrives
+        size_t iNumElements         = 4 * (height * width);
+        size_t datasize_YCCC_d      = sizeof(std::int16_t) * iNumElements;
+        size_t datasize_YCCC_dpcm_d = sizeof(std::int16_t) * iNumElements;
+        size_t pixelBytes           = bpp_a > 8 ? sizeof(std::uint16_t) : sizeof(std::uint8_t);
+        size_t datasize_BayerGB     = pixelBytes * 2 * width * 2 * height;
+
+        cl_mem YCCC_d      = nullptr;
+        cl_mem YCCC_dpcm_d = nullptr;
+        if(!fused) {   // fused kernel needs neither
+            YCCC_d = engine.getBuffer(OpenCLEngine::buffer::YCCC, datasize_YCCC_d, CL_MEM_READ_WRITE, slot);
+            YCCC_dpcm_d =
+               engine.getBuffer(OpenCLEngine::buffer::YCCC_dpcm, datasize_YCCC_dpcm_d, CL_MEM_READ_WRITE, slot);
+            if(YCCC_d == nullptr || YCCC_dpcm_d == nullptr) {
+                return BASE_OPENCL_ERROR;
+            }
+        }
+        cl_mem bayerGB_d = engine.getBuffer(OpenCLEngine::buffer::bayerGB, datasize_BayerGB, CL_MEM_WRITE_ONLY, slot);
+        void* bayerGB_pinned = engine.getPinnedBuffer(OpenCLEngine::pinned::bayerGB, datasize_BayerGB, slot);
+        if(bayerGB_d == nullptr || bayerGB_pinned == nullptr) {
+            return BASE_OPENCL_ERROR;
+        }
 
-        cl_kernel ckYcccToBayerGB;
-        ckYcccToBayerGB = clCreateKernel(cpProgram, "yccc_to_bayergb_8bit", &status);
-        evaluateReturnStatus(status);
+        cl_kernel ckBitstreamToDpcm    = engine.getKernel(OpenCLEngine::kernel::bitstreamToDpcm);
+        cl_kernel ckFirstColumnAllRows = engine.getKernel(OpenCLEngine::kernel::firstColumnAllRows);
+        cl_kernel ckDpcmAcrossRows     = engine.getKernel(OpenCLEngine::kernel::dpcmAcrossRows);
+        cl_kernel ckYcccToBayerGB      = engine.getKernel(
+           pixelBytes == 1 ? OpenCLEngine::kernel::ycccToBayerGB_8bit : OpenCLEngine::kernel::ycccToBayerGB_16bit);
+        cl_kernel ckBitstreamToBayerGB = engine.getKernel(
+           pixelBytes == 1 ? OpenCLEngine::kernel::bitstreamToBayerGB_8bit
+                           : OpenCLEngine::kernel::bitstreamToBayerGB_16bit);
+        cl_kernel ckBitstreamToDpcmLocal = engine.getKernel(OpenCLEngine::kernel::bitstreamToDpcm_local);
 
         //***************************************************
         // OPENCL NOW READY TO EXECUTE
         //***************************************************
 
-#    ifdef TIMING_EN
-        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
-#    endif
+        frame.slot        = slot;
+        frame.nrOfBlocks  = nrOfBlocks;
+        frame.width       = width;
+        frame.height      = height;
+        frame.bayerGBSize = datasize_BayerGB;
+        frame.pixelBytes  = pixelBytes;
+        frame.begin       = std::chrono::steady_clock::now();
 
         //***************************************************
         // STEP 8a: Set up kernel for bitstream to DPCM decoding
         //***************************************************
 
-        //         // write bitstream to global GPU memory
-        //         status = clEnqueueWriteBuffer(cmdQueue, bitStream_d, CL_FALSE, 0, bitStreamSize, bitStream, 0, NULL, NULL);
-        //         evaluateReturnStatus(status);
-
-        std::size_t rowsPerBlock          = (height + (nrOfBlocks - 1)) / nrOfBlocks;
-        std::size_t blockSize_quadruplets = rowsPerBlock * width;
-        std::size_t blockSize_pixels      = 4 * blockSize_quadruplets;
+        // rows of quadruplets of each block, trailing blocks may be empty
+        std::vector<std::size_t> blockFirsts = getBlockRows(height, nrOfBlocks, blockRows);
 
-        std::uint32_t pixel_current = 0;
-        std::uint32_t pixel_all     = 2 * width * 2 * height;
+        // one work-item per block; global size is rounded up, padding work-items see 0 pixels and return at once
+        size_t blocks_globalSize;
+        size_t blocks_localSize;
+        getLocalAndGlobalWorkSize(nrOfBlocks, blocks_localSize, blocks_globalSize);
 
-        std::vector<std::uint32_t> pixelsInBlock(nrOfBlocks, 0);
+        std::vector<std::uint32_t> pixelsInBlock(blocks_globalSize, 0);
+        std::vector<std::uint32_t> rowFirstInBlock(blocks_globalSize, 0);
+        std::vector<cl_ulong> blockOffsets(blocks_globalSize, 0);
 
+        std::size_t payloadSize = 0;
         for(std::size_t i = 0; i < nrOfBlocks; i++) {
-            pixel_current += blockSize_pixels;
-            if(pixel_current >= pixel_all) {
-                pixelsInBlock[i] = blockSize_pixels - pixel_current % pixel_all;
-                break;
-            } else {
-                pixelsInBlock[i] = blockSize_pixels;
-            }
+            pixelsInBlock[i]   = 4 * width * (blockFirsts[i + 1] - blockFirsts[i]);
+            rowFirstInBlock[i] = blockFirsts[i];
+            blockOffsets[i]    = payloadSize;
+            payloadSize += blockSizes[i];
+        }
+        // padding work-items see an empty block at the end of the payload
+        std::fill(blockOffsets.begin() + nrOfBlocks, blockOffsets.end(), payloadSize);
+        if(payloadSize > bitStreamSize) {
+            return BASE_ERROR;
         }
 
-        // printf("OpenCL: Block size in pixels:\n");
-        // for(std::size_t i = 0; i < nrOfBlocks; i++) {
-        //     printf("Block %zu: %u\n", i, pixelsInBlock[i]);
-        // }
-
-        std::uint64_t groupByteOffset = (((iNumElements / nrOfBlocks * (unaryMaxWidth + k_seed) + 7) / 8));
-        std::uint64_t requiredSpace   = groupByteOffset * nrOfBlocks;
+        // tables follow the payload in the pinned buffer, 16 B aligned
+        std::size_t stagedPayloadSize = (payloadSize + 15) / 16 * 16;
+        std::size_t blockTablesSize   = sizeof(std::uint32_t) * pixelsInBlock.size();
+        std::size_t blockOffsetsSize  = sizeof(cl_ulong) * blockOffsets.size();
 
         printf("OpenCL: Nr of blocks: %zu\n", nrOfBlocks);
-        printf("OpenCL: Group byte offset: %llu B\n", groupByteOffset);
-        printf("OpenCL: Required space for bitstream: %llu B\n", requiredSpace);
-
-        cl_mem bitStream_d;   // input bitstream buffer
-        bitStream_d = clCreateBuffer(context, CL_MEM_READ_ONLY, requiredSpace, NULL, &status);
-        evaluateReturnStatus(status);
-
-        // create on device buffer for pixelsInBlock array
-        cl_mem pixelsInBlock_d;
-        pixelsInBlock_d =
-           clCreateBuffer(context, CL_MEM_READ_ONLY, sizeof(std::uint32_t) * pixelsInBlock.size(), NULL, &status);
-        evaluateReturnStatus(status);
-
-        printf("OpenCL: Bitstream transfer to GPU memory \n");
-#    ifdef TIMING_EN
-        std::chrono::steady_clock::time_point begin_bitstream_to_dpcm_memory = std::chrono::steady_clock::now();
-#    endif
-
-        // BITSTREAM DATA TRANSFER
-        std::size_t host_offset   = 0;
-        std::size_t device_offset = 0;
-        std::size_t b             = 0;
-        for(auto size : blockSizes) {
-            // printf(
-            //    "OpenCL: Bitstream transfer: Block %zu | Host offset: %zu, Device offset: %zu, Size: %u",
-            //    b,
-            //    host_offset,
-            //    device_offset,
-            //    size);
-            // if(nrOfBlocks < 256) {
-            //     printf("\n");
-            // }else{
-            //     printf("\r");
-            // }
-            status = clEnqueueWriteBuffer(
-               cmdQueue,
-               bitStream_d,
-               CL_FALSE,
-               device_offset,
-               size,
-               &(bitStream[host_offset]),
-               0,
-               NULL,
-               NULL);
-            evaluateReturnStatus(status);
-            host_offset += size;
-            device_offset += groupByteOffset;
-            b++;
+        printf("OpenCL: Required space for bitstream: %zu B\n", payloadSize);
+
+        // padding: bitstream_to_dpcm_local copies whole windows, also past the end of the last block
+        cl_mem bitStream_d = engine.getBuffer(
+           OpenCLEngine::buffer::bitStream, payloadSize + c_parsingWindowBytes, CL_MEM_READ_ONLY, slot);
+        // on device buffers for blockOffsets, pixelsInBlock and rowFirstInBlock arrays
+        cl_mem blockOffsets_d =
+           engine.getBuffer(OpenCLEngine::buffer::blockOffsets, blockOffsetsSize, CL_MEM_READ_ONLY, slot);
+        cl_mem pixelsInBlock_d =
+           engine.getBuffer(OpenCLEngine::buffer::pixelsInBlock, blockTablesSize, CL_MEM_READ_ONLY, slot);
+        cl_mem rowFirstInBlock_d =
+           engine.getBuffer(OpenCLEngine::buffer::rowFirstInBlock, blockTablesSize, CL_MEM_READ_ONLY, slot);
+        std::uint8_t* bitStream_pinned = (std::uint8_t*)engine.getPinnedBuffer(
+           OpenCLEngine::pinned::bitStream, stagedPayloadSize + blockOffsetsSize + 2 * blockTablesSize, slot);
+        if(bitStream_d == nullptr || blockOffsets_d == nullptr || pixelsInBlock_d == nullptr
+           || rowFirstInBlock_d == nullptr || bitStream_pinned == nullptr) {
+            return BASE_OPENCL_ERROR;
         }
-        printf("\n");
 
-        // PIXELS IN BLOCK TRANSFER
+        // BITSTREAM DATA TRANSFER: blocks are contiguous in the file, so the whole payload is one write
+        memcpy(bitStream_pinned, bitStream, payloadSize);
+        cl_ulong* blockOffsets_pinned         = (cl_ulong*)(bitStream_pinned + stagedPayloadSize);
+        std::uint32_t* pixelsInBlock_pinned   = (std::uint32_t*)(blockOffsets_pinned + blockOffsets.size());
+        std::uint32_t* rowFirstInBlock_pinned = pixelsInBlock_pinned + pixelsInBlock.size();
+        memcpy(blockOffsets_pinned, blockOffsets.data(), blockOffsetsSize);
+        memcpy(pixelsInBlock_pinned, pixelsInBlock.data(), blockTablesSize);
+        memcpy(rowFirstInBlock_pinned, rowFirstInBlock.data(), blockTablesSize);
+
         status = clEnqueueWriteBuffer(
            cmdQueue,
-           pixelsInBlock_d,
+           bitStream_d,
            CL_FALSE,
            0,
-           sizeof(std::uint32_t) * pixelsInBlock.size(),
-           pixelsInBlock.data(),
+           payloadSize,
+           bitStream_pinned,
            0,
            NULL,
-           NULL);
-        evaluateReturnStatus(status);
+           &frame.events[OpenCLFrame_s::bitStream]);
+        if(evaluateReturnStatus(status)) {
+            return BASE_OPENCL_ERROR;
+        }
 
-#    ifdef TIMING_EN
-        clFinish(cmdQueue);
-        std::chrono::steady_clock::time_point end_bitstream_to_dpcm_memory = std::chrono::steady_clock::now();
-#    endif
+        // BLOCK OFFSETS, PIXELS IN BLOCK AND FIRST ROW OF BLOCK TRANSFER
+        status = clEnqueueWriteBuffer(
+           cmdQueue, blockOffsets_d, CL_FALSE, 0, blockOffsetsSize, blockOffsets_pinned, 0, NULL, NULL);
+        if(evaluateReturnStatus(status)) {
+            return BASE_OPENCL_ERROR;
+        }
+        status = clEnqueueWriteBuffer(
+           cmdQueue, pixelsInBlock_d, CL_FALSE, 0, blockTablesSize, pixelsInBlock_pinned, 0, NULL, NULL);
+        if(evaluateReturnStatus(status)) {
+            return BASE_OPENCL_ERROR;
+        }
+        status = clEnqueueWriteBuffer(
+           cmdQueue, rowFirstInBlock_d, CL_FALSE, 0, blockTablesSize, rowFirstInBlock_pinned, 0, NULL, NULL);
+        if(evaluateReturnStatus(status)) {
+            return BASE_OPENCL_ERROR;
+        }
 
-        std::int32_t nrOfRowsInBlock = (height + (nrOfBlocks - 1)) / nrOfBlocks;
+        printf(
+           "OpenCL: Nr of rows in block: %zu - %zu\n",
+           *std::min_element(pixelsInBlock.begin(), pixelsInBlock.begin() + nrOfBlocks) / (4 * width),
+           *std::max_element(pixelsInBlock.begin(), pixelsInBlock.begin() + nrOfBlocks) / (4 * width));
 
-        printf("OpenCL: Nr of rows in block: %d\n", nrOfRowsInBlock);
+        // kernel argument types
+        cl_ushort unaryMaxWidth_k = (cl_ushort)unaryMaxWidth;
+        cl_ulong bpp_k            = bpp_a;
 
-        // Set the Argument values
-        status = clSetKernelArg(ckBitstreamToDpcm, 0, sizeof(cl_mem), (void*)&bitStream_d);
-        evaluateReturnStatus(status);
-        status = clSetKernelArg(ckBitstreamToDpcm, 1, sizeof(cl_mem), (void*)&pixelsInBlock_d);
-        evaluateReturnStatus(status);
-        status = clSetKernelArg(ckBitstreamToDpcm, 2, sizeof(cl_mem), (void*)&YCCC_dpcm_d);
-        evaluateReturnStatus(status);
-        status = clSetKernelArg(ckBitstreamToDpcm, 3, sizeof(cl_mem), (void*)&YCCC_d);
-        evaluateReturnStatus(status);
-        status = clSetKernelArg(ckBitstreamToDpcm, 4, sizeof(cl_uint), (void*)&unaryMaxWidth);
-        evaluateReturnStatus(status);
-        status = clSetKernelArg(ckBitstreamToDpcm, 5, sizeof(cl_uint), (void*)&bpp_a);
-        evaluateReturnStatus(status);
-        status = clSetKernelArg(ckBitstreamToDpcm, 6, sizeof(cl_ulong), (void*)&groupByteOffset);
-        evaluateReturnStatus(status);
-        status = clSetKernelArg(ckBitstreamToDpcm, 7, sizeof(cl_int), (void*)&width);
-        evaluateReturnStatus(status);
-        status = clSetKernelArg(ckBitstreamToDpcm, 8, sizeof(cl_int), (void*)&height);
-        evaluateReturnStatus(status);
-        status = clSetKernelArg(ckBitstreamToDpcm, 9, sizeof(cl_int), (void*)&nrOfRowsInBlock);
-        evaluateReturnStatus(status);
+        if(fused) {
+            //***************************************************
+            // STEP 8: Single kernel from bitstream to BayerGB, one work-item per block
+            //***************************************************
+
+            status = clSetKernelArg(ckBitstreamToBayerGB, 0, sizeof(cl_mem), (void*)&bitStream_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToBayerGB, 1, sizeof(cl_mem), (void*)&pixelsInBlock_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToBayerGB, 2, sizeof(cl_mem), (void*)&bayerGB_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToBayerGB, 3, sizeof(cl_ushort), (void*)&unaryMaxWidth_k);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToBayerGB, 4, sizeof(cl_ulong), (void*)&bpp_k);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToBayerGB, 5, sizeof(cl_mem), (void*)&blockOffsets_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToBayerGB, 6, sizeof(cl_int), (void*)&width);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToBayerGB, 7, sizeof(cl_mem), (void*)&rowFirstInBlock_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToBayerGB, 8, sizeof(cl_uint), (void*)&lossyBits);
+            evaluateReturnStatus(status);
+
+            printf("OpenCL: Bitstream to BayerGB kernel: Global work size: %zu\n", blocks_globalSize);
+            printf("OpenCL: Bitstream to BayerGB kernel:  Local work size: %zu\n", blocks_localSize);
+
+            status = clEnqueueNDRangeKernel(
+               cmdQueue,
+               ckBitstreamToBayerGB,
+               1,
+               NULL,
+               &blocks_globalSize,
+               &blocks_localSize,
+               0,
+               NULL,
+               &frame.events[OpenCLFrame_s::bitstreamToBayerGB]);
+            if(evaluateReturnStatus(status)) {
+                return BASE_OPENCL_ERROR;
+            }
+            return enqueueReadBack_opencl(frame, cmdQueue, bayerGB_d, bayerGB_pinned);
+        }
 
         size_t bitstreamToDpcm_globalSize;   // = nrOfBlocks;
         size_t bitstreamToDpcm_localSize;   //  = getLocalWorkSize(nrOfBlocks);
 
-        getLocalAndGlobalWorkSize(nrOfBlocks, bitstreamToDpcm_localSize, bitstreamToDpcm_globalSize);
+        // window must hold the worst case quadruplet (all channels binary coded) after the 16 B alignment,
+        // plus 64 bits that are peeked past it
+        cl_uint maxQuadrupletBits = 4 * (std::max<std::size_t>(unaryMaxWidth, 1) + k_seed);
+        bool localParsing         = kernels == blockKernels::localParsing;
+        if(localParsing && 16 * 8 + maxQuadrupletBits + 64 > 8 * c_parsingWindowBytes) {
+            printf("OpenCL: unary max. width %zu too large for local parsing, using global memory\n", unaryMaxWidth);
+            localParsing = false;
+        }
 
-        printf("OpenCL: Bitstream to DPCM kernel: Global work size: %zu\n", bitstreamToDpcm_globalSize);
-        printf("OpenCL: Bitstream to DPCM kernel:  Local work size: %zu\n", bitstreamToDpcm_localSize);
+        if(localParsing) {
+            cl_uint windowVecs = c_parsingWindowBytes / 16;
+            cl_uint bpp_u      = bpp_a;
 
-#    ifdef TIMING_EN
-        std::chrono::steady_clock::time_point begin_parsing = std::chrono::steady_clock::now();
-#    endif
+            // window and its start for each work-item (and 2 flags)
+            getBlockLocalAndGlobalWorkSize(
+               nrOfBlocks,
+               ckBitstreamToDpcmLocal,
+               c_parsingWindowBytes + sizeof(cl_uint),
+               bitstreamToDpcm_localSize,
+               bitstreamToDpcm_globalSize);
+
+            status = clSetKernelArg(ckBitstreamToDpcmLocal, 0, sizeof(cl_mem), (void*)&bitStream_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcmLocal, 1, sizeof(cl_mem), (void*)&pixelsInBlock_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcmLocal, 2, sizeof(cl_mem), (void*)&YCCC_dpcm_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcmLocal, 3, sizeof(cl_mem), (void*)&YCCC_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcmLocal, 4, sizeof(cl_ushort), (void*)&unaryMaxWidth_k);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcmLocal, 5, sizeof(cl_uint), (void*)&bpp_u);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcmLocal, 6, sizeof(cl_mem), (void*)&blockOffsets_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcmLocal, 7, sizeof(cl_int), (void*)&width);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcmLocal, 8, sizeof(cl_mem), (void*)&rowFirstInBlock_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(
+               ckBitstreamToDpcmLocal, 9, bitstreamToDpcm_localSize * c_parsingWindowBytes, NULL);   // __local
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcmLocal, 10, bitstreamToDpcm_localSize * sizeof(cl_uint), NULL);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcmLocal, 11, sizeof(cl_uint), (void*)&windowVecs);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcmLocal, 12, sizeof(cl_uint), (void*)&maxQuadrupletBits);
+            evaluateReturnStatus(status);
+        } else {
+            // Set the Argument values; they are captured at enqueue, so other slots may set them again right after
+            status = clSetKernelArg(ckBitstreamToDpcm, 0, sizeof(cl_mem), (void*)&bitStream_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcm, 1, sizeof(cl_mem), (void*)&pixelsInBlock_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcm, 2, sizeof(cl_mem), (void*)&YCCC_dpcm_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcm, 3, sizeof(cl_mem), (void*)&YCCC_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcm, 4, sizeof(cl_ushort), (void*)&unaryMaxWidth_k);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcm, 5, sizeof(cl_ulong), (void*)&bpp_k);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcm, 6, sizeof(cl_mem), (void*)&blockOffsets_d);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcm, 7, sizeof(cl_int), (void*)&width);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcm, 8, sizeof(cl_int), (void*)&height);
+            evaluateReturnStatus(status);
+            status = clSetKernelArg(ckBitstreamToDpcm, 9, sizeof(cl_mem), (void*)&rowFirstInBlock_d);
+            evaluateReturnStatus(status);
+
+            getLocalAndGlobalWorkSize(nrOfBlocks, bitstreamToDpcm_localSize, bitstreamToDpcm_globalSize);
+        }
+
+        printf(
+           "OpenCL: Bitstream to DPCM kernel%s: Global work size: %zu\n",
+           localParsing ? " (local memory)" : "",
+           bitstreamToDpcm_globalSize);
+        printf("OpenCL: Bitstream to DPCM kernel:  Local work size: %zu\n", bitstreamToDpcm_localSize);
 
         // Execute the kernel
         status = clEnqueueNDRangeKernel(
            cmdQueue,
-           ckBitstreamToDpcm,
+           localParsing ? ckBitstreamToDpcmLocal : ckBitstreamToDpcm,
            1,
            NULL,
            &bitstreamToDpcm_globalSize,
            &bitstreamToDpcm_localSize,
            0,
            NULL,
-           NULL);
-        evaluateReturnStatus(status);
-
-        printf("OpenCL: Bitstream to DPCM kernel executed\n");
-
-        clFinish(cmdQueue);
-
-        printf("OpenCL: Bitstream to DPCM kernel finished\n");
-
-#    ifdef TIMING_EN
-        std::chrono::steady_clock::time_point end_parsing = std::chrono::steady_clock::now();
-#    endif
+           &frame.events[OpenCLFrame_s::bitstreamToDpcm]);
+        if(evaluateReturnStatus(status)) {
+            return BASE_OPENCL_ERROR;
+        }
 
         //***************************************************
         // STEP 8b: Set up kernel for calculation of first column values for each block
@@ -1120,7 +2168,7 @@ struct DecoderBase {
         evaluateReturnStatus(status);
         status = clSetKernelArg(ckFirstColumnAllRows, 4, sizeof(cl_int), (void*)&height);
         evaluateReturnStatus(status);
-        status = clSetKernelArg(ckFirstColumnAllRows, 5, sizeof(cl_int), (void*)&nrOfRowsInBlock);
+        status = clSetKernelArg(ckFirstColumnAllRows, 5, sizeof(cl_mem), (void*)&rowFirstInBlock_d);
         evaluateReturnStatus(status);
 
         size_t firstColumnAllRows_globalSize;
@@ -1131,10 +2179,6 @@ struct DecoderBase {
         printf("OpenCL: First column all rows kernel: Global work size: %zu\n", firstColumnAllRows_globalSize);
         printf("OpenCL: First column all rows kernel:  Local work size: %zu\n", firstColumnAllRows_localSize);
 
-#    ifdef TIMING_EN
-        std::chrono::steady_clock::time_point begin_firstColumnAllRows = std::chrono::steady_clock::now();
-#    endif
-
         // Execute the kernel
         status = clEnqueueNDRangeKernel(
            cmdQueue,
@@ -1145,19 +2189,10 @@ struct DecoderBase {
            &firstColumnAllRows_localSize,
            0,
            NULL,
-           NULL);
-
-        evaluateReturnStatus(status);
-
-        printf("OpenCL: First column all rows kernel executed\n");
-
-        clFinish(cmdQueue);
-
-#    ifdef TIMING_EN
-        std::chrono::steady_clock::time_point end_firstColumnAllRows = std::chrono::steady_clock::now();
-#    endif
-
-        printf("OpenCL: First column all rows kernel finished\n");
+           &frame.events[OpenCLFrame_s::firstColumnAllRows]);
+        if(evaluateReturnStatus(status)) {
+            return BASE_OPENCL_ERROR;
+        }
 
         //***************************************************
         // STEP 10: Set the kernel arguments for dpcm to full YCCC calculation
@@ -1177,15 +2212,10 @@ struct DecoderBase {
         // STEP 11: Enqueue the kernel for execution
         //***************************************************
 
-        //***************************************************
-        // STEP 2.5: Calculate work sizes
-        //***************************************************
-
         // number of work-items in the work-group; defines overall size of the N-Dimensional range
         size_t szGlobalWorkSize = height;
-        // 128 threads per work group, must divide evenly into global work size
-        size_t szLocalWorkSize;
-        clGetDeviceInfo(devices[0], CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(szLocalWorkSize), &szLocalWorkSize, NULL);
+        // work group size is the device maximum, global work size must be its multiple
+        size_t szLocalWorkSize = engine.getMaxWorkGroupSize();
         // Adjust global work size to be a multiple of local work size
         if(szGlobalWorkSize % szLocalWorkSize != 0) {
             szGlobalWorkSize = ((szGlobalWorkSize / szLocalWorkSize) + 1) * szLocalWorkSize;
@@ -1195,265 +2225,146 @@ struct DecoderBase {
            szGlobalWorkSize,
            szLocalWorkSize);
 
-#    ifdef TIMING_EN
-        std::chrono::steady_clock::time_point begin_dpcm_2_bayer_kernel = std::chrono::steady_clock::now();
-#    endif
-
         // Launch kernel
         status = clEnqueueNDRangeKernel(
            cmdQueue,
            ckDpcmAcrossRows,
            1,
-           NULL,
-           &szGlobalWorkSize,
-           &szLocalWorkSize,
-           0,
-           NULL,
-           NULL);
-        evaluateReturnStatus(status);
-
-#    ifdef TIMING_EN
-        clFinish(cmdQueue);
-        std::chrono::steady_clock::time_point end_dpcm_2_bayer_kernel = std::chrono::steady_clock::now();
-#    endif
-
-        //***************************************************
-        // STEP 12: Read the output buffer back to the host
-        //***************************************************
-        // Synchronous/blocking read of results
-        // Read back full YCCC values
-        // TODO: remove this because it is not actually necesarry
-        // status = clEnqueueReadBuffer(cmdQueue, YCCC_d, CL_TRUE, 0, datasize_YCCC_d, YCCC_h.data(), 0, NULL, NULL);
-        // evaluateReturnStatus(status);
-
-        //***************************************************
-        // STEP 13: Set the kernel arguments for yccc to bayerGB conversion
-        //***************************************************
-
-        status = clSetKernelArg(ckYcccToBayerGB, 0, sizeof(cl_mem), (void*)&YCCC_d);
-        evaluateReturnStatus(status);
-        status = clSetKernelArg(ckYcccToBayerGB, 1, sizeof(cl_mem), (void*)&bayerGB_d);
-        evaluateReturnStatus(status);
-        status = clSetKernelArg(ckYcccToBayerGB, 2, sizeof(cl_int), (void*)&lossyBits);
-        evaluateReturnStatus(status);
-        status = clSetKernelArg(ckYcccToBayerGB, 3, sizeof(cl_int), (void*)&width);
-        evaluateReturnStatus(status);
-        cl_int nrOfPixels = height * width;
-        status            = clSetKernelArg(ckYcccToBayerGB, 4, sizeof(cl_int), (void*)&nrOfPixels);
-        evaluateReturnStatus(status);
-
-        //***************************************************
-
-        std::size_t szGlobalWorkSize_yccc_to_bayer = height * width;
-        std::size_t szLocalWorkSize_yccc_to_bayer;
-        clGetDeviceInfo(
-           devices[0],
-           CL_DEVICE_MAX_WORK_GROUP_SIZE,
-           sizeof(szLocalWorkSize_yccc_to_bayer),
-           &szLocalWorkSize_yccc_to_bayer,
-           NULL);
-        if(szGlobalWorkSize_yccc_to_bayer % szLocalWorkSize_yccc_to_bayer != 0) {
-            szGlobalWorkSize_yccc_to_bayer =
-               ((szGlobalWorkSize_yccc_to_bayer / szLocalWorkSize_yccc_to_bayer) + 1) * szLocalWorkSize_yccc_to_bayer;
-        }
-        printf(
-           "OpenCL yccc_to_bayer kernel: Global work size: %zu, Local work size: %zu\n",
-           szGlobalWorkSize_yccc_to_bayer,
-           szLocalWorkSize_yccc_to_bayer);
-
-#    ifdef TIMING_EN
-        std::chrono::steady_clock::time_point begin_yccc_2_bayer_kernel = std::chrono::steady_clock::now();
-#    endif
-
-        // Launch kernel
-        status = clEnqueueNDRangeKernel(
-           cmdQueue,
-           ckYcccToBayerGB,
-           1,
-           NULL,
-           &szGlobalWorkSize_yccc_to_bayer,
-           &szLocalWorkSize_yccc_to_bayer,
-           0,
-           NULL,
-           NULL);
-        evaluateReturnStatus(status);
-
-#    ifdef TIMING_EN
-        clFinish(cmdQueue);
-        std::chrono::steady_clock::time_point end_yccc_2_bayer_kernel = std::chrono::steady_clock::now();
-#    endif
-
-#    ifdef TIMING_EN
-        std::chrono::steady_clock::time_point begin_yccc_2_bayer_memory = std::chrono::steady_clock::now();
-#    endif
-        // Read back BayerGB values
-        status = clEnqueueReadBuffer(cmdQueue, bayerGB_d, CL_TRUE, 0, datasize_BayerGB, bayerGB, 0, NULL, NULL);
-        evaluateReturnStatus(status);
-        // Block until all previously queued OpenCL commands in a command-queue are issued to the associated device and have completed
-#    ifdef TIMING_EN
-        clFinish(cmdQueue);
-        std::chrono::steady_clock::time_point end_yccc_2_bayer_memory = std::chrono::steady_clock::now();
-#    endif
-
-        printf("GPU execution finished\n");
-
-        // char outputFile[200];
-        // char txt[200];
-        // sprintf(outputFile, "C:/DATA/Repos/OMLS_Masters_SW/images/lite_dataset/dump/gpu_DPCM.txt");
-        // std::ofstream wf(outputFile, std::ios::out);
-        // if(!wf) {
-        //     char msg[200];
-        //     sprintf(msg, "Cannot open specified file: %s", outputFile);
-        //     throw std::runtime_error(msg);
-        // }
-        // std::sprintf(txt, "%zu %zu pred YCCC, curr YCCC, dpcm\n", width, height);
-        // wf << txt;
-        // int16_t mask_Y      = (1 << (bpp_a + 2)) - 1;   // 0x03FF
-        // int16_t mask_C      = (1 << (bpp_a + 1)) - 1;   // 0x01FF;
-        // int16_t mask_Y_dpcm = (1 << (bpp_a + 3)) - 1;   // 0x07FF;
-        // int16_t mask_C_dpcm = (1 << (bpp_a + 2)) - 1;   // 0x03FF;
-
-        // for(std::size_t i = 0; i < width * height; i++) {
-        //     std::sprintf(
-        //        txt,
-        //        "%4zu %4zu : %.4hX %.4hX %.4hX %.4hX : %.4hX %.4hX %.4hX %.4hX : %.4hX %.4hX %.4hX %.4hX\n",
-        //        i / width,
-        //        i % width,
-        //        (YCCC_prev_debug[4 * i + 0] & mask_Y),
-        //        (YCCC_prev_debug[4 * i + 1] & mask_C),
-        //        (YCCC_prev_debug[4 * i + 2] & mask_C),
-        //        (YCCC_prev_debug[4 * i + 3] & mask_C),
-        //        //    (YCCC_h_gt[4 * i + 0] & mask_Y),
-        //        //    (YCCC_h_gt[4 * i + 1] & mask_C),
-        //        //    (YCCC_h_gt[4 * i + 2] & mask_C),
-        //        //    (YCCC_h_gt[4 * i + 3] & mask_C),
-        //        (YCCC_h[4 * i + 0] & mask_Y),
-        //        (YCCC_h[4 * i + 1] & mask_C),
-        //        (YCCC_h[4 * i + 2] & mask_C),
-        //        (YCCC_h[4 * i + 3] & mask_C),
-        //        (YCCC_dpcm_h[4 * i + 0] & mask_Y_dpcm),
-        //        (YCCC_dpcm_h[4 * i + 1] & mask_C_dpcm),
-        //        (YCCC_dpcm_h[4 * i + 2] & mask_C_dpcm),
-        //        (YCCC_dpcm_h[4 * i + 3] & mask_C_dpcm));
-        //     wf << txt;
-        // }
-        // wf.close();
+           NULL,
+           &szGlobalWorkSize,
+           &szLocalWorkSize,
+           0,
+           NULL,
+           &frame.events[OpenCLFrame_s::dpcmAcrossRows]);
+        if(evaluateReturnStatus(status)) {
+            return BASE_OPENCL_ERROR;
+        }
 
         //***************************************************
-        // STEP 13: Release OpenCL resources
+        // STEP 13: Set the kernel arguments for yccc to bayerGB conversion
         //***************************************************
-        if(ckBitstreamToDpcm)
-            clReleaseKernel(ckBitstreamToDpcm);
-        if(bitStream_d)
-            clReleaseMemObject(bitStream_d);
-        if(pixelsInBlock_d)
-            clReleaseMemObject(pixelsInBlock_d);
 
-        if(ckFirstColumnAllRows)
-            clReleaseKernel(ckFirstColumnAllRows);
+        status = clSetKernelArg(ckYcccToBayerGB, 0, sizeof(cl_mem), (void*)&YCCC_d);
+        evaluateReturnStatus(status);
+        status = clSetKernelArg(ckYcccToBayerGB, 1, sizeof(cl_mem), (void*)&bayerGB_d);
+        evaluateReturnStatus(status);
+        status = clSetKernelArg(ckYcccToBayerGB, 2, sizeof(cl_int), (void*)&lossyBits);
+        evaluateReturnStatus(status);
+        status = clSetKernelArg(ckYcccToBayerGB, 3, sizeof(cl_int), (void*)&width);
+        evaluateReturnStatus(status);
+        cl_int nrOfPixels = height * width;
+        status            = clSetKernelArg(ckYcccToBayerGB, 4, sizeof(cl_int), (void*)&nrOfPixels);
+        evaluateReturnStatus(status);
 
+        std::size_t szGlobalWorkSize_yccc_to_bayer = height * width;
+        std::size_t szLocalWorkSize_yccc_to_bayer  = engine.getMaxWorkGroupSize();
+        if(szGlobalWorkSize_yccc_to_bayer % szLocalWorkSize_yccc_to_bayer != 0) {
+            szGlobalWorkSize_yccc_to_bayer =
+               ((szGlobalWorkSize_yccc_to_bayer / szLocalWorkSize_yccc_to_bayer) + 1) * szLocalWorkSize_yccc_to_bayer;
+        }
+        printf(
+           "OpenCL yccc_to_bayer kernel: Global work size: %zu, Local work size: %zu\n",
+           szGlobalWorkSize_yccc_to_bayer,
+           szLocalWorkSize_yccc_to_bayer);
 
-        if(ckDpcmAcrossRows)
-            clReleaseKernel(ckDpcmAcrossRows);
-        if(YCCC_dpcm_d)
-            clReleaseMemObject(YCCC_dpcm_d);
-        if(YCCC_d)
-            clReleaseMemObject(YCCC_d);
+        // Launch kernel
+        status = clEnqueueNDRangeKernel(
+           cmdQueue,
+           ckYcccToBayerGB,
+           1,
+           NULL,
+           &szGlobalWorkSize_yccc_to_bayer,
+           &szLocalWorkSize_yccc_to_bayer,
+           0,
+           NULL,
+           &frame.events[OpenCLFrame_s::ycccToBayerGB]);
+        if(evaluateReturnStatus(status)) {
+            return BASE_OPENCL_ERROR;
+        }
 
-        if(ckYcccToBayerGB)
-            clReleaseKernel(ckYcccToBayerGB);
-        if(bayerGB_d)
-            clReleaseMemObject(bayerGB_d);
+        return enqueueReadBack_opencl(frame, cmdQueue, bayerGB_d, bayerGB_pinned);
+    }
 
+    /**
+ * Reads back BayerGB values into pinned memory, host copies them out in finishBitstreamParallel_opencl.
+ * Flushes the queue, so the frame is submitted to the device while host goes on with the next one.
+ */
+    STATUS_t
+       enqueueReadBack_opencl(OpenCLFrame_s& frame, cl_command_queue cmdQueue, cl_mem bayerGB_d, void* bayerGB_pinned)
+    {
+        cl_int status = clEnqueueReadBuffer(
+           cmdQueue,
+           bayerGB_d,
+           CL_FALSE,
+           0,
+           frame.bayerGBSize,
+           bayerGB_pinned,
+           0,
+           NULL,
+           &frame.events[OpenCLFrame_s::readBack]);
+        if(evaluateReturnStatus(status)) {
+            return BASE_OPENCL_ERROR;
+        }
 
-        if(cpProgram)
-            clReleaseProgram(cpProgram);
-        if(cmdQueue)
-            clReleaseCommandQueue(cmdQueue);
-        if(context)
-            clReleaseContext(context);
+        clFlush(cmdQueue);
+        return BASE_SUCCESS;
+    }
 
-        delete[] platforms;
-        delete[] devices;
+    /**
+ * Waits for a frame enqueued by enqueueBitstreamParallel_opencl and copies the decoded image to @param bayerGB,
+ * @param bayerGBSize is in pixels. T must be std::uint16_t when the frame has more than 8 BPP.
+ * Stage times in m_stageTimes are device times from event profiling, total is wall time since enqueue.
+ */
+    template<typename T>
+    STATUS_t finishBitstreamParallel_opencl(OpenCLFrame_s& frame, T* bayerGB, std::size_t bayerGBSize)
+    {
+        cl_event readBack = frame.events[OpenCLFrame_s::readBack];
+        if(readBack == nullptr || sizeof(T) != frame.pixelBytes || sizeof(T) * bayerGBSize != frame.bayerGBSize) {
+            frame.release();
+            return BASE_OUTPUT_BUFFER_FALSE_SIZE;
+        }
 
-#    ifdef TIMING_EN
-        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-        std::cout << std::endl;
-        std::cout << "OpenCL: Parallel decoding time = "
-                  << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]" << std::endl;
-        std::cout << "OpenCL: Memory transfer Bitstream to DPCM time = "
-                  << std::chrono::duration_cast<std::chrono::milliseconds>(
-                        end_bitstream_to_dpcm_memory - begin_bitstream_to_dpcm_memory)
-                        .count()
-                  << "[ms]" << std::endl;
-        std::cout << "OpenCL: Parsing time = "
-                  << std::chrono::duration_cast<std::chrono::milliseconds>(end_parsing - begin_parsing).count()
-                  << "[ms]" << std::endl;
-        std::cout << "OpenCL: Kernel first column all rows time = "
-                  << std::chrono::duration_cast<std::chrono::milliseconds>(
-                        end_firstColumnAllRows - begin_firstColumnAllRows)
-                        .count()
-                  << "[ms]" << std::endl;
-        std::cout << "OpenCL: Kernel DPCM to YCCC time = "
-                  << std::chrono::duration_cast<std::chrono::milliseconds>(
-                        end_dpcm_2_bayer_kernel - begin_dpcm_2_bayer_kernel)
-                        .count()
-                  << "[ms]" << std::endl;
-        std::cout << "OpenCL: Kernel YCCC to BayerGB time = "
-                  << std::chrono::duration_cast<std::chrono::milliseconds>(
-                        end_yccc_2_bayer_kernel - begin_yccc_2_bayer_kernel)
-                        .count()
-                  << "[ms]" << std::endl;
-        std::cout << "OpenCL: Memory transfer YCCC to BayerGB time = "
-                  << std::chrono::duration_cast<std::chrono::milliseconds>(
-                        end_yccc_2_bayer_memory - begin_yccc_2_bayer_memory)
-                        .count()
-                  << "[ms]" << std::endl;
-        std::cout << std::endl;
+        cl_int status = clWaitForEvents(1, &readBack);
+        if(evaluateReturnStatus(status)) {
+            frame.release();
+            return BASE_OPENCL_ERROR;
+        }
 
-        auto total_time = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
-        printf(
-           "Resolution: %zu x %zu | Pixels: %zu |Nr of blocks: %zu | Mem Bitstream: %zu ms | Parsing time: %zu ms | "
-           "First column: %zu ms | DPCM to YCCC: %zu ms | YCCC to BayerGB: %zu ms | Mem transfer device host: %zu ms | "
-           "Total time: %zu ms\n",
-           2 * width,
-           2 * height,
-           2 * width * 2 * height,
-           nrOfBlocks,
-           std::chrono::duration_cast<std::chrono::milliseconds>(
-              end_bitstream_to_dpcm_memory - begin_bitstream_to_dpcm_memory)
-              .count(),
-           std::chrono::duration_cast<std::chrono::milliseconds>(end_parsing - begin_parsing).count(),
-           std::chrono::duration_cast<std::chrono::milliseconds>(end_firstColumnAllRows - begin_firstColumnAllRows)
-              .count(),
-           std::chrono::duration_cast<std::chrono::milliseconds>(end_dpcm_2_bayer_kernel - begin_dpcm_2_bayer_kernel)
-              .count(),
-           std::chrono::duration_cast<std::chrono::milliseconds>(end_yccc_2_bayer_kernel - begin_yccc_2_bayer_kernel)
-              .count(),
-           std::chrono::duration_cast<std::chrono::milliseconds>(end_yccc_2_bayer_memory - begin_yccc_2_bayer_memory)
-              .count(),
-           total_time);
+        void* bayerGB_pinned =
+           OpenCLEngine::getInstance().getPinnedBuffer(OpenCLEngine::pinned::bayerGB, frame.bayerGBSize, frame.slot);
+        memcpy(bayerGB, bayerGB_pinned, frame.bayerGBSize);
 
-        printf(
-           "%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu\n",
-           2 * width,
-           2 * height,
-           2 * width * 2 * height,
-           nrOfBlocks,
-           std::chrono::duration_cast<std::chrono::milliseconds>(
-              end_bitstream_to_dpcm_memory - begin_bitstream_to_dpcm_memory)
-              .count(),
-           std::chrono::duration_cast<std::chrono::milliseconds>(end_parsing - begin_parsing).count(),
-           std::chrono::duration_cast<std::chrono::milliseconds>(end_firstColumnAllRows - begin_firstColumnAllRows)
-              .count(),
-           std::chrono::duration_cast<std::chrono::milliseconds>(end_dpcm_2_bayer_kernel - begin_dpcm_2_bayer_kernel)
-              .count(),
-           std::chrono::duration_cast<std::chrono::milliseconds>(end_yccc_2_bayer_kernel - begin_yccc_2_bayer_kernel)
-              .count(),
-           std::chrono::duration_cast<std::chrono::milliseconds>(end_yccc_2_bayer_memory - begin_yccc_2_bayer_memory)
-              .count(),
-           total_time);
+        auto end = std::chrono::steady_clock::now();
+
+        m_stageTimes                 = StageTimes_s{};
+        m_stageTimes.memBitstream    = frame.getDeviceTime(OpenCLFrame_s::bitStream);
+        m_stageTimes.parsing         = frame.getDeviceTime(OpenCLFrame_s::bitstreamToDpcm);
+        m_stageTimes.firstColumn     = frame.getDeviceTime(OpenCLFrame_s::firstColumnAllRows);
+        m_stageTimes.dpcmToYccc      = frame.getDeviceTime(OpenCLFrame_s::dpcmAcrossRows);
+        m_stageTimes.ycccToBayer     = frame.getDeviceTime(OpenCLFrame_s::ycccToBayerGB);
+        if(frame.events[OpenCLFrame_s::bitstreamToBayerGB] != nullptr) {   // fused kernel, all stages in one
+            m_stageTimes.parsing = frame.getDeviceTime(OpenCLFrame_s::bitstreamToBayerGB);
+        }
+        m_stageTimes.memDeviceToHost = frame.getDeviceTime(OpenCLFrame_s::readBack);
+        m_stageTimes.total = std::chrono::duration_cast<std::chrono::microseconds>(end - frame.begin).count();
+        frame.release();
 
+#    ifdef TIMING_EN
+        printf(
+           "Resolution: %zu x %zu | Pixels: %zu |Nr of blocks: %zu | Mem Bitstream: %llu us | Parsing time: %llu us | "
+           "First column: %llu us | DPCM to YCCC: %llu us | YCCC to BayerGB: %llu us | Mem transfer device host: "
+           "%llu us | Total time: %llu us\n",
+           2 * frame.width,
+           2 * frame.height,
+           2 * frame.width * 2 * frame.height,
+           frame.nrOfBlocks,
+           m_stageTimes.memBitstream,
+           m_stageTimes.parsing,
+           m_stageTimes.firstColumn,
+           m_stageTimes.dpcmToYccc,
+           m_stageTimes.ycccToBayer,
+           m_stageTimes.memDeviceToHost,
+           m_stageTimes.total);
 #    endif
 
         printf("OpenCL: Parallel decoding finished\n");
@@ -1464,7 +2375,10 @@ struct DecoderBase {
  * Implementatiton for no blocks.
  * @param width_a and @param height_a are related to channel size which is one half of the actual BayerCFA image.
  * BayerCFA image.
+ * @param workspace holds host side YCCC and DPCM buffers, they are allocated per call when nullptr.
+ * T is std::uint8_t for 8 BPP and std::uint16_t for more (see checkGpuOutputType).
  */
+    template<typename T>
     STATUS_t decodeBitstreamParallel_opencl(
        std::size_t width_a,
        std::size_t height_a,
@@ -1473,18 +2387,15 @@ struct DecoderBase {
        std::size_t bpp_a,
        const std::uint8_t* bitStream,
        const std::size_t bitStreamSize,
-       std::uint8_t* bayerGB,
-       std::size_t bayerGBSize)
+       T* bayerGB,
+       std::size_t bayerGBSize,
+       DecodeWorkspace_s* workspace = nullptr)
     {
 
         printf("OpenCL decoding started!\n");
         // identify_platforms();
 
-        if(bpp_a != 8) {
-            fprintf(
-               stdout,
-               "DecoderBase: bpp is not 8, but %zu. GPU decompression implemented only for 8 BPP.\n",
-               bpp_a);
+        if(checkGpuOutputType<T>(bpp_a)) {
             return BASE_ERROR;
         }
 
@@ -1515,40 +2426,35 @@ struct DecoderBase {
             return BASE_OUTPUT_BUFFER_FALSE_SIZE;
         }
 
-        // reader.loadFirstByte();
-        reader.loadFirstFourBytes();
+        reader.loadWindow();
 
         //***************************************************
-        // STEP 1: Discover and initialize the platforms
+        // STEP 1-8: Device, context, queue, program and kernels are set up once per process by OpenCLEngine
         //***************************************************
 
-        cl_int status = 0;
-        cl_uint numPlatforms;
-        // cl_platform_id* platforms = NULL;
-
-        // Get platforms
-        status = clGetPlatformIDs(0, NULL, &numPlatforms);
-        if(evaluateReturnStatus(status)) {
+        OpenCLEngine& engine = OpenCLEngine::getInstance();
+        cl_int status        = engine.init();
+        if(status != CL_SUCCESS) {
             return BASE_OPENCL_ERROR;
-        };
-        auto platforms = new cl_platform_id[numPlatforms];
-        status         = clGetPlatformIDs(numPlatforms, platforms, NULL);
-        evaluateReturnStatus(status);
+        }
+        cl_command_queue cmdQueue = engine.getQueue();
 
-        //***************************************************
-        // STEP 2: Discover and initialize the devices
-        //***************************************************
+        // Device buffers are pooled by the engine, they are reallocated only when a larger image arrives
+        size_t iNumElements         = 4 * (height * width);
+        size_t datasize_YCCC_d      = sizeof(std::int16_t) * iNumElements;
+        size_t datasize_YCCC_dpcm_d = sizeof(std::int16_t) * iNumElements;
+        size_t datasize_BayerGB     = sizeof(T) * 2 * width * 2 * height;
 
-        cl_uint numDevices;
-        // Use clGetDeviceIDs() to retrieve the number of
-        // devices present
-        status = clGetDeviceIDs(platforms[0], CL_DEVICE_TYPE_GPU, 0, NULL, &numDevices);
-        evaluateReturnStatus(status);
-        auto devices = new cl_device_id[numDevices];
+        cl_mem YCCC_d      = engine.getBuffer(OpenCLEngine::buffer::YCCC, datasize_YCCC_d, CL_MEM_READ_WRITE);
+        cl_mem YCCC_dpcm_d = engine.getBuffer(OpenCLEngine::buffer::YCCC_dpcm, datasize_YCCC_dpcm_d, CL_MEM_READ_WRITE);
+        cl_mem bayerGB_d   = engine.getBuffer(OpenCLEngine::buffer::bayerGB, datasize_BayerGB, CL_MEM_WRITE_ONLY);
+        if(YCCC_d == nullptr || YCCC_dpcm_d == nullptr || bayerGB_d == nullptr) {
+            return BASE_OPENCL_ERROR;
+        }
 
-        // Fill in devices with clGetDeviceIDs()
-        status = clGetDeviceIDs(platforms[0], CL_DEVICE_TYPE_GPU, numDevices, devices, NULL);
-        evaluateReturnStatus(status);
+        cl_kernel ckDpcmAcrossRows = engine.getKernel(OpenCLEngine::kernel::dpcmAcrossRows);
+        cl_kernel ckYcccToBayerGB  = engine.getKernel(
+           sizeof(T) == 1 ? OpenCLEngine::kernel::ycccToBayerGB_8bit : OpenCLEngine::kernel::ycccToBayerGB_16bit);
 
         //***************************************************
         // STEP 2.5: Calculate work sizes
@@ -1556,9 +2462,8 @@ struct DecoderBase {
 
         // number of work-items in the work-group; defines overall size of the N-Dimensional range
         size_t szGlobalWorkSize = height;
-        // 128 threads per work group, must divide evenly into global work size
-        size_t szLocalWorkSize;
-        clGetDeviceInfo(devices[0], CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(szLocalWorkSize), &szLocalWorkSize, NULL);
+        // work group size is the device maximum, global work size must be its multiple
+        size_t szLocalWorkSize = engine.getMaxWorkGroupSize();
         // Adjust global work size to be a multiple of local work size
         if(szGlobalWorkSize % szLocalWorkSize != 0) {
             szGlobalWorkSize = ((szGlobalWorkSize / szLocalWorkSize) + 1) * szLocalWorkSize;
@@ -1569,13 +2474,7 @@ struct DecoderBase {
            szLocalWorkSize);
 
         std::size_t szGlobalWorkSize_yccc_to_bayer = height * width;
-        std::size_t szLocalWorkSize_yccc_to_bayer;
-        clGetDeviceInfo(
-           devices[0],
-           CL_DEVICE_MAX_WORK_GROUP_SIZE,
-           sizeof(szLocalWorkSize_yccc_to_bayer),
-           &szLocalWorkSize_yccc_to_bayer,
-           NULL);
+        std::size_t szLocalWorkSize_yccc_to_bayer = engine.getMaxWorkGroupSize();
         if(szGlobalWorkSize_yccc_to_bayer % szLocalWorkSize_yccc_to_bayer != 0) {
             szGlobalWorkSize_yccc_to_bayer =
                ((szGlobalWorkSize_yccc_to_bayer / szLocalWorkSize_yccc_to_bayer) + 1) * szLocalWorkSize_yccc_to_bayer;
@@ -1585,119 +2484,6 @@ struct DecoderBase {
            szGlobalWorkSize_yccc_to_bayer,
            szLocalWorkSize_yccc_to_bayer);
 
-        //***************************************************
-        // STEP 3: Create a context
-        //***************************************************
-
-        cl_context context = NULL;
-        // Create a context using clCreateContext() and
-        // associate it with the devices
-        context = clCreateContext(NULL, numDevices, devices, NULL, NULL, &status);
-        evaluateReturnStatus(status);
-
-        //***************************************************
-        // STEP 4: Create a command queue
-        //***************************************************
-        cl_command_queue cmdQueue;
-        // Create a command queue using clCreateCommandQueue(),
-        // and associate it with the device you want to execute
-        // on
-        // Command queue properties
-        cl_queue_properties queue_properties[] = {CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0};
-        cmdQueue = clCreateCommandQueueWithProperties(context, devices[0], queue_properties, &status);
-        evaluateReturnStatus(status);
-
-        //***************************************************
-        // STEP 5: Create device buffers
-        //***************************************************
-        cl_mem YCCC_d;   // output buffer
-        cl_mem YCCC_dpcm_d;   // input buffer
-        cl_mem bayerGB_d;   // output buffer
-        size_t iNumElements         = 4 * (height * width);
-        size_t datasize_YCCC_d      = sizeof(std::int16_t) * iNumElements;
-        size_t datasize_YCCC_dpcm_d = sizeof(std::int16_t) * iNumElements;
-        size_t datasize_BayerGB     = 2 * width * 2 * height;
-        YCCC_d                      = clCreateBuffer(context, CL_MEM_READ_WRITE, datasize_YCCC_d, NULL, &status);
-        evaluateReturnStatus(status);
-        YCCC_dpcm_d = clCreateBuffer(context, CL_MEM_READ_WRITE, datasize_YCCC_dpcm_d, NULL, &status);
-        evaluateReturnStatus(status);
-        bayerGB_d = clCreateBuffer(context, CL_MEM_WRITE_ONLY, datasize_BayerGB, NULL, &status);
-
-        //***************************************************
-        // STEP 6: Create a program object for the context
-        //***************************************************
-
-        FILE* programHandle;   // File that contains kernel functions
-        size_t programSize;
-        char* programBuffer;
-        cl_program cpProgram;
-
-        std::filesystem::path cwd = std::filesystem::current_path();
-        std::cout << "Current working dir: " << cwd << std::endl;
-
-        // Construct the full path to the kernel file
-        std::filesystem::path kernelFilePath = cwd / "OpenCL_sources/kernels.cl";
-        std::cout << "Kernel file will be searched for at: " << kernelFilePath << std::endl;
-
-        programHandle = fopen(kernelFilePath.string().c_str(), "rb");
-        // programHandle = fopen("OpenCL_sources/kernel_dpcm_row.cl", "r");
-        fseek(programHandle, 0, SEEK_END);
-        programSize = ftell(programHandle);
-        rewind(programHandle);
-
-        printf("Program size = %llu B \n", programSize);
-
-        // 6 b: read the kernel source into the buffer programBuffer
-        //      add null-termination-required by clCreateProgramWithSource
-        programBuffer = (char*)malloc(programSize + 1);
-
-        programBuffer[programSize] = '\0';   // add null-termination
-        fread(programBuffer, sizeof(char), programSize, programHandle);
-        fclose(programHandle);
-
-        // 6 c: Create the program from the source
-        //
-        cpProgram = clCreateProgramWithSource(context, 1, (const char**)&programBuffer, &programSize, &status);
-        evaluateReturnStatus(status);
-        free(programBuffer);
-        //***************************************************
-        // STEP 7: Build the program
-        //***************************************************
-
-        status = clBuildProgram(cpProgram, 0, NULL, NULL, NULL, NULL);
-
-        if(status != CL_SUCCESS) {
-            size_t len;
-
-            printf("Error: Failed to build program executable!\n");
-            // Firstly, get the length of the error message:
-            status = clGetProgramBuildInfo(cpProgram, devices[0], CL_PROGRAM_BUILD_LOG, 0, NULL, &len);
-            evaluateReturnStatus(status);
-
-            // allocate enough memory to store the error message:
-            char* err_buffer = (char*)malloc(len * sizeof(char));
-
-            // Secondly, copy the error message into buffer
-            status =
-               clGetProgramBuildInfo(cpProgram, devices[0], CL_PROGRAM_BUILD_LOG, len * sizeof(char), err_buffer, NULL);
-            evaluateReturnStatus(status);
-            printf("%s\n", err_buffer);
-            free(err_buffer);
-            exit(1);
-        }
-
-        //***************************************************
-        // STEP 8: Create and compile the kernel
-        //***************************************************
-
-        cl_kernel ckDpcmAcrossRows;
-        // Create the kernel
-        ckDpcmAcrossRows = clCreateKernel(cpProgram, "dpcm_across_rows", &status);
-        evaluateReturnStatus(status);
-        cl_kernel ckYcccToBayerGB;
-        ckYcccToBayerGB = clCreateKernel(cpProgram, "yccc_to_bayergb_8bit", &status);
-        evaluateReturnStatus(status);
-
         //***************************************************
         // OPENCL NOW READY TO EXECUTE
         //***************************************************
@@ -1709,10 +2495,12 @@ struct DecoderBase {
 
         std::uint32_t A[] = {A_init, A_init, A_init, A_init};
         std::uint32_t N   = N_START;
-        std::vector<std::int16_t> YCCC_h(4 * (height * width), 255);
-        std::vector<std::int16_t> YCCC_prev_debug(4 * (height * width));
-        std::int16_t YCCC_prev[] = {0, 0, 0, 0};
-        std::vector<std::int16_t> YCCC_dpcm_h(4 * (height * width));
+        // only first column of YCCC_h is uploaded meaningful, the rest is calculated by the kernel
+        DecodeWorkspace_s localWorkspace;
+        DecodeWorkspace_s& ws     = workspace == nullptr ? localWorkspace : *workspace;
+        std::int16_t* YCCC_h      = DecodeWorkspace_s::grow(ws.YCCC, 4 * (height * width));
+        std::int16_t* YCCC_dpcm_h = DecodeWorkspace_s::grow(ws.YCCC_dpcm, 4 * (height * width));
+        std::int16_t YCCC_prev[]  = {0, 0, 0, 0};
 
         // 1.) decode 4 seed pixels
         // Seed pixel
@@ -1722,11 +2510,8 @@ struct DecoderBase {
             //     std::uint32_t lastBit = fetchBit(reader);
             //     posValue[ch]          = (posValue[ch] << 1) | lastBit;
             // }
-            (void)reader.fetchBit_buffered();   // read delimiter
-            for(std::uint32_t n = 0; n < k_seed; n++) {   // LSB first
-                std::uint32_t lastBit = reader.fetchBit_buffered();
-                posValue[ch]          = posValue[ch] | ((std::uint16_t)lastBit << n);
-            };
+            (void)reader.fetchBits(1);   // read delimiter
+            posValue[ch]   = (std::uint16_t)reader.fetchBitsLSBfirst(k_seed);
             YCCC_h[0 + ch] = DecoderBase::fromAbs(posValue[ch]);
         }
 
@@ -1734,162 +2519,18 @@ struct DecoderBase {
             A[ch] += YCCC_h[0 + ch] > 0 ? YCCC_h[0 + ch] : -YCCC_h[0 + ch];
         }
 
-        memcpy(YCCC_prev, YCCC_h.data(), sizeof(YCCC_prev));
+        memcpy(YCCC_prev, YCCC_h, sizeof(YCCC_prev));
 
         YCCC_dpcm_h[0] = YCCC_h[0];
         YCCC_dpcm_h[1] = YCCC_h[1];
         YCCC_dpcm_h[2] = YCCC_h[2];
         YCCC_dpcm_h[3] = YCCC_h[3];
 
-#    ifdef USE_LUT
-
-        std::uint8_t offset_i = 0;
-        std::uint8_t address  = 0;
-        // Get DPCM from binary bitstream (reverse Golomb Rice)
-        for(std::size_t idx = 1; idx < height * width; idx++) {
-
-            // 2.) AGOR
-            std::uint16_t quotient[]  = {0, 0, 0, 0};
-            std::uint16_t remainder[] = {0, 0, 0, 0};
-            std::uint16_t k[]         = {0, 0, 0, 0};
-            //std::int16_t dpcm_curr[]  = {0, 0, 0, 0};
-
-            for(std::size_t ch = 0; ch < 4; ch++) {
-                for(std::size_t it = 0; it < (bpp_a + 2); it++) {
-                    if((N << k[ch]) < A[ch]) {
-                        k[ch] = k[ch] + 1;
-                    } else {
-                        k[ch] = k[ch];
-                    }
-                }
-                std::uint32_t lastBit;
-
-                std::uint16_t absVal = 0;
-                do {   // decode quotient: unary coding
-                    lastBit = reader.fetchBit_buffered();
-                    if(lastBit == 1) {   //
-                        quotient[ch]++;
-                    }
-                } while(lastBit == 1 && quotient[ch] < unaryMaxWidth);
-
-                lut_data_t lut_data;
-                lut(bitStream[address], offset_i, k[ch], &lut_data);
-
-                if(lut_data.q_done == false) {
-                    quotient[ch] = lut_data.quotient;
-                    address++;
-                    // offset_i = lut_data.offset_o;
-                    auto quotient_i = quotient[ch];
-                    lut(bitStream[address], 0, k[ch], quotient_i, &lut_data);
-                    quotient[ch] += lut_data.quotient;
-                    if(quotient[ch] >= unaryMaxWidth) {
-                        absVal = lut_data.truncated_coding_value << lut_data.t_count;
-                        while(lut_data.t_count > 0) {
-                            address++;
-                            r_lut(bitStream[address], lut_data.t_count, &lut_data);
-                            absVal += lut_data.remainder << lut_data.t_count;
-                        }
-                    } else {
-                        remainder[ch] = lut_data.remainder << lut_data.r_count;
-                        while(lut_data.r_count > 0) {
-                            address++;
-                            r_lut(bitStream[address], lut_data.r_count, &lut_data);
-                            remainder[ch] += lut_data.remainder << lut_data.r_count;
-                        }
-
-                        absVal = quotient[ch] << k[ch] + remainder[ch];
-                    }
-                    offset_i = lut_data.offset_o;
-
-                    // else if(lut_data.quotient >= unaryMaxWidth) {   // whole byte are 1s
-                    //     address++;
-                    //     r_lut(bitStream[address], k_seed, &lut_data);
-                    //     absVal = lut_data.remainder << lut_data.r_count;
-
-                    //     // address++;
-                    //     // r_lut(
-                    //     //    bitStream[address],
-                    //     //    lut_data.r_count,
-                    //     //    &lut_data);   // this only work for k_seed <= 16; otherwise make a while loop to iterate as long as r_count > 0
-                    //     // absVal += lut_data.remainder;
-                    //     while(lut_data.t_count > 0) {
-                    //         address++;
-                    //         r_lut(bitStream[address], lut_data.t_count, &lut_data);
-                    //         absVal += lut_data.remainder << lut_data.t_count;
-                    //     }
-                    //     offset_i = lut_data.offset_o;
-                } else {
-                    remainder[ch] = lut_data.remainder << lut_data.r_count;
-                    while(lut_data.r_count > 0) {
-                        address++;
-                        r_lut(bitStream[address], lut_data.r_count, &lut_data);
-                        remainder[ch] += lut_data.remainder << lut_data.r_count;
-                    }
-                    absVal = quotient[ch] << k[ch] + remainder[ch];
-                }
-
-                /* m_unaryMaxWidth * '1' -> indicates binary coding of positive value */
-                if(quotient[ch] >= unaryMaxWidth) {
-                    // for(std::uint32_t n = 0; n < k_seed; n++) {   //decode remainder
-                    //     lastBit = reader.fetchBit_buffered();
-                    //     absVal  = absVal | ((std::uint16_t)lastBit << n); /* LSB first */
-                    //     // absVal  = (absVal << 1) | lastBit; /* MSB first*/
-                    // };
-                    // absVal = reader.getMSBfirst(reader.fetchBits_buffered(k_seed), k_seed);
-                    absVal = getMSBfirst(reader.fetchBits_buffered(k_seed), k_seed);
-                    // absVal = reader.fetchBits_buffered(k_seed);
-                    // auto temp = absVal;
-                } else {
-                    // if(k[ch] == 0) {
-                    //     absVal = quotient[ch];
-                    // } else {
-                    // for(std::uint32_t n = 0; n < k[ch]; n++) {   //decode remainder
-                    //     lastBit       = reader.fetchBit_buffered();
-                    //     remainder[ch] = remainder[ch] | ((std::uint16_t)lastBit << n); /* LSB first*/
-                    //     // remainder[ch] = (remainder[ch] << 1) | lastBit; /* MSB first*/
-                    // };
-                    // remainder[ch] = (uint16_t)reader.fetchBits_buffered(k[ch]);
-                    // remainder[ch] = (uint16_t)reader.getMSBfirst(reader.fetchBits_buffered(k[ch]), k[ch]);
-                    remainder[ch] = (uint16_t)getMSBfirst(reader.fetchBits_buffered(k[ch]), k[ch]);
-                    // auto temp = remainder[ch];
-                    // auto temp_2 = reader.getMSBfirst(temp, k[ch]);
-                    // absVal = quotient[ch] * (1 << k[ch]) + remainder[ch];
-                    absVal = (quotient[ch] << k[ch]) + remainder[ch];
-                    // }
-                }
-
-                // TODO: OPPORTUNITY: unsigned absVal to signed dpcm can also be done in parallel
-                YCCC_dpcm_h[4 * idx + ch] = DecoderBase::fromAbs(absVal);
-            }
-
-            A[0] += YCCC_dpcm_h[4 * idx + 0] > 0 ? YCCC_dpcm_h[4 * idx + 0] : -YCCC_dpcm_h[4 * idx + 0];
-            A[1] += YCCC_dpcm_h[4 * idx + 1] > 0 ? YCCC_dpcm_h[4 * idx + 1] : -YCCC_dpcm_h[4 * idx + 1];
-            A[2] += YCCC_dpcm_h[4 * idx + 2] > 0 ? YCCC_dpcm_h[4 * idx + 2] : -YCCC_dpcm_h[4 * idx + 2];
-            A[3] += YCCC_dpcm_h[4 * idx + 3] > 0 ? YCCC_dpcm_h[4 * idx + 3] : -YCCC_dpcm_h[4 * idx + 3];
-
-            N += 1;
-            if(N >= N_threshold) {
-                N >>= 1;
-                A[0] >>= 1;
-                A[1] >>= 1;
-                A[2] >>= 1;
-                A[3] >>= 1;
-            }
-            A[0] = A[0] < A_MIN ? A_MIN : A[0];
-            A[1] = A[1] < A_MIN ? A_MIN : A[1];
-            A[2] = A[2] < A_MIN ? A_MIN : A[2];
-            A[3] = A[3] < A_MIN ? A_MIN : A[3];
-        }
-
-#    else
         // Get DPCM from binary bitstream (reverse Golomb Rice)
         for(std::size_t idx = 1; idx < height * width; idx++) {
 
             // 2.) AGOR
-            std::uint16_t quotient[]  = {0, 0, 0, 0};
-            std::uint16_t remainder[] = {0, 0, 0, 0};
-            std::uint16_t k[]         = {0, 0, 0, 0};
-            //std::int16_t dpcm_curr[]  = {0, 0, 0, 0};
+            std::uint16_t k[] = {0, 0, 0, 0};
 
             for(std::size_t ch = 0; ch < 4; ch++) {
                 for(std::size_t it = 0; it < (bpp_a + 2); it++) {
@@ -1899,45 +2540,9 @@ struct DecoderBase {
                         k[ch] = k[ch];
                     }
                 }
-                std::uint32_t lastBit;
-
-                std::uint16_t absVal = 0;
-                do {   // decode quotient: unary coding
-                    lastBit = reader.fetchBit_buffered();
-                    if(lastBit == 1) {   //
-                        quotient[ch]++;
-                    }
-                } while(lastBit == 1 && quotient[ch] < unaryMaxWidth);
 
                 /* m_unaryMaxWidth * '1' -> indicates binary coding of positive value */
-                if(quotient[ch] >= unaryMaxWidth) {
-                    // for(std::uint32_t n = 0; n < k_seed; n++) {   //decode remainder
-                    //     lastBit = reader.fetchBit_buffered();
-                    //     absVal  = absVal | ((std::uint16_t)lastBit << n); /* LSB first */
-                    //     // absVal  = (absVal << 1) | lastBit; /* MSB first*/
-                    // };
-                    // absVal = reader.getMSBfirst(reader.fetchBits_buffered(k_seed), k_seed);
-                    absVal = getMSBfirst(reader.fetchBits_buffered(k_seed), k_seed);
-                    // absVal = reader.fetchBits_buffered(k_seed);
-                    // auto temp = absVal;
-                } else {
-                    // if(k[ch] == 0) {
-                    //     absVal = quotient[ch];
-                    // } else {
-                    // for(std::uint32_t n = 0; n < k[ch]; n++) {   //decode remainder
-                    //     lastBit       = reader.fetchBit_buffered();
-                    //     remainder[ch] = remainder[ch] | ((std::uint16_t)lastBit << n); /* LSB first*/
-                    //     // remainder[ch] = (remainder[ch] << 1) | lastBit; /* MSB first*/
-                    // };
-                    // remainder[ch] = (uint16_t)reader.fetchBits_buffered(k[ch]);
-                    // remainder[ch] = (uint16_t)reader.getMSBfirst(reader.fetchBits_buffered(k[ch]), k[ch]);
-                    remainder[ch] = (uint16_t)getMSBfirst(reader.fetchBits_buffered(k[ch]), k[ch]);
-                    // auto temp = remainder[ch];
-                    // auto temp_2 = reader.getMSBfirst(temp, k[ch]);
-                    // absVal = quotient[ch] * (1 << k[ch]) + remainder[ch];
-                    absVal = (quotient[ch] << k[ch]) + remainder[ch];
-                    // }
-                }
+                std::uint16_t absVal = (std::uint16_t)reader.fetchGolombRice(k[ch], unaryMaxWidth, k_seed);
 
                 // TODO: OPPORTUNITY: unsigned absVal to signed dpcm can also be done in parallel
                 YCCC_dpcm_h[4 * idx + ch] = DecoderBase::fromAbs(absVal);
@@ -1962,8 +2567,6 @@ struct DecoderBase {
             A[3] = A[3] < A_MIN ? A_MIN : A[3];
         }
 
-#    endif
-
 #    ifdef TIMING_EN
         std::chrono::steady_clock::time_point end_parsing = std::chrono::steady_clock::now();
 #    endif
@@ -2000,13 +2603,13 @@ struct DecoderBase {
            CL_FALSE,
            0,
            datasize_YCCC_dpcm_d,
-           YCCC_dpcm_h.data(),
+           YCCC_dpcm_h,
            0,
            NULL,
            NULL);
         evaluateReturnStatus(status);
         // write full YCCC values (first row already calculated) to global GPU memory
-        status = clEnqueueWriteBuffer(cmdQueue, YCCC_d, CL_FALSE, 0, datasize_YCCC_d, YCCC_h.data(), 0, NULL, NULL);
+        status = clEnqueueWriteBuffer(cmdQueue, YCCC_d, CL_FALSE, 0, datasize_YCCC_d, YCCC_h, 0, NULL, NULL);
         evaluateReturnStatus(status);
 
 #    ifdef TIMING_EN
@@ -2096,7 +2699,7 @@ struct DecoderBase {
         // Synchronous/blocking read of results
         // Read back full YCCC values
         // TODO: remove this because it is not actually necesarry
-        // status = clEnqueueReadBuffer(cmdQueue, YCCC_d, CL_TRUE, 0, datasize_YCCC_d, YCCC_h.data(), 0, NULL, NULL);
+        // status = clEnqueueReadBuffer(cmdQueue, YCCC_d, CL_TRUE, 0, datasize_YCCC_d, YCCC_h, 0, NULL, NULL);
         // evaluateReturnStatus(status);
 
         //***************************************************
@@ -2193,30 +2796,7 @@ struct DecoderBase {
         // }
         // wf.close();
 
-        //***************************************************
-        // STEP 13: Release OpenCL resources
-        //***************************************************
-
-        if(ckDpcmAcrossRows)
-            clReleaseKernel(ckDpcmAcrossRows);
-        if(cpProgram)
-            clReleaseProgram(cpProgram);
-        if(cmdQueue)
-            clReleaseCommandQueue(cmdQueue);
-        if(context)
-            clReleaseContext(context);
-        if(YCCC_d)
-            clReleaseMemObject(YCCC_d);
-        if(YCCC_dpcm_d)
-            clReleaseMemObject(YCCC_dpcm_d);
-
-        if(ckYcccToBayerGB)
-            clReleaseKernel(ckYcccToBayerGB);
-        if(bayerGB_d)
-            clReleaseMemObject(bayerGB_d);
-
-        delete[] platforms;
-        delete[] devices;
+        // OpenCL resources are owned by OpenCLEngine and reused by the next call
 
 #    ifdef TIMING_EN
         std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
@@ -2247,6 +2827,23 @@ struct DecoderBase {
                         .count()
                   << "[ms]" << std::endl;
         std::cout << std::endl;
+
+        m_stageTimes              = StageTimes_s{};
+        m_stageTimes.memBitstream = std::chrono::duration_cast<std::chrono::microseconds>(
+                                       end_dpcm_2_bayer_memory - begin_dpcm_2_bayer_memory)
+                                       .count();
+        m_stageTimes.parsing =
+           std::chrono::duration_cast<std::chrono::microseconds>(end_parsing - begin_parsing).count();
+        m_stageTimes.dpcmToYccc = std::chrono::duration_cast<std::chrono::microseconds>(
+                                     end_dpcm_2_bayer_kernel - begin_dpcm_2_bayer_kernel)
+                                     .count();
+        m_stageTimes.ycccToBayer = std::chrono::duration_cast<std::chrono::microseconds>(
+                                      end_yccc_2_bayer_kernel - begin_yccc_2_bayer_kernel)
+                                      .count();
+        m_stageTimes.memDeviceToHost = std::chrono::duration_cast<std::chrono::microseconds>(
+                                          end_yccc_2_bayer_memory - begin_yccc_2_bayer_memory)
+                                          .count();
+        m_stageTimes.total = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
 #    endif
 
         printf("OpenCL: Parallel decoding finished\n");
@@ -2255,38 +2852,35 @@ struct DecoderBase {
 
 #endif
 
-    // template<typename T>
+    /**
+     * Writes header fields (only non zero ones) and image data to fileName with a single gather write.
+     * Existing file is overwritten.
+     */
     static STATUS_t exportImage(
        const char* fileName,
-       //    std::uint16_t* data,
-       std::uint8_t* data,
+       const std::uint8_t* data,
        std::size_t data_size_bytes,
        std::uint64_t header,
        std::uint64_t roi,
        std::uint64_t timestamp)
     {
-        std::ofstream wf(fileName, std::ios::out | std::ios::binary);
-        if(!wf) {
-            return BASE_CANNOT_OPEN_OUTPUT_FILE;
-        }
-
+        /* Little endian order */
+        std::span<std::uint8_t const> parts[4];
+        std::size_t nrOfParts = 0;
         if(timestamp) {
-            wf.write((char*)&timestamp, 8); /* Little endian order */
+            parts[nrOfParts++] = {(const std::uint8_t*)&timestamp, 8};
         }
-
         if(roi) {
-            wf.write((char*)&roi, 8); /* Little endian order */
+            parts[nrOfParts++] = {(const std::uint8_t*)&roi, 8};
         }
-
         if(header) {
-            wf.write((char*)&header, 8); /* Little endian order */
+            parts[nrOfParts++] = {(const std::uint8_t*)&header, 8};
         }
+        parts[nrOfParts++] = {data, data_size_bytes};
 
-        /* Little endian order*/
-        wf.write((char*)data, data_size_bytes);
-
-        wf.close();
-
+        if(!Helpers::writeFileGather(fileName, {parts, nrOfParts})) {
+            return BASE_CANNOT_OPEN_OUTPUT_FILE;
+        }
         return BASE_SUCCESS;
     }
 
@@ -2294,7 +2888,7 @@ struct DecoderBase {
     static STATUS_t exportImage(
        const char* folderName,
        const char* fileName,
-       std::uint8_t* data,
+       const std::uint8_t* data,
        std::size_t data_size_bytes,
        std::uint64_t header,
        std::uint64_t roi,
@@ -2307,7 +2901,7 @@ struct DecoderBase {
         return DecoderBase::exportImage(path, data, data_size_bytes, header, roi, timestamp);
     }
 
-    static STATUS_t importBitstream(const char* fileName, std::unique_ptr<std::vector<std::uint8_t>>& outData);
+    static STATUS_t importBitstream(const char* fileName, std::unique_ptr<MappedFile>& outData);
 
     /**
    * Get DPCM value from Absolute value.
@@ -1,15 +1,49 @@
 
 #include "Encoder.hpp"
 #include "Channels.hpp"
+#include "ColorTransform.hpp"
+#include <algorithm>
+#include <atomic>
 #include <bitset>
 #include <chrono>
+#include <thread>
 
 Writter_s::Writter_s(){};
-Writter_s::Writter_s(std::ofstream* pWf, std::uint32_t* pBfr, std::size_t* pBitCnt, std::size_t* pBytesCnt)
+Writter_s::Writter_s(
+   std::ofstream* pWf,
+   std::uint64_t* pBfr,
+   std::size_t* pBitCnt,
+   std::size_t* pBytesCnt,
+   std::vector<std::uint8_t>* pOutBfr)
    : m_pWf(pWf)
    , m_pBfr(pBfr)
    , m_pBitCnt(pBitCnt)
-   , m_pBytesCnt(pBytesCnt){};
+   , m_pBytesCnt(pBytesCnt)
+   , m_pOutBfr(pOutBfr){};
+Writter_s::Writter_s(
+   std::uint64_t* pBfr,
+   std::size_t* pBitCnt,
+   std::size_t* pBytesCnt,
+   std::span<std::uint8_t> outSpan)
+   : m_pWf(nullptr)
+   , m_pBfr(pBfr)
+   , m_pBitCnt(pBitCnt)
+   , m_pBytesCnt(pBytesCnt)
+   , m_pOutBfr(nullptr)
+   , m_outSpan(outSpan){};
+
+/**
+ * Reverse order of lowest n bits (n <= 32). Higher bits are discarded.
+*/
+static inline std::uint32_t reverseBits(std::uint32_t v, std::size_t n)
+{
+    v = ((v >> 1) & 0x55555555) | ((v & 0x55555555) << 1);
+    v = ((v >> 2) & 0x33333333) | ((v & 0x33333333) << 2);
+    v = ((v >> 4) & 0x0F0F0F0F) | ((v & 0x0F0F0F0F) << 4);
+    v = ((v >> 8) & 0x00FF00FF) | ((v & 0x00FF00FF) << 8);
+    v = (v >> 16) | (v << 16);
+    return n == 0 ? 0 : v >> (32 - n);
+}
 
 /**
  * Parallel version. Encode data to binary array. Supply BAYER image.
@@ -29,6 +63,7 @@ Encoder::Encoder(
    const char* fileName,
    std::uint16_t nrOfBlocks)
    : m_pImg(pImg)
+   , m_bayerGB(pImg->getDataView())
    //    , m_width(pImg->getWidth() / 2)
    //    , m_height(pImg->getHeight() / 2)
    , m_width(width / 2)
@@ -47,6 +82,83 @@ Encoder::Encoder(
    , m_k_max(bpp + 2)
    , m_nrOfBlocks(nrOfBlocks){};
 
+/**
+ * In memory version. Encode BayerCFA frame supplied by the caller with encodeToBuffer.
+ * Nothing is read from or written to files. Compressed data always has 24 byte header.
+ */
+Encoder::Encoder(
+   std::span<std::uint16_t const> bayerGB,
+   std::size_t width,
+   std::size_t height,
+   std::uint32_t A_init,
+   std::uint32_t N_threshold,
+   std::size_t lossyBits,
+   std::size_t unaryMaxWidth,
+   std::uint8_t bpp)
+   : m_bayerGB(bayerGB)
+   , m_width(width / 2)
+   , m_height(height / 2)
+   , m_length(m_width * m_height)
+   , m_folderOut(nullptr)
+   , m_imgIdx(0)
+   , m_A_init(A_init)
+   , m_N_threshold(N_threshold)
+   , m_lossyBits(lossyBits)
+   , m_unaryMaxWidth(unaryMaxWidth)
+   , m_bpp(bpp)
+   , m_header_bytes(24)
+   , m_k_seed(bpp + 3)
+   , m_k_max(bpp + 2)
+{
+    if(bayerGB.size() != width * height) {
+        char msg[200];
+        sprintf(msg, "Encoder: frame has %zu pixels, expected %zu x %zu", bayerGB.size(), width, height);
+        throw std::runtime_error(msg);
+    }
+};
+
+/**
+ * In memory version for frames that are already in YCCC (e.g. decoded by DecoderBase::decodeToYCCC_actual when
+ * transcoding): 4 values per quadruplet, width / 2 quadruplets per row. Color transform is skipped, so the frame is
+ * encoded exactly as given. Only encodeToBuffer and encodeToBufferWithCheckpoints can be used.
+ */
+Encoder::Encoder(
+   std::span<std::int16_t const> YCCC,
+   std::size_t width,
+   std::size_t height,
+   std::uint32_t A_init,
+   std::uint32_t N_threshold,
+   std::size_t lossyBits,
+   std::size_t unaryMaxWidth,
+   std::uint8_t bpp)
+   : m_YCCC(YCCC)
+   , m_width(width / 2)
+   , m_height(height / 2)
+   , m_length(m_width * m_height)
+   , m_folderOut(nullptr)
+   , m_imgIdx(0)
+   , m_A_init(A_init)
+   , m_N_threshold(N_threshold)
+   , m_lossyBits(lossyBits)
+   , m_unaryMaxWidth(unaryMaxWidth)
+   , m_bpp(bpp)
+   , m_header_bytes(24)
+   , m_k_seed(bpp + 3)
+   , m_k_max(bpp + 2)
+{
+    if(YCCC.size() != 4 * m_length) {
+        char msg[200];
+        sprintf(
+           msg,
+           "Encoder: YCCC frame has %zu values, expected %zu for %zu x %zu",
+           YCCC.size(),
+           4 * m_length,
+           width,
+           height);
+        throw std::runtime_error(msg);
+    }
+};
+
 /**
  * Sequential and ideal version. Encode data to binary array. Supply YCCC image.
  */
@@ -135,7 +247,31 @@ std::unique_ptr<std::vector<std::size_t>> Encoder::encodeUsingMethod(Encoder::me
                    "that you have set the unaryMaxWidth parameter to maximum value (no limiting).");
             }
             if(m_pImg) {
-                return runParallelCompression();
+                return runParallelCompressionInBlocks();
+            } else {
+                throw std::runtime_error(
+                   "encodeUsingMethod(): m_pImg was not initilised through proper Encoder constructor.");
+            }
+        case Encoder::method::parallel_limited_blocks_balanced:
+            if(m_unaryMaxWidth == C_MAX_UNARY_LENGTH_FULL) {
+                throw std::runtime_error(
+                   "encodeUsingMethod(parallel_limited_blocks_balanced): You wanted to use limited unary encoding but "
+                   "it seems that you have set the unaryMaxWidth parameter to maximum value (no limiting).");
+            }
+            if(m_pImg) {
+                return runParallelCompressionInBlocks(0, true);
+            } else {
+                throw std::runtime_error(
+                   "encodeUsingMethod(): m_pImg was not initilised through proper Encoder constructor.");
+            }
+        case Encoder::method::parallel_limited_checkpoints:
+            if(m_unaryMaxWidth == C_MAX_UNARY_LENGTH_FULL) {
+                throw std::runtime_error(
+                   "encodeUsingMethod(parallel_limited_checkpoints): You wanted to use limited unary encoding but it "
+                   "seems that you have set the unaryMaxWidth parameter to maximum value (no limiting).");
+            }
+            if(m_pImg) {
+                return runParallelCompressionWithCheckpoints();
             } else {
                 throw std::runtime_error(
                    "encodeUsingMethod(): m_pImg was not initilised through proper Encoder constructor.");
@@ -221,43 +357,6 @@ std::unique_ptr<std::vector<std::size_t>> Encoder::runParallelCompression()
     return std::make_unique<std::vector<std::size_t>>(std::forward<std::vector<std::size_t>>(bytesWritten));
 }
 
-void Encoder::dumpBlockSizeToFile(char* filePath, std::vector<std::uint32_t>& blockSizes_bytes)
-{
-
-    printf("Writing block sizes to file: %s\n", filePath);
-    // for(std::uint32_t size : blockSizes_bytes) {
-    //     printf("%u \n", size);
-    // }
-    std::ofstream wf;
-    wf.open((const char*)filePath, std::ios::out | std::ios::binary);
-    if(!wf) {
-        char msg[200];
-        sprintf(msg, "Cannot open specified file: %s", filePath);
-        throw std::runtime_error(msg);
-    }
-
-    for(std::size_t i = 0; i < blockSizes_bytes.size(); i++) {
-        // wf << blockSizes_bytes[i];
-        wf.write(reinterpret_cast<const char*>(&blockSizes_bytes[i]), sizeof(std::uint32_t));
-    }
-    wf.close();
-
-    // write to .txt file
-    char txt[200];
-    sprintf(txt, "%s.txt", filePath);
-    wf.open((const char*)txt, std::ios::out);
-    if(!wf) {
-        char msg[200];
-        sprintf(msg, "Cannot open specified file: %s", txt);
-        throw std::runtime_error(msg);
-    }
-
-    for(std::size_t i = 0; i < blockSizes_bytes.size(); i++) {
-        wf << blockSizes_bytes[i] << std::endl;
-    }
-    wf.close();
-}
-
 /**
  * Encodes all 4 channels in parallel (CH1,CH2,CH3,CH4,CH1,CH2,CH3,CH4,CH1,CH2,CH3,CH4,...) but combines them in blocks for parallel decompression.
  * Instead of sequental encoding (CH1, CH1, CH1,... CH2, CH2, CH2,... CH3, CH3, CH3,... , CH4, CH4, CH4,...)
@@ -282,16 +381,17 @@ std::size_t Encoder::encodeParallelInBlocks(
    std::uint16_t gr,
    std::uint16_t nrOfBlocks)
 {
-    static std::size_t idx = 0;
-    static std::uint32_t bfr;
-    static std::size_t bitCnt;
-    static std::size_t bytesCnt;
-    static std::ofstream wf;
-    static Writter_s writter;
-    static int16_t YCCC_prev[4];
-    static int16_t YCCC_up[4];
-    static std::uint32_t A[4];
-    static std::uint32_t N;
+    auto& idx       = m_ctx.idx;
+    auto& bfr       = m_ctx.bfr;
+    auto& bitCnt    = m_ctx.bitCnt;
+    auto& bytesCnt  = m_ctx.bytesCnt;
+    auto& wf        = m_ctx.wf;
+    auto& outBfr    = m_ctx.outBfr;
+    auto& writter   = m_ctx.writter;
+    auto& YCCC_prev = m_ctx.YCCC_prev;
+    auto& YCCC_up   = m_ctx.YCCC_up;
+    auto& A         = m_ctx.A;
+    auto& N         = m_ctx.N;
 
     // if(nrOfBlocks > m_height) {
     //     throw std::runtime_error("Number of blocks cannot be greater than half of the image height.");
@@ -299,14 +399,14 @@ std::size_t Encoder::encodeParallelInBlocks(
 
     // static std::size_t fullRowsPerBlock      = (2 * m_height + (nrOfBlocks - 1)) / nrOfBlocks;
     // static std::size_t rowsPerBlock          = fullRowsPerBlock / 2;
-    static std::size_t rowsPerBlock;
-    static std::size_t blockSize_quadruplets;
-    static std::size_t blockSize_pixels;
+    auto& rowsPerBlock          = m_ctx.rowsPerBlock;
+    auto& blockSize_quadruplets = m_ctx.blockSize_quadruplets;
+    auto& blockSize_pixels      = m_ctx.blockSize_pixels;
 
     // std::size_t quadrupletsInBlock = blockSize * m_width;
-    static std::vector<std::uint32_t> blockSizes_bytes;
-    static std::size_t bytesCntPrevious;
-    static std::size_t idxPrevious;
+    auto& blockSizes_bytes = m_ctx.blockSizes_bytes;
+    auto& bytesCntPrevious = m_ctx.bytesCntPrevious;
+    auto& idxPrevious      = m_ctx.idxPrevious;
 
     if(idx == 0) {
         printf("Width: %zu, Height: %zu\n", m_width, m_height);
@@ -348,138 +448,18 @@ std::size_t Encoder::encodeParallelInBlocks(
             throw std::runtime_error(msg);
         }
 
+        outBfr.clear();
+        outBfr.reserve(WRITTER_CHUNK_SIZE + 64);
+
         writter.m_pWf       = &wf;
         writter.m_pBfr      = &bfr;
         writter.m_pBitCnt   = &bitCnt;
         writter.m_pBytesCnt = &bytesCnt;
+        writter.m_pOutBfr   = &outBfr;
 
-        // if header_bytes = 8, then write 8 byte timestamp to the beginning
-        if(m_header_bytes == 8) {
-
-            /* Timestamp: */
-            // MSB                                                                          LSB
-            // 64                 48                  32                  16                   0
-            // | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes |
-            // address : content
-            //       0 : timestampLSB
-            //       7 : timestampMSB
-
-            // std::uint64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-            //                              std::chrono::system_clock::now().time_since_epoch())
-            //                              .count();
-
-            std::uint8_t reservedBits      = 0;
-            std::uint64_t compression_info =   //
-               0LLU |   //
-               ((std::uint64_t)((std::uint8_t)reservedBits)) << 56 |   //
-               ((std::uint64_t)((std::uint8_t)m_lossyBits)) << 48 |   //
-               ((std::uint64_t)((std::uint8_t)m_bpp)) << 40 |   //
-               ((std::uint64_t)((std::uint8_t)m_unaryMaxWidth)) << 32 |   //
-               ((std::uint64_t)((std::uint16_t)2 * m_height)) << 16 |   //
-               ((std::uint64_t)((std::uint16_t)2 * m_width)) << 0;
-            // clang-format on
-            for(std::size_t s = 0; s < 64; s += 8) {
-                printf("Byte %zu: %02X\n", s / 8, (uint8_t)(compression_info >> s));
-            }
-            printf("Compression data: 0x%08llX\n", compression_info);
-
-            pushHeader(writter, compression_info);
-
-        } else if(m_header_bytes == 16) {
-            std::uint64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                         std::chrono::system_clock::now().time_since_epoch())
-                                         .count();
-
-            pushHeader(writter, timestamp);
-
-            std::cout << "Compression Image timestamp: " << timestamp << std::endl;
-
-            /* Compression info: */
-            //  MSB                                                                          LSB
-            // 64                 48                  32                  16                   0
-            // | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes |
-            // | Reservd ' losyBts | unary H ' unary L | heigh H ' heigh L | width H ' width L |
-            // address : content
-            //       0 : width L
-            //       1 : width H
-            //       2 : height L
-            //       3 : height H
-            //       4 : unary L
-            //       5 : unary H
-            //       6 : lossy bits
-            //       7 : reserved
-
-            std::uint8_t reservedBits = 0;
-            // clang-format off
-            std::uint64_t compression_info =   //
-               0LLU                                                    |   //
-               ((std::uint64_t)((std::uint8_t)reservedBits))     << 56 |   //
-               ((std::uint64_t)((std::uint8_t)m_lossyBits))      << 48 |   //
-               ((std::uint64_t)((std::uint8_t)m_bpp))            << 40 |   //
-               ((std::uint64_t)((std::uint8_t)m_unaryMaxWidth))  << 32 |   //
-               ((std::uint64_t)((std::uint16_t)2*m_height))      << 16 |   //
-               ((std::uint64_t)((std::uint16_t)2*m_width))       << 0;
-            // clang-format on
-            for(std::size_t s = 0; s < 64; s += 8) {
-                printf("Byte %zu: %02X\n", s / 8, (uint8_t)(compression_info >> s));
-            }
-            printf("Compression data: 0x%08llX\n", compression_info);
-
-            pushHeader(writter, compression_info);
-            // wf.write((const char*)&compression_info, sizeof(compression_info));
-            // (*writter.m_pBytesCnt) += sizeof(compression_info);
-        } else if(m_header_bytes == 24) {
-            std::uint64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                         std::chrono::system_clock::now().time_since_epoch())
-                                         .count();
-
-            pushHeader(writter, timestamp);
-
-            std::cout << "Compression Image timestamp: " << timestamp << std::endl;
-            std::uint64_t roi      = 0;
-            std::uint16_t offset_y = 0;
-            std::uint16_t offset_x = 0;
-            roi = (2 * m_height & 0xFFFF) << 48 | (2 * m_width & 0xFFFF) << 32 | offset_y << 16 | offset_x;
-            pushHeader(writter, roi);
-
-            /* Compression info: */
-            //  MSB                                                                          LSB
-            // 64                 48                  32                  16                   0
-            // | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes |
-            // | Reservd ' losyBts | unary H ' unary L | heigh H ' heigh L | width H ' width L |
-            // address : content
-            //       0 : width L
-            //       1 : width H
-            //       2 : height L
-            //       3 : height H
-            //       4 : unary L
-            //       5 : unary H
-            //       6 : lossy bits
-            //       7 : reserved
-
-            std::uint8_t reservedBits = 0;
-            // clang-format off
-            std::uint64_t compression_info =   //
-               0LLU                                                    |   //
-               ((std::uint64_t)((std::uint8_t)reservedBits))     << 56 |   //
-               ((std::uint64_t)((std::uint8_t)m_lossyBits))      << 48 |   //
-               ((std::uint64_t)((std::uint8_t)m_bpp))            << 40 |   //
-               ((std::uint64_t)((std::uint8_t)m_unaryMaxWidth))  << 32 |   //
-               ((std::uint64_t)((std::uint16_t)2*m_height))      << 16 |   //
-               ((std::uint64_t)((std::uint16_t)2*m_width))       << 0;
-            // clang-format on
-            for(std::size_t s = 0; s < 64; s += 8) {
-                printf("Byte %zu: %02X\n", s / 8, (uint8_t)(compression_info >> s));
-            }
-            printf("Compression data: 0x%08llX\n", compression_info);
-
-            pushHeader(writter, compression_info);
-
-        }
-
-        else {
-            printf("No header will be added to the compressed file.\n");
-        }
+        // block sizes are not known yet, index is written with zeros and rewritten after the last block
+        pushFileHeader(writter, C_HEADER_FLAG_BLOCK_INDEX);
+        pushBlockIndex(writter, blockSizes_bytes);
 
         for(std::size_t ch = 0; ch < 4; ch++) {
             YCCC_prev[ch] = 0;
@@ -516,6 +496,11 @@ std::size_t Encoder::encodeParallelInBlocks(
         blockSizes_bytes[write_idx] = bytesCnt - bytesCntPrevious;
         bytesCntPrevious            = bytesCnt;
         idxPrevious                 = idx;
+        // reset adaptive state, so that each block can be decoded independently
+        for(std::size_t ch = 0; ch < 4; ch++) {
+            A[ch] = m_A_init;
+        }
+        N = N_START;
         // encode seed pixel
         // update YCCC_prev
         encodeParallelOneQuadrupleSeedPixel(gb, b, r, gr, YCCC_prev, A, writter);
@@ -523,26 +508,23 @@ std::size_t Encoder::encodeParallelInBlocks(
         idx++;
     } else if(idx % m_width == 0) {   // new row
         // provide YCCC_up pixel value. YCCC_up is then updated with new value.
-        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_up, A, N, m_N_threshold, 0, writter);
+        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_up, A, N, 0, writter);
         memcpy(YCCC_prev, YCCC_up, sizeof(YCCC_prev));   // Copy first pixel of a row to YCCC_prev.
         idx++;
     } else if(idx == (m_length - 4)) {   // fourth-to-last pixel
-        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, m_N_threshold, 1, writter);
+        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, 1, writter);
         idx++;
     } else if(idx == (m_length - 3)) {   // third-to-last pixel
-        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, m_N_threshold, 1, writter);
+        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, 1, writter);
         idx++;
     } else if(idx == (m_length - 2)) {   // second-to-last pixel
-        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, m_N_threshold, 1, writter);
+        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, 1, writter);
         idx++;
     } else if(idx == (m_length - 1)) {   // last pixel
-        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, m_N_threshold, 1, writter);
+        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, 1, writter);
         flushBitstream(writter);
         wf.close();
 
-        char path[200];
-        sprintf(path, "%s/compressed/%s%02zu_%04u_blockSizes.bin", m_folderOut, m_fileName, m_imgIdx, nrOfBlocks);
-
         std::size_t bytesCnt = *writter.m_pBytesCnt;
         // std::size_t write_idx = (idx + 1) / blockSize_quadruplets - 1; // old way
 
@@ -557,11 +539,30 @@ std::size_t Encoder::encodeParallelInBlocks(
         printf("end: pixelsWritten: %zu\n", (idx + 1 - idxPrevious) * 4);
 
         blockSizes_bytes[write_idx] = bytesCnt - bytesCntPrevious;
-        dumpBlockSizeToFile(path, blockSizes_bytes);
+
+        std::uint64_t indexBfr    = 0;
+        std::size_t indexBitCnt   = 0;
+        std::size_t indexBytesCnt = m_header_bytes;   // padding of the index depends on its file offset
+        std::vector<std::uint8_t> indexOutBfr;
+        Writter_s indexWritter{nullptr, &indexBfr, &indexBitCnt, &indexBytesCnt, &indexOutBfr};
+        pushBlockIndex(indexWritter, blockSizes_bytes);
+
+        char path[200];
+        sprintf(path, "%s/compressed/%s%02zu_%04u_blocks.bin", m_folderOut, m_fileName, m_imgIdx, nrOfBlocks);
+        std::fstream wf_index(path, std::ios::in | std::ios::out | std::ios::binary);
+        if(!wf_index) {
+            char msg[200];
+            sprintf(msg, "Cannot open specified file: %s", path);
+            throw std::runtime_error(msg);
+        }
+        wf_index.seekp(m_header_bytes);
+        wf_index.write((const char*)indexOutBfr.data(), indexOutBfr.size());
+        wf_index.close();
+
         idx        = 0;
         m_fileSize = *writter.m_pBytesCnt;
     } else {
-        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, m_N_threshold, 0, writter);
+        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, 0, writter);
         idx++;
     }
 
@@ -587,16 +588,17 @@ std::size_t Encoder::encodeParallelInBlocks(
 */
 std::size_t Encoder::encodeParallel(std::uint16_t gb, std::uint16_t b, std::uint16_t r, std::uint16_t gr)
 {
-    static std::size_t idx = 0;
-    static std::uint32_t bfr;
-    static std::size_t bitCnt;
-    static std::size_t bytesCnt;
-    static std::ofstream wf;
-    static Writter_s writter;
-    static int16_t YCCC_prev[4];
-    static int16_t YCCC_up[4];
-    static std::uint32_t A[4];
-    static std::uint32_t N;
+    auto& idx       = m_ctx.idx;
+    auto& bfr       = m_ctx.bfr;
+    auto& bitCnt    = m_ctx.bitCnt;
+    auto& bytesCnt  = m_ctx.bytesCnt;
+    auto& wf        = m_ctx.wf;
+    auto& outBfr    = m_ctx.outBfr;
+    auto& writter   = m_ctx.writter;
+    auto& YCCC_prev = m_ctx.YCCC_prev;
+    auto& YCCC_up   = m_ctx.YCCC_up;
+    auto& A         = m_ctx.A;
+    auto& N         = m_ctx.N;
 
     if(idx == 0) {
         // open new file
@@ -615,138 +617,16 @@ std::size_t Encoder::encodeParallel(std::uint16_t gb, std::uint16_t b, std::uint
             throw std::runtime_error(msg);
         }
 
+        outBfr.clear();
+        outBfr.reserve(WRITTER_CHUNK_SIZE + 64);
+
         writter.m_pWf       = &wf;
         writter.m_pBfr      = &bfr;
         writter.m_pBitCnt   = &bitCnt;
         writter.m_pBytesCnt = &bytesCnt;
+        writter.m_pOutBfr   = &outBfr;
 
-        // if header_bytes = 8, then write 8 byte timestamp to the beginning
-        if(m_header_bytes == 8) {
-
-            /* Timestamp: */
-            // MSB                                                                          LSB
-            // 64                 48                  32                  16                   0
-            // | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes |
-            // address : content
-            //       0 : timestampLSB
-            //       7 : timestampMSB
-
-            // std::uint64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-            //                              std::chrono::system_clock::now().time_since_epoch())
-            //                              .count();
-
-            std::uint8_t reservedBits      = 0;
-            std::uint64_t compression_info =   //
-               0LLU |   //
-               ((std::uint64_t)((std::uint8_t)reservedBits)) << 56 |   //
-               ((std::uint64_t)((std::uint8_t)m_lossyBits)) << 48 |   //
-               ((std::uint64_t)((std::uint8_t)m_bpp)) << 40 |   //
-               ((std::uint64_t)((std::uint8_t)m_unaryMaxWidth)) << 32 |   //
-               ((std::uint64_t)((std::uint16_t)2 * m_height)) << 16 |   //
-               ((std::uint64_t)((std::uint16_t)2 * m_width)) << 0;
-            // clang-format on
-            for(std::size_t s = 0; s < 64; s += 8) {
-                printf("Byte %zu: %02X\n", s / 8, (uint8_t)(compression_info >> s));
-            }
-            printf("Compression data: 0x%08llX\n", compression_info);
-
-            pushHeader(writter, compression_info);
-
-        } else if(m_header_bytes == 16) {
-            std::uint64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                         std::chrono::system_clock::now().time_since_epoch())
-                                         .count();
-
-            pushHeader(writter, timestamp);
-
-            std::cout << "Compression Image timestamp: " << timestamp << std::endl;
-
-            /* Compression info: */
-            //  MSB                                                                          LSB
-            // 64                 48                  32                  16                   0
-            // | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes |
-            // | Reservd ' losyBts | unary H ' unary L | heigh H ' heigh L | width H ' width L |
-            // address : content
-            //       0 : width L
-            //       1 : width H
-            //       2 : height L
-            //       3 : height H
-            //       4 : unary L
-            //       5 : unary H
-            //       6 : lossy bits
-            //       7 : reserved
-
-            std::uint8_t reservedBits = 0;
-            // clang-format off
-            std::uint64_t compression_info =   //
-               0LLU                                                    |   //
-               ((std::uint64_t)((std::uint8_t)reservedBits))     << 56 |   //
-               ((std::uint64_t)((std::uint8_t)m_lossyBits))      << 48 |   //
-               ((std::uint64_t)((std::uint8_t)m_bpp))            << 40 |   //
-               ((std::uint64_t)((std::uint8_t)m_unaryMaxWidth))  << 32 |   //
-               ((std::uint64_t)((std::uint16_t)2*m_height))      << 16 |   //
-               ((std::uint64_t)((std::uint16_t)2*m_width))       << 0;
-            // clang-format on
-            for(std::size_t s = 0; s < 64; s += 8) {
-                printf("Byte %zu: %02X\n", s / 8, (uint8_t)(compression_info >> s));
-            }
-            printf("Compression data: 0x%08llX\n", compression_info);
-
-            pushHeader(writter, compression_info);
-            // wf.write((const char*)&compression_info, sizeof(compression_info));
-            // (*writter.m_pBytesCnt) += sizeof(compression_info);
-        } else if(m_header_bytes == 24) {
-            std::uint64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                         std::chrono::system_clock::now().time_since_epoch())
-                                         .count();
-
-            pushHeader(writter, timestamp);
-
-            std::cout << "Compression Image timestamp: " << timestamp << std::endl;
-            std::uint64_t roi      = 0;
-            std::uint16_t offset_y = 0;
-            std::uint16_t offset_x = 0;
-            roi = (2 * m_height & 0xFFFF) << 48 | (2 * m_width & 0xFFFF) << 32 | offset_y << 16 | offset_x;
-            pushHeader(writter, roi);
-
-            /* Compression info: */
-            //  MSB                                                                          LSB
-            // 64                 48                  32                  16                   0
-            // | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes |
-            // | Reservd ' losyBts | unary H ' unary L | heigh H ' heigh L | width H ' width L |
-            // address : content
-            //       0 : width L
-            //       1 : width H
-            //       2 : height L
-            //       3 : height H
-            //       4 : unary L
-            //       5 : unary H
-            //       6 : lossy bits
-            //       7 : reserved
-
-            std::uint8_t reservedBits = 0;
-            // clang-format off
-            std::uint64_t compression_info =   //
-               0LLU                                                    |   //
-               ((std::uint64_t)((std::uint8_t)reservedBits))     << 56 |   //
-               ((std::uint64_t)((std::uint8_t)m_lossyBits))      << 48 |   //
-               ((std::uint64_t)((std::uint8_t)m_bpp))            << 40 |   //
-               ((std::uint64_t)((std::uint8_t)m_unaryMaxWidth))  << 32 |   //
-               ((std::uint64_t)((std::uint16_t)2*m_height))      << 16 |   //
-               ((std::uint64_t)((std::uint16_t)2*m_width))       << 0;
-            // clang-format on
-            for(std::size_t s = 0; s < 64; s += 8) {
-                printf("Byte %zu: %02X\n", s / 8, (uint8_t)(compression_info >> s));
-            }
-            printf("Compression data: 0x%08llX\n", compression_info);
-
-            pushHeader(writter, compression_info);
-
-        }
-
-        else {
-            printf("No header will be added to the compressed file.\n");
-        }
+        pushFileHeader(writter);
 
         for(std::size_t ch = 0; ch < 4; ch++) {
             YCCC_prev[ch] = 0;
@@ -758,32 +638,515 @@ std::size_t Encoder::encodeParallel(std::uint16_t gb, std::uint16_t b, std::uint
 
     } else if(idx % m_width == 0) {   // new row
         // provide YCCC_up pixel value. YCCC_up is then updated with new value.
-        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_up, A, N, m_N_threshold, 0, writter);
+        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_up, A, N, 0, writter);
         memcpy(YCCC_prev, YCCC_up, sizeof(YCCC_prev));   // Copy first pixel of a row to YCCC_prev.
         idx++;
     } else if(idx == (m_length - 4)) {   // fourth-to-last pixel
-        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, m_N_threshold, 1, writter);
+        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, 1, writter);
         idx++;
     } else if(idx == (m_length - 3)) {   // third-to-last pixel
-        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, m_N_threshold, 1, writter);
+        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, 1, writter);
         idx++;
     } else if(idx == (m_length - 2)) {   // second-to-last pixel
-        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, m_N_threshold, 1, writter);
+        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, 1, writter);
         idx++;
     } else if(idx == (m_length - 1)) {   // last pixel
-        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, m_N_threshold, 1, writter);
+        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, 1, writter);
         flushBitstream(writter);
         wf.close();
         idx        = 0;
         m_fileSize = *writter.m_pBytesCnt;
     } else {
-        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, m_N_threshold, 0, writter);
+        encodeParallelOneQuadruple(gb, b, r, gr, YCCC_prev, A, N, 0, writter);
         idx++;
     }
 
     return bytesCnt;
 }
 
+/**
+ * Block parallel version of encodeParallelInBlocks. Produces the same *_blocks.bin file.
+ * Each block of rows is encoded on its own thread into its own memory buffer (encodeBlock).
+ * Buffers are then written to file one after another and the last block is padded to 16 bytes.
+ * Dump verification files are not written in this mode.
+ * @param nrOfThreads number of worker threads, 0 for all hardware threads.
+ * @param balanced splits rows to blocks of roughly equal compressed size instead (see encodeToBuffer).
+*/
+std::unique_ptr<std::vector<std::size_t>> Encoder::runParallelCompressionInBlocks(
+   std::size_t nrOfThreads,
+   bool balanced)
+{
+    if(m_nrOfBlocks == 0) {
+        throw std::runtime_error("runParallelCompressionInBlocks(): number of blocks must be greater than 0.");
+    }
+
+    std::size_t nrOfBlocks   = m_nrOfBlocks;
+    std::size_t rowsPerBlock = (m_height + (nrOfBlocks - 1)) / nrOfBlocks;
+
+    char txt[200];
+    sprintf(
+       txt,
+       "Block parallel encoding with params: imgIdx: %zu, unaryMaxWidth: %zu, A_init: %u, N_threshold: %u, "
+       "blocks: %zu, rowsPerBlock: %zu%s\n",
+       m_imgIdx,
+       m_unaryMaxWidth,
+       m_A_init,
+       m_N_threshold,
+       nrOfBlocks,
+       rowsPerBlock,
+       balanced ? " (balanced by compressed size)" : "");
+    std::cout << txt;
+
+    std::vector<std::uint8_t> outBfr;
+    std::vector<std::uint32_t> blockSizes_bytes;
+    encodeToBuffer(outBfr, blockSizes_bytes, nrOfBlocks, nrOfThreads, balanced);
+
+    char path[200];
+    sprintf(path, "%s/compressed/%s%02zu_%04zu_blocks.bin", m_folderOut, m_fileName, m_imgIdx, nrOfBlocks);
+    std::ofstream wf(path, std::ios::out | std::ios::binary);
+    if(!wf) {
+        char msg[200];
+        sprintf(msg, "Cannot open specified file: %s", path);
+        throw std::runtime_error(msg);
+    }
+    wf.write((const char*)outBfr.data(), outBfr.size());
+    wf.close();
+
+    std::vector<std::size_t> bytesWritten(1);
+    bytesWritten[0] = getFileSize();
+    return std::make_unique<std::vector<std::size_t>>(std::forward<std::vector<std::size_t>>(bytesWritten));
+}
+
+/**
+ * Same as runParallelCompressionInBlocks, but image is encoded as one continuous AGOR stream with m_nrOfBlocks
+ * checkpoints (see encodeToBufferWithCheckpoints). Output file is *_blocks.bin as well, decoders tell the two apart
+ * by the header.
+*/
+std::unique_ptr<std::vector<std::size_t>> Encoder::runParallelCompressionWithCheckpoints()
+{
+    if(m_nrOfBlocks == 0) {
+        throw std::runtime_error(
+           "runParallelCompressionWithCheckpoints(): number of checkpoints must be greater than 0.");
+    }
+
+    char txt[200];
+    sprintf(
+       txt,
+       "Checkpoint encoding with params: imgIdx: %zu, unaryMaxWidth: %zu, A_init: %u, N_threshold: %u, "
+       "checkpoints: %zu\n",
+       m_imgIdx,
+       m_unaryMaxWidth,
+       m_A_init,
+       m_N_threshold,
+       m_nrOfBlocks);
+    std::cout << txt;
+
+    std::vector<std::uint8_t> outBfr;
+    encodeToBufferWithCheckpoints(outBfr, m_nrOfBlocks);
+
+    char path[200];
+    sprintf(path, "%s/compressed/%s%02zu_%04zu_blocks.bin", m_folderOut, m_fileName, m_imgIdx, m_nrOfBlocks);
+    std::ofstream wf(path, std::ios::out | std::ios::binary);
+    if(!wf) {
+        char msg[200];
+        sprintf(msg, "Cannot open specified file: %s", path);
+        throw std::runtime_error(msg);
+    }
+    wf.write((const char*)outBfr.data(), outBfr.size());
+    wf.close();
+
+    std::vector<std::size_t> bytesWritten(1);
+    bytesWritten[0] = getFileSize();
+    return std::make_unique<std::vector<std::size_t>>(std::forward<std::vector<std::size_t>>(bytesWritten));
+}
+
+/**
+ * Encodes image in <nrOfBlocks> independent blocks on <nrOfThreads> threads (0: one per core) to @param out.
+ * Content is the same as the *_blocks.bin file: header, block index (see pushBlockIndex) and blocks.
+ * Blocks have equal number of rows, or with @param balanced roughly equal compressed size: image is first encoded
+ * in equal blocks to measure compressed size of each row (see balanceBlockRows), then again in blocks split
+ * by it. First rows of the blocks are then stored in block index (C_HEADER_FLAG_BLOCK_ROWS).
+ * @param blockSizes_bytes receives size of each block (last non empty block with alignment padding).
+ * Returns number of bytes written.
+*/
+std::size_t Encoder::encodeToBuffer(
+   std::vector<std::uint8_t>& out,
+   std::vector<std::uint32_t>& blockSizes_bytes,
+   std::size_t nrOfBlocks,
+   std::size_t nrOfThreads,
+   bool balanced)
+{
+    if(nrOfBlocks == 0) {
+        throw std::runtime_error("encodeToBuffer(): number of blocks must be greater than 0.");
+    }
+    std::size_t rowsPerBlock = (m_height + (nrOfBlocks - 1)) / nrOfBlocks;
+
+    // rows of quadruplets [blockRows[b], blockRows[b + 1]) of each block, trailing blocks may be empty
+    std::vector<std::size_t> blockRows(nrOfBlocks + 1, m_height);
+    for(std::size_t block = 0; block < nrOfBlocks; block++) {
+        blockRows[block] = std::min(block * rowsPerBlock, m_height);
+    }
+
+    if(nrOfThreads == 0) {
+        nrOfThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    nrOfThreads = std::min(nrOfThreads, nrOfBlocks);
+
+    std::vector<std::vector<std::uint8_t>> blockBfrs(nrOfBlocks);
+    std::vector<std::vector<AgorCheckpoint_s>> rowCheckpoints(balanced ? nrOfBlocks : 0);
+
+    // encode blocks, with rowCheckpoints also AGOR state (bit offset) at the start of every row
+    auto encodeBlocks = [&]() {
+        std::atomic<std::size_t> nextBlock{0};
+        auto worker = [&]() {
+            for(std::size_t block = nextBlock++; block < nrOfBlocks; block = nextBlock++) {
+                std::size_t rowFirst = blockRows[block];
+                blockBfrs[block].clear();
+                if(rowFirst >= m_height) {
+                    continue;   // empty trailing block
+                }
+                std::uint64_t bfr    = 0;
+                std::size_t bitCnt   = 0;
+                std::size_t bytesCnt = 0;
+                Writter_s writter{nullptr, &bfr, &bitCnt, &bytesCnt, &blockBfrs[block]};
+                if(rowCheckpoints.empty()) {
+                    encodeBlock(rowFirst, blockRows[block + 1] - rowFirst, writter);
+                } else {
+                    encodeBlock(rowFirst, blockRows[block + 1] - rowFirst, writter, 1, &rowCheckpoints[block]);
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(nrOfThreads - 1);
+        for(std::size_t t = 1; t < nrOfThreads; t++) {
+            threads.emplace_back(worker);
+        }
+        worker();   // calling thread works as well
+        for(auto& thread : threads) {
+            thread.join();
+        }
+    };
+
+    if(balanced) {
+        // first pass: bit offset of each row end within the image, as if the blocks were one after another
+        encodeBlocks();
+        std::vector<std::uint64_t> rowEndBits(m_height, 0);
+        std::uint64_t blockStartBits = 0;
+        for(std::size_t block = 0; block < nrOfBlocks && blockRows[block] < m_height; block++) {
+            for(const AgorCheckpoint_s& checkpoint : rowCheckpoints[block]) {
+                rowEndBits[checkpoint.row - 1] = blockStartBits + checkpoint.bitOffset;
+            }
+            blockStartBits += 8 * blockBfrs[block].size();
+            rowEndBits[blockRows[block + 1] - 1] = blockStartBits;
+        }
+        blockRows = balanceBlockRows(rowEndBits, nrOfBlocks);
+        rowCheckpoints.clear();
+    }
+    encodeBlocks();
+
+    // align end of file to 16 bytes, padding belongs to the last non empty block
+    // (payload starts aligned, so it is enough to align the payload size)
+    std::size_t lastBlock   = std::lower_bound(blockRows.begin(), blockRows.end(), m_height) - blockRows.begin() - 1;
+    std::size_t payloadSize = 0;
+    for(auto& blockBfr : blockBfrs) {
+        payloadSize += blockBfr.size();
+    }
+    if(payloadSize % 16 != 0) {
+        blockBfrs[lastBlock].insert(blockBfrs[lastBlock].end(), 16 - (payloadSize % 16), 0);
+    }
+    blockSizes_bytes.resize(nrOfBlocks);
+    for(std::size_t block = 0; block < nrOfBlocks; block++) {
+        blockSizes_bytes[block] = blockBfrs[block].size();
+    }
+
+    // header and block index, then blocks
+    std::uint64_t bfr    = 0;
+    std::size_t bitCnt   = 0;
+    std::size_t bytesCnt = 0;
+    out.clear();
+    Writter_s writter{nullptr, &bfr, &bitCnt, &bytesCnt, &out};
+    if(balanced) {
+        std::vector<std::uint32_t> blockFirstRows(blockRows.begin(), blockRows.end() - 1);
+        pushFileHeader(writter, C_HEADER_FLAG_BLOCK_INDEX | C_HEADER_FLAG_BLOCK_ROWS);
+        pushBlockIndex(writter, blockSizes_bytes, blockFirstRows);
+    } else {
+        pushFileHeader(writter, C_HEADER_FLAG_BLOCK_INDEX);
+        pushBlockIndex(writter, blockSizes_bytes);
+    }
+
+    out.reserve(bytesCnt + payloadSize + 16);
+    for(std::size_t block = 0; block < nrOfBlocks; block++) {
+        out.insert(out.end(), blockBfrs[block].begin(), blockBfrs[block].end());
+    }
+
+    m_fileSize = out.size();
+    return m_fileSize;
+}
+
+/**
+ * Splits rows of quadruplets to <nrOfBlocks> blocks of roughly equal compressed size. @param rowEndBits holds
+ * bit offset of the end of each row (non decreasing, last one is the size of the image).
+ * Every block boundary is placed at the row end nearest to its share of the size, each block gets at least one row.
+ * Returns @param nrOfBlocks + 1 first rows, the last one is the height. With less rows than blocks,
+ * there is one row per block and trailing blocks are empty.
+*/
+std::vector<std::size_t> Encoder::balanceBlockRows(const std::vector<std::uint64_t>& rowEndBits, std::size_t nrOfBlocks)
+{
+    std::size_t height = rowEndBits.size();
+    std::vector<std::size_t> blockRows(nrOfBlocks + 1, height);
+    if(height == 0) {
+        return blockRows;
+    }
+
+    std::uint64_t totalBits = rowEndBits.back();
+    blockRows[0]            = 0;
+    for(std::size_t block = 1; block < nrOfBlocks && block < height; block++) {
+        std::uint64_t target = totalBits * block / nrOfBlocks;
+
+        // first row that ends at or after the target, previous row end may be nearer
+        std::size_t row = std::lower_bound(rowEndBits.begin(), rowEndBits.end(), target) - rowEndBits.begin();
+        if(row > 0 && target - rowEndBits[row - 1] < rowEndBits[row] - target) {
+            row--;
+        }
+        // rows are ended by the row index, the block starts one row below; keep one row for each block left
+        std::size_t rowFirst = row + 1;
+        rowFirst             = std::max(rowFirst, blockRows[block - 1] + 1);
+        rowFirst             = std::min(rowFirst, height - std::min(height, nrOfBlocks) + block);
+        blockRows[block]     = rowFirst;
+    }
+    return blockRows;
+}
+
+/**
+ * Encodes whole image to @param out as one AGOR stream (A, N and prediction are not reset, unlike with blocks),
+ * and records AGOR state at the start of every <rowsPerCheckpoint> rows of quadruplets, <nrOfCheckpoints> in total.
+ * Checkpoints are written to checkpoint index (see pushCheckpointIndex) between header and payload, so that
+ * decoder threads can start at any of them. Payload is the same as without blocks. Returns number of bytes written.
+*/
+std::size_t Encoder::encodeToBufferWithCheckpoints(std::vector<std::uint8_t>& out, std::size_t nrOfCheckpoints)
+{
+    if(nrOfCheckpoints == 0) {
+        throw std::runtime_error("encodeToBufferWithCheckpoints(): number of checkpoints must be greater than 0.");
+    }
+    std::size_t rowsPerCheckpoint = (m_height + (nrOfCheckpoints - 1)) / nrOfCheckpoints;
+
+    // payload to its own buffer, bit offsets of checkpoints are relative to its start
+    std::uint64_t bfr    = 0;
+    std::size_t bitCnt   = 0;
+    std::size_t bytesCnt = 0;
+    std::vector<std::uint8_t> payload;
+    Writter_s payloadWritter{nullptr, &bfr, &bitCnt, &bytesCnt, &payload};
+
+    std::vector<AgorCheckpoint_s> checkpoints(1);   // first checkpoint is the seed at row 0
+    checkpoints.reserve(nrOfCheckpoints);
+    encodeBlock(0, m_height, payloadWritter, rowsPerCheckpoint, &checkpoints);
+    if(bytesCnt % 16 != 0) {
+        std::size_t padding = 16 - (bytesCnt % 16);
+        payload.insert(payload.end(), padding, 0);
+    }
+
+    // header and checkpoint index, then payload
+    bfr      = 0;
+    bitCnt   = 0;
+    bytesCnt = 0;
+    out.clear();
+    Writter_s writter{nullptr, &bfr, &bitCnt, &bytesCnt, &out};
+    pushFileHeader(writter, C_HEADER_FLAG_CHECKPOINT_INDEX);
+    pushCheckpointIndex(writter, checkpoints);
+    out.insert(out.end(), payload.begin(), payload.end());
+
+    m_fileSize = out.size();
+    return m_fileSize;
+}
+
+/**
+ * Encodes whole image to @param out, without blocks. Content is the same as the *.bin file written by
+ * encodeParallel. Previous content of @param out is replaced, its capacity is reused.
+ * Returns number of bytes written.
+*/
+std::size_t Encoder::encodeToBuffer(std::vector<std::uint8_t>& out)
+{
+    std::uint64_t bfr    = 0;
+    std::size_t bitCnt   = 0;
+    std::size_t bytesCnt = 0;
+    out.clear();
+    Writter_s writter{nullptr, &bfr, &bitCnt, &bytesCnt, &out};
+
+    pushFileHeader(writter);
+    encodeBlock(0, m_height, writter);
+    if(bytesCnt % 16 != 0) {
+        std::size_t padding = 16 - (bytesCnt % 16);
+        out.insert(out.end(), padding, 0);
+        bytesCnt += padding;
+    }
+
+    m_fileSize = bytesCnt;
+    return bytesCnt;
+}
+
+/**
+ * Encodes whole image to caller owned @param out, without blocks. Codes are stored to it directly as they are
+ * produced, throws as soon as compressed image does not fit. Returns number of bytes written.
+*/
+std::size_t Encoder::encodeToBuffer(std::span<std::uint8_t> out)
+{
+    std::uint64_t bfr    = 0;
+    std::size_t bitCnt   = 0;
+    std::size_t bytesCnt = 0;
+    Writter_s writter{&bfr, &bitCnt, &bytesCnt, out};
+
+    pushFileHeader(writter);
+    encodeBlock(0, m_height, writter);
+    if(bytesCnt % 16 != 0) {
+        pushZeros(writter, 16 - (bytesCnt % 16));
+    }
+
+    m_fileSize = bytesCnt;
+    return bytesCnt;
+}
+
+/**
+ * Encodes <rows> rows of quadruplets starting at <rowFirst> as one independent block:
+ * first quadruplet is a seed, A and N start from initial values. Block is terminated by flushBitstreamNoAlignment.
+ * Uses only its own writter and local state, so blocks can be encoded concurrently.
+ * With @param pCheckpoints, AGOR state at the start of every <rowsPerCheckpoint> rows (after the first) is appended
+ * to it, bit offsets are relative to the start of writter output.
+*/
+void Encoder::encodeBlock(
+   std::size_t rowFirst,
+   std::size_t rows,
+   Writter_s writter,
+   std::size_t rowsPerCheckpoint,
+   std::vector<AgorCheckpoint_s>* pCheckpoints)
+{
+    auto imageData       = m_bayerGB;
+    std::size_t imgWidth = 2 * m_width;
+
+    std::int16_t YCCC_prev[] = {0, 0, 0, 0};
+    std::int16_t YCCC_up[]   = {0, 0, 0, 0};
+    std::uint32_t A[]        = {m_A_init, m_A_init, m_A_init, m_A_init};
+    std::uint32_t N          = N_START;
+    std::vector<std::int16_t> rowYCCC(m_YCCC.empty() ? 4 * m_width : 0);
+
+    for(std::size_t i = rowFirst; i < rowFirst + rows; i++) {
+        const std::int16_t* pRowYCCC;
+        if(m_YCCC.empty()) {
+            // color transform of the whole row at once
+            ColorTransform::bayerGBToYCCC_row(
+               imageData.data() + 2 * i * imgWidth,
+               imageData.data() + (2 * i + 1) * imgWidth,
+               rowYCCC.data(),
+               m_width,
+               m_lossyBits);
+            pRowYCCC = rowYCCC.data();
+        } else {
+            pRowYCCC = m_YCCC.data() + 4 * i * m_width;
+        }
+
+        for(std::size_t j = 0; j < m_width; j++) {
+            const std::int16_t* YCCC = pRowYCCC + 4 * j;
+
+            if(i == rowFirst && j == 0) {   // seed
+                encodeBlockSeedPixel(YCCC, YCCC_prev, A, writter);
+                memcpy(YCCC_up, YCCC_prev, sizeof(YCCC_prev));
+            } else if(j == 0) {   // new row, predict from pixel one row up
+                if(pCheckpoints != nullptr && (i - rowFirst) % rowsPerCheckpoint == 0) {
+                    AgorCheckpoint_s checkpoint;
+                    checkpoint.bitOffset = 8 * (*writter.m_pBytesCnt) + *writter.m_pBitCnt;
+                    checkpoint.N         = N;
+                    checkpoint.row       = i;
+                    memcpy(checkpoint.A, A, sizeof(checkpoint.A));
+                    memcpy(checkpoint.YCCC_up, YCCC_up, sizeof(checkpoint.YCCC_up));
+                    pCheckpoints->push_back(checkpoint);
+                }
+                encodeBlockQuadruple(YCCC, YCCC_up, A, N, writter);
+                memcpy(YCCC_prev, YCCC_up, sizeof(YCCC_prev));
+            } else {
+                encodeBlockQuadruple(YCCC, YCCC_prev, A, N, writter);
+            }
+        }
+    }
+    flushBitstreamNoAlignment(writter);
+}
+
+/**
+ * Same as encodeParallelOneQuadrupleSeedPixel, without dump verification.
+ * Takes quadruplet already transformed to YCCC.
+*/
+void Encoder::encodeBlockSeedPixel(const std::int16_t* YCCC, std::int16_t* YCCC_prev, std::uint32_t* A, Writter_s writter)
+{
+    for(std::size_t ch = 0; ch < 4; ch++) {
+        std::uint16_t posValue  = (std::uint16_t)toAbsSingle(YCCC[ch]);
+        std::uint16_t quotient  = posValue >> m_k_seed;
+        std::uint16_t remainder = posValue & (std::uint16_t)((1 << m_k_seed) - 1);
+
+        pushBits_1(writter, quotient);
+        pushBit_0(writter);
+        pushBitsLSBFirst(writter, remainder, m_k_seed);
+
+        A[ch] += (YCCC[ch] >= 0 ? YCCC[ch] : -YCCC[ch]);
+    }
+    memcpy(YCCC_prev, YCCC, 4 * sizeof(std::int16_t));
+}
+
+/**
+ * Encodes one quadruplet already transformed to YCCC with AGOR: k from A and N, code of each channel, then A and N
+ * are updated. YCCC_prev is updated with current YCCC values.
+ * With @param pCodes, intermediate values are stored to it (used by encodeParallelOneQuadruple for dump verification).
+*/
+void Encoder::encodeBlockQuadruple(
+   const std::int16_t* YCCC,
+   std::int16_t* YCCC_prev,
+   std::uint32_t* A,
+   std::uint32_t& N,
+   Writter_s writter,
+   QuadrupleCodes_s* pCodes)
+{
+    QuadrupleCodes_s codes;
+    QuadrupleCodes_s& c = pCodes != nullptr ? *pCodes : codes;
+
+    for(std::size_t ch = 0; ch < 4; ch++) {
+        c.dpcm[ch]     = YCCC[ch] - YCCC_prev[ch];   // dX(n) = X(n) - X(n-1)
+        c.posValue[ch] = (std::uint16_t)toAbsSingle(c.dpcm[ch]);
+        c.k[ch]        = m_k_min;
+        for(std::size_t it = m_k_min; it < m_k_max; it++) {
+            if((N << c.k[ch]) < A[ch]) {
+                c.k[ch] = c.k[ch] + 1;
+            }
+        }
+        c.quotient[ch]  = c.posValue[ch] >> c.k[ch];
+        c.remainder[ch] = c.posValue[ch] & (std::uint16_t)((1 << c.k[ch]) - 1);   // modulus op = take last k bits
+    }
+
+    for(std::size_t ch = 0; ch < 4; ch++) {
+        A[ch] += (c.dpcm[ch] >= 0 ? c.dpcm[ch] : -c.dpcm[ch]);
+    }
+    N += 1;
+    if(N >= m_N_threshold) {
+        N >>= 1;
+        A[0] >>= 1;
+        A[1] >>= 1;
+        A[2] >>= 1;
+        A[3] >>= 1;
+    }
+
+    for(std::size_t ch = 0; ch < 4; ch++) {
+        /* check if it fits to GR encoding or should it switch to limited encoding */
+        if(c.quotient[ch] < m_unaryMaxWidth) {
+            /* unary coding of quotient, big endian; remainder LSB first */
+            pushBits_1(writter, c.quotient[ch]);
+            pushBit_0(writter);
+            pushBitsLSBFirst(writter, c.remainder[ch], c.k[ch]);
+        } else {
+            /* m_unaryMaxWidth * '1' -> indicates binary coding of positive value, LSB first */
+            pushBits_1(writter, m_unaryMaxWidth);
+            pushBitsLSBFirst(writter, c.posValue[ch], m_k_seed);
+        }
+    }
+    memcpy(YCCC_prev, YCCC, 4 * sizeof(std::int16_t));
+}
+
 /**
  * YCCC_prev is updated with current YCCC values.
 */
@@ -987,31 +1350,18 @@ void Encoder::encodeParallelOneQuadrupleSeedPixel(
 #endif
 
         // unary coding of quotient
-        for(std::uint16_t n = 0; n < quotient[ch]; n++) {   // big endian
-            pushBit_1(writter);
+        pushBits_1(writter, quotient[ch]);   // big endian
+        pushBit_0(writter);
+        // remainder coding
+        pushBitsLSBFirst(writter, remainder[ch], k[ch]);
 #ifdef DUMP_VERIFICATION
+        for(std::uint16_t n = 0; n < quotient[ch]; n++) {   //
             wf_codes << '1';
-#endif
         }
-        pushBit_0(writter);
-#ifdef DUMP_VERIFICATION
         wf_codes << '0';
-#endif
-
-        // // remainder coding
-        // for(std::int16_t n = k[ch]; n > 0; n--) {   // MSB first
-        //     std::uint32_t bit = (remainder[ch] >> (n - 1)) & (std::uint32_t)1;
-        //     pushBit(writter, bit);
-        // }
-        // remainder coding
         for(std::int16_t n = 0; n < k[ch]; n++) {   // LSB first
-            std::uint32_t bit = (remainder[ch] >> n) & (std::uint32_t)1;
-            pushBit(writter, bit);
-#ifdef DUMP_VERIFICATION
-            wf_codes << (bit ? '1' : '0');
-#endif
+            wf_codes << (((remainder[ch] >> n) & 1) ? '1' : '0');
         }
-#ifdef DUMP_VERIFICATION
         wf_codes << '\n';
 #endif
     }
@@ -1030,6 +1380,7 @@ void Encoder::encodeParallelOneQuadrupleSeedPixel(
 /**
  * It is up to the caller to supply correct YCCC_prev values
  * (e.g. when going to new row or when pixel is seed pixel).
+ * Transforms quadruplet to YCCC and encodes it with encodeBlockQuadruple, writing dump verification files around it.
  * YCCC_prev is updated with current YCCC values.
 */
 void Encoder::encodeParallelOneQuadruple(
@@ -1040,7 +1391,6 @@ void Encoder::encodeParallelOneQuadruple(
    std::int16_t* YCCC_prev,
    std::uint32_t* A,
    std::uint32_t& N,
-   std::uint32_t N_threshold,
    std::uint8_t last,
    Writter_s writter)
 {
@@ -1058,15 +1408,26 @@ void Encoder::encodeParallelOneQuadruple(
        &YCCC[3],
        m_lossyBits);   //
 
-    // 2.) to dpcm: difference between prev pixel and current pixel.
-    std::int16_t dpcm[] = {0, 0, 0, 0};
-    for(std::size_t ch = 0; ch < 4; ch++) {
-        dpcm[ch] = YCCC[ch] - YCCC_prev[ch];   // dX(n) = X(n) - X(n-1)
-    }
+#ifndef DUMP_VERIFICATION
+    (void)last;
+    encodeBlockQuadruple(YCCC, YCCC_prev, A, N, writter);
+#else
+    // 2.) - 6.) dpcm, AGOR and codes; prediction and A are kept for the dumps, encodeBlockQuadruple updates them
+    std::int16_t YCCC_pred[4];
+    std::uint32_t A_pred[4];
+    memcpy(YCCC_pred, YCCC_prev, sizeof(YCCC_pred));
+    memcpy(A_pred, A, sizeof(A_pred));
+    QuadrupleCodes_s codes;
+    encodeBlockQuadruple(YCCC, YCCC_prev, A, N, writter, &codes);
+
+    const std::int16_t* dpcm       = codes.dpcm;
+    const std::uint16_t* posValue  = codes.posValue;
+    const std::uint16_t* quotient  = codes.quotient;
+    const std::uint16_t* remainder = codes.remainder;
+    const std::uint16_t* k         = codes.k;
 
-#ifdef DUMP_VERIFICATION
     {
-        static std::ofstream wf_dpcm;
+        std::ofstream& wf_dpcm = m_ctx.wf_dpcm;
         if((m_row == 0) & (m_col == 1)) {
             char outputFile[200];
             std::sprintf(outputFile, "%s/dump/%s%02zu_dpcm.txt", m_folderOut, m_fileName, m_imgIdx);
@@ -1089,10 +1450,10 @@ void Encoder::encodeParallelOneQuadruple(
            "%4zu %4zu : %.4hX %.4hX %.4hX %.4hX : %.4hX %.4hX %.4hX %.4hX : %.4hX %.4hX %.4hX %.4hX\n",
            m_row,
            m_col,
-           (YCCC_prev[0] & mask_Y),
-           (YCCC_prev[1] & mask_C),
-           (YCCC_prev[2] & mask_C),
-           (YCCC_prev[3] & mask_C),
+           (YCCC_pred[0] & mask_Y),
+           (YCCC_pred[1] & mask_C),
+           (YCCC_pred[2] & mask_C),
+           (YCCC_pred[3] & mask_C),
            (YCCC[0] & mask_Y),
            (YCCC[1] & mask_C),
            (YCCC[2] & mask_C),
@@ -1106,34 +1467,8 @@ void Encoder::encodeParallelOneQuadruple(
             wf_dpcm.close();
         };
     }
-#endif
-
-    // 3.) To positive value
-    std::uint16_t posValue[] = {0, 0, 0, 0};
-    for(std::size_t ch = 0; ch < 4; ch++) {   //
-        posValue[ch] = (std::uint16_t)toAbsSingle(dpcm[ch]);
-    }
-
-    // 4.) AGOR
-    std::uint16_t quotient[]  = {0, 0, 0, 0};
-    std::uint16_t remainder[] = {0, 0, 0, 0};
-    std::uint16_t k[]         = {m_k_min, m_k_min, m_k_min, m_k_min};
-
-    for(std::size_t ch = 0; ch < 4; ch++) {
-        for(std::size_t it = m_k_min; it < m_k_max; it++) {
-            if((N << k[ch]) < A[ch]) {
-                k[ch] = k[ch] + 1;
-            } else {
-                k[ch] = k[ch];
-            }
-        }
-        quotient[ch]  = posValue[ch] >> k[ch];
-        remainder[ch] = posValue[ch] & (std::uint16_t)((1 << k[ch]) - 1);   // modulus op = take last k bits
-    }
-
-#ifdef DUMP_VERIFICATION
     {
-        static std::ofstream wf_calc;
+        std::ofstream& wf_calc = m_ctx.wf_calc;
         if((m_row == 0) & (m_col == 1)) {
             char outputFile[200];
             std::sprintf(outputFile, "%s/dump/%s%02zu_calc.txt", m_folderOut, m_fileName, m_imgIdx);
@@ -1152,10 +1487,10 @@ void Encoder::encodeParallelOneQuadruple(
            "%4zu %4zu : %4hu %4hu %4hu %4hu : %3hu %3hu %3hu %3hu\n",
            m_row,
            m_col,
-           A[0],
-           A[1],
-           A[2],
-           A[3],
+           A_pred[0],
+           A_pred[1],
+           A_pred[2],
+           A_pred[3],
            k[0],
            k[1],
            k[2],
@@ -1165,11 +1500,9 @@ void Encoder::encodeParallelOneQuadruple(
             wf_calc.close();
         }
     }
-#endif
 
-#ifdef DUMP_VERIFICATION
     {
-        static std::ofstream wf_qr;
+        std::ofstream& wf_qr = m_ctx.wf_qr;
         if((m_row == 0) & (m_col == 1)) {
             char outputFile[200];
             std::sprintf(outputFile, "%s/dump/%s%02zu_qr.txt", m_folderOut, m_fileName, m_imgIdx);
@@ -1204,7 +1537,7 @@ void Encoder::encodeParallelOneQuadruple(
         }
     }
     {
-        static std::ofstream wf_qr;
+        std::ofstream& wf_qr = m_ctx.wf_qrK;
         if((m_row == 0) & (m_col == 1)) {
             char outputFile[200];
             std::sprintf(outputFile, "%s/dump/%s%02zu_qrK.txt", m_folderOut, m_fileName, m_imgIdx);
@@ -1239,30 +1572,9 @@ void Encoder::encodeParallelOneQuadruple(
             wf_qr.close();
         }
     }
-#endif
-
-    // 5.) add abs(dpcm) to A
-    for(std::size_t ch = 0; ch < 4; ch++) {   //
-        A[ch] += (dpcm[ch] >= 0 ? dpcm[ch] : -dpcm[ch]);
-    }
 
-    // 5.) increas N and halve N and A
-    N += 1;
-    if(N >= N_threshold) {
-        N >>= 1;
-        A[0] >>= 1;
-        A[1] >>= 1;
-        A[2] >>= 1;
-        A[3] >>= 1;
-    }
-    A[0] = A[0] < A_MIN ? A_MIN : A[0];
-    A[1] = A[1] < A_MIN ? A_MIN : A[1];
-    A[2] = A[2] < A_MIN ? A_MIN : A[2];
-    A[3] = A[3] < A_MIN ? A_MIN : A[3];
 
-    // 6.) Encode
-#ifdef DUMP_VERIFICATION
-    static std::ofstream wf_codes;
+    std::ofstream& wf_codes = m_ctx.wf_codes;
     if((m_row == 0) & (m_col == 1)) {
         char outputFile[200];
         std::sprintf(outputFile, "%s/dump/%s%02zu_codes.txt", m_folderOut, m_fileName, m_imgIdx);
@@ -1273,9 +1585,7 @@ void Encoder::encodeParallelOneQuadruple(
             throw std::runtime_error(msg);
         }
     }
-#endif
     for(std::size_t ch = 0; ch < 4; ch++) {
-#ifdef DUMP_VERIFICATION
         char txt[200];
         std::size_t code_len =
            ((std::size_t)(quotient[ch] + 1 + k[ch]) < (m_k_seed + m_unaryMaxWidth) ? quotient[ch] + 1 + k[ch]
@@ -1290,59 +1600,28 @@ void Encoder::encodeParallelOneQuadruple(
            k[ch],
            code_len);
         wf_codes << txt;
-#endif
-        /* check if it fits to GR encoding or should it switch to limited encoding */
         if(quotient[ch] < m_unaryMaxWidth) {
-            // unary coding of quotient
-            for(std::uint16_t n = 0; n < quotient[ch]; n++) { /* big endian */
-                pushBit_1(writter);
-#ifdef DUMP_VERIFICATION
+            for(std::uint16_t n = 0; n < quotient[ch]; n++) {   //
                 wf_codes << '1';
-#endif
             }
-            pushBit_0(writter);
-#ifdef DUMP_VERIFICATION
             wf_codes << '0';
-#endif
-            /* remainder coding */
-            // for(std::int16_t n = k[ch]; n > 0; n--) {   /* MSB first */
-            //     std::uint32_t bit = (remainder[ch] >> (n - 1)) & (std::uint32_t)1;
-            //     pushBit(writter, bit);
-            // }
-            for(std::int16_t n = 0; n < k[ch]; n++) { /* LSB first */
-                std::uint32_t bit = (remainder[ch] >> n) & (std::uint32_t)1;
-                pushBit(writter, bit);
-#ifdef DUMP_VERIFICATION
-                wf_codes << (bit ? '1' : '0');
-#endif
+            for(std::int16_t n = 0; n < k[ch]; n++) {   //
+                wf_codes << (((remainder[ch] >> n) & 1) ? '1' : '0');
             }
         } else {
-            /* m_unaryMaxWidth * '1' -> indicates binary coding of positive value */
             for(std::uint16_t n = 0; n < m_unaryMaxWidth; n++) {   //
-                pushBit_1(writter);
-#ifdef DUMP_VERIFICATION
                 wf_codes << '1';
-#endif
             }
-            for(std::uint16_t n = 0; n < m_k_seed; n++) { /* LSB first */
-                std::uint32_t bit = (posValue[ch] >> n) & (std::uint32_t)1;
-                pushBit(writter, bit);
-#ifdef DUMP_VERIFICATION
-                wf_codes << (bit ? '1' : '0');
-#endif
+            for(std::uint16_t n = 0; n < m_k_seed; n++) {   //
+                wf_codes << (((posValue[ch] >> n) & 1) ? '1' : '0');
             }
         }
-#ifdef DUMP_VERIFICATION
         wf_codes << '\n';
-#endif
     }
-#ifdef DUMP_VERIFICATION
     if((m_row == m_height - 1) & (m_col == m_width - 1)) {   //
         wf_codes.close();
     }
 #endif
-    // prepare data for next pixel
-    memcpy(YCCC_prev, YCCC, sizeof(YCCC));
 }
 
 /**
@@ -1672,9 +1951,10 @@ std::unique_ptr<std::vector<std::size_t>> Encoder::encodeBitstreamAll()
         sprintf(fileName, "%s/compressed/%s%02zu.bin", m_folderOut, m_fileName, m_imgIdx);
     }
 
-    std::uint32_t bfr    = 0;
+    std::uint64_t bfr    = 0;
     std::size_t bitCnt   = 0;
     std::size_t bytesCnt = 0;
+    std::vector<std::uint8_t> outBfr;
     std::ofstream wf(fileName, std::ios::out | std::ios::binary);
 
     if(!wf) {
@@ -1683,7 +1963,8 @@ std::unique_ptr<std::vector<std::size_t>> Encoder::encodeBitstreamAll()
         throw std::runtime_error(msg);
     }
 
-    Writter_s writter{&wf, &bfr, &bitCnt, &bytesCnt};
+    outBfr.reserve(WRITTER_CHUNK_SIZE + 64);
+    Writter_s writter{&wf, &bfr, &bitCnt, &bytesCnt, &outBfr};
 
     std::uint16_t widthHeight[2];
     widthHeight[0] = getWidth();
@@ -1738,24 +2019,18 @@ std::size_t Encoder::encodeBitstream(
         (void)curr_r;
         (void)curr_k;
         if(kValues[i] == -1) {
-            // two's complement
-            for(std::int16_t n = 16; n > 0; n--) {   // big endian
-                std::uint32_t bit = (q[i] >> (n - 1)) & (std::uint32_t)1;
-                pushBit(writter, bit);
-            }
+            // two's complement, big endian
+            pushBits(writter, (std::uint16_t)q[i], 16);
         } else {
             // unary coding of quotient
-            for(std::uint16_t n = 0; n < q[i]; n++) {   // big endian
-                pushBit_1(writter);
+            if(q[i] > 0) {   // big endian
+                pushBits_1(writter, q[i]);
             }
             pushBit_0(writter);
 
-            // remainder coding
-            //for(std::size_t n = 0; n < k; n++) { // little endian
-            //uint32_t bit = (r[i] >> n) & (std::uint32_t)1;
-            for(std::int16_t n = kValues[i]; n > 0; n--) {   // big endian
-                std::uint32_t bit = (r[i] >> (n - 1)) & (std::uint32_t)1;
-                pushBit(writter, bit);
+            // remainder coding, big endian
+            if(kValues[i] > 0) {
+                pushBits(writter, r[i], kValues[i]);
             }
         }
     }
@@ -1767,7 +2042,6 @@ std::size_t Encoder::encodeBitstream(
 
 /**
  * Puts '1' in a buffer.
- * If cnt = 8, that writes a byte to file.
  */
 void Encoder::pushBit_1(Writter_s writter)
 {
@@ -1776,7 +2050,6 @@ void Encoder::pushBit_1(Writter_s writter)
 
 /**
  * Puts '0' in a buffer.
- * If cnt = 8, that writes a byte to file.
  */
 void Encoder::pushBit_0(Writter_s writter)
 {
@@ -1785,67 +2058,322 @@ void Encoder::pushBit_0(Writter_s writter)
 
 /**
  * Puts bit in a buffer.
- * If cnt = 8, that writes a byte to file.
  */
 void Encoder::pushBit(Writter_s writter, std::uint32_t bit)
 {
-
-    if(bit == 1) {
-        *writter.m_pBfr = (*writter.m_pBfr << 1) | (uint32_t)1;
-    } else if(bit == 0) {
-        *writter.m_pBfr = (*writter.m_pBfr << 1) & ~((uint32_t)1);
-    } else {
+    if(bit > 1) {
         throw std::runtime_error("Non bit value suppplied to pushBit");
     }
-    (*(writter.m_pBitCnt))++;
-    // Buffer full (8 bits collected), write new byte to file.
-    if(*writter.m_pBitCnt == 8) {
-        char byte          = *writter.m_pBfr;
-        *writter.m_pBitCnt = 0;
-        writter.m_pWf->write(&byte, 1);
-        (*writter.m_pBytesCnt)++;
+    pushBits(writter, bit, 1);
+}
+
+/**
+ * Puts lowest n bits (n <= 32) in a buffer, MSB first.
+ * When 32 bits are collected, they are moved to output buffer. Full output buffer is written to file.
+ */
+void Encoder::pushBits(Writter_s writter, std::uint32_t bits, std::size_t n)
+{
+    std::uint64_t mask = ((std::uint64_t)1 << n) - 1;
+    *writter.m_pBfr    = (*writter.m_pBfr << n) | (bits & mask);
+    *writter.m_pBitCnt += n;
+
+    if(*writter.m_pBitCnt >= 32) {
+        *writter.m_pBitCnt -= 32;
+        std::uint32_t word = (std::uint32_t)(*writter.m_pBfr >> *writter.m_pBitCnt);
+        std::uint8_t bytes[] = {
+           (std::uint8_t)(word >> 24),   //
+           (std::uint8_t)(word >> 16),
+           (std::uint8_t)(word >> 8),
+           (std::uint8_t)(word >> 0)};
+        pushBytes(writter, bytes, 4);
+
+        if(writter.m_pOutBfr != nullptr && writter.m_pOutBfr->size() >= WRITTER_CHUNK_SIZE) {   //
+            writeOutBuffer(writter);
+        }
     }
 }
 
-void Encoder::pushHeader(Writter_s writter, std::uint64_t header)
+/**
+ * Puts lowest n bits (n <= 32) in a buffer, LSB first.
+ */
+void Encoder::pushBitsLSBFirst(Writter_s writter, std::uint32_t bits, std::size_t n)
 {
+    pushBits(writter, reverseBits(bits, n), n);
+}
+
+/**
+ * Puts n '1' in a buffer (unary code).
+ */
+void Encoder::pushBits_1(Writter_s writter, std::size_t n)
+{
+    for(; n >= 32; n -= 32) {   //
+        pushBits(writter, 0xFFFFFFFF, 32);
+    }
+    pushBits(writter, ((std::uint32_t)1 << n) - 1, n);
+}
 
-    writter.m_pWf->write((const char*)&header, sizeof(header));
-    (*writter.m_pBytesCnt) += sizeof(header);
+/**
+ * Moves all complete bytes from accumulator to output buffer.
+ */
+void Encoder::drainBits(Writter_s writter)
+{
+    while(*writter.m_pBitCnt >= 8) {
+        *writter.m_pBitCnt -= 8;
+        std::uint8_t byte = (std::uint8_t)(*writter.m_pBfr >> *writter.m_pBitCnt);
+        pushBytes(writter, &byte, 1);
+    }
+}
+
+/**
+ * Writes output buffer to file and empties it. Does nothing when no file is attached.
+ */
+void Encoder::writeOutBuffer(Writter_s writter)
+{
+    if(writter.m_pWf == nullptr || writter.m_pOutBfr == nullptr) {
+        return;
+    }
+    writter.m_pWf->write((const char*)writter.m_pOutBfr->data(), writter.m_pOutBfr->size());
+    writter.m_pOutBfr->clear();
+}
+
+/**
+ * Pushes compressed file header according to m_header_bytes (8, 16 or 24 bytes).
+ * @param reservedBits goes to the reserved byte of compression info, e.g. C_HEADER_FLAG_BLOCK_INDEX.
+*/
+void Encoder::pushFileHeader(Writter_s writter, std::uint8_t reservedBits)
+{
+    // if header_bytes = 8, then write 8 byte timestamp to the beginning
+    if(m_header_bytes == 8) {
+
+        /* Timestamp: */
+        // MSB                                                                          LSB
+        // 64                 48                  32                  16                   0
+        // | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes |
+        // address : content
+        //       0 : timestampLSB
+        //       7 : timestampMSB
+
+        // std::uint64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+        //                              std::chrono::system_clock::now().time_since_epoch())
+        //                              .count();
+
+        std::uint64_t compression_info =   //
+           0LLU |   //
+           ((std::uint64_t)((std::uint8_t)reservedBits)) << 56 |   //
+           ((std::uint64_t)((std::uint8_t)m_lossyBits)) << 48 |   //
+           ((std::uint64_t)((std::uint8_t)m_bpp)) << 40 |   //
+           ((std::uint64_t)((std::uint8_t)m_unaryMaxWidth)) << 32 |   //
+           ((std::uint64_t)((std::uint16_t)2 * m_height)) << 16 |   //
+           ((std::uint64_t)((std::uint16_t)2 * m_width)) << 0;
+        // clang-format on
+
+        pushHeader(writter, compression_info);
+
+    } else if(m_header_bytes == 16) {
+        std::uint64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::system_clock::now().time_since_epoch())
+                                     .count();
+
+        pushHeader(writter, timestamp);
+
+        /* Compression info: */
+        //  MSB                                                                          LSB
+        // 64                 48                  32                  16                   0
+        // | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes |
+        // | Reservd ' losyBts | unary H ' unary L | heigh H ' heigh L | width H ' width L |
+        // address : content
+        //       0 : width L
+        //       1 : width H
+        //       2 : height L
+        //       3 : height H
+        //       4 : unary L
+        //       5 : unary H
+        //       6 : lossy bits
+        //       7 : reserved
+
+        // clang-format off
+        std::uint64_t compression_info =   //
+           0LLU                                                    |   //
+           ((std::uint64_t)((std::uint8_t)reservedBits))     << 56 |   //
+           ((std::uint64_t)((std::uint8_t)m_lossyBits))      << 48 |   //
+           ((std::uint64_t)((std::uint8_t)m_bpp))            << 40 |   //
+           ((std::uint64_t)((std::uint8_t)m_unaryMaxWidth))  << 32 |   //
+           ((std::uint64_t)((std::uint16_t)2*m_height))      << 16 |   //
+           ((std::uint64_t)((std::uint16_t)2*m_width))       << 0;
+        // clang-format on
+
+        pushHeader(writter, compression_info);
+        // wf.write((const char*)&compression_info, sizeof(compression_info));
+        // (*writter.m_pBytesCnt) += sizeof(compression_info);
+    } else if(m_header_bytes == 24) {
+        std::uint64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::system_clock::now().time_since_epoch())
+                                     .count();
+
+        pushHeader(writter, timestamp);
+        std::uint64_t roi      = 0;
+        std::uint16_t offset_y = 0;
+        std::uint16_t offset_x = 0;
+        roi = (2 * m_height & 0xFFFF) << 48 | (2 * m_width & 0xFFFF) << 32 | offset_y << 16 | offset_x;
+        pushHeader(writter, roi);
+
+        /* Compression info: */
+        //  MSB                                                                          LSB
+        // 64                 48                  32                  16                   0
+        // | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes | 8 bytes ' 8 bytes |
+        // | Reservd ' losyBts | unary H ' unary L | heigh H ' heigh L | width H ' width L |
+        // address : content
+        //       0 : width L
+        //       1 : width H
+        //       2 : height L
+        //       3 : height H
+        //       4 : unary L
+        //       5 : unary H
+        //       6 : lossy bits
+        //       7 : reserved
+
+        // clang-format off
+        std::uint64_t compression_info =   //
+           0LLU                                                    |   //
+           ((std::uint64_t)((std::uint8_t)reservedBits))     << 56 |   //
+           ((std::uint64_t)((std::uint8_t)m_lossyBits))      << 48 |   //
+           ((std::uint64_t)((std::uint8_t)m_bpp))            << 40 |   //
+           ((std::uint64_t)((std::uint8_t)m_unaryMaxWidth))  << 32 |   //
+           ((std::uint64_t)((std::uint16_t)2*m_height))      << 16 |   //
+           ((std::uint64_t)((std::uint16_t)2*m_width))       << 0;
+        // clang-format on
+
+        pushHeader(writter, compression_info);
+
+    } else {
+        printf("No header will be added to the compressed file.\n");
+    }
+}
+
+void Encoder::pushHeader(Writter_s writter, std::uint64_t header)
+{
+    drainBits(writter);
+    const std::uint8_t* pHeader = (const std::uint8_t*)&header;
+    pushBytes(writter, pHeader, sizeof(header));
 }
 
 void Encoder::pushShort(Writter_s writter, std::uint16_t data)
 {
-    writter.m_pWf->write((const char*)&data, sizeof(data));
-    (*writter.m_pBytesCnt) += sizeof(data);
+    drainBits(writter);
+    const std::uint8_t* pData = (const std::uint8_t*)&data;
+    pushBytes(writter, pData, sizeof(data));
 }
 
 /**
- * Flush last byte. Fill in '0' to missing bits and write to file.
+ * Appends n bytes to output buffer, or stores them to output span at offset *m_pBytesCnt.
+ * Throws when they do not fit in the span.
 */
-void Encoder::flushBitstream(Writter_s writter)
+void Encoder::pushBytes(Writter_s writter, const std::uint8_t* pData, std::size_t n)
 {
-    for(auto n = 8 - *writter.m_pBitCnt; n > 0; n--) {   //
-        pushBit_0(writter);
+    if(writter.m_pOutBfr != nullptr) {
+        writter.m_pOutBfr->insert(writter.m_pOutBfr->end(), pData, pData + n);
+    } else {
+        if(writter.m_outSpan.size() - std::min(*writter.m_pBytesCnt, writter.m_outSpan.size()) < n) {
+            char msg[200];
+            sprintf(
+               msg,
+               "Encoder: compressed image does not fit in output buffer of %zu bytes",
+               writter.m_outSpan.size());
+            throw std::runtime_error(msg);
+        }
+        memcpy(writter.m_outSpan.data() + *writter.m_pBytesCnt, pData, n);
     }
+    (*writter.m_pBytesCnt) += n;
+}
+
+/**
+ * Appends n '0' bytes (padding), see pushBytes.
+*/
+void Encoder::pushZeros(Writter_s writter, std::size_t n)
+{
+    static const std::uint8_t zeros[16] = {};
+    for(; n > sizeof(zeros); n -= sizeof(zeros)) {
+        pushBytes(writter, zeros, sizeof(zeros));
+    }
+    pushBytes(writter, zeros, n);
+}
+
+/**
+ * Pushes block index that follows the file header of an image compressed in blocks (C_HEADER_FLAG_BLOCK_INDEX):
+ *   uint32 nrOfBlocks
+ *   uint32 offset[nrOfBlocks + 1]   // of each block from the start of payload, offset[nrOfBlocks] is payload size
+ *   uint32 rowFirst[nrOfBlocks]     // only with C_HEADER_FLAG_BLOCK_ROWS: first row of quadruplets of each block
+ *   '0' padding                     // payload (block 0) starts at 16-byte aligned file offset
+ * @param blockRows is empty for blocks of equal row count (rows are not stored).
+*/
+void Encoder::pushBlockIndex(
+   Writter_s writter,
+   const std::vector<std::uint32_t>& blockSizes_bytes,
+   const std::vector<std::uint32_t>& blockRows)
+{
+    drainBits(writter);
+    std::vector<std::uint32_t> index(blockSizes_bytes.size() + 2, 0);
+    index[0] = blockSizes_bytes.size();
+    for(std::size_t block = 0; block < blockSizes_bytes.size(); block++) {
+        index[block + 2] = index[block + 1] + blockSizes_bytes[block];
+    }
+    index.insert(index.end(), blockRows.begin(), blockRows.end());
+    const std::uint8_t* pIndex = (const std::uint8_t*)index.data();
+    pushBytes(writter, pIndex, index.size() * sizeof(std::uint32_t));
 
     if(*writter.m_pBytesCnt % 16 != 0) {
-        for(auto n = 16 - (*writter.m_pBytesCnt % 16); n > 0; n--) {   //
-            for(auto n = 8; n > 0; n--) {   //
-                pushBit_0(writter);
-            }
-        }
+        std::size_t padding = 16 - (*writter.m_pBytesCnt % 16);
+        pushZeros(writter, padding);
     }
 }
 
 /**
- * Flush last byte without alignment. Fill in '0' to missing bits and write to file.
+ * Pushes checkpoint index that follows the file header of an image with C_HEADER_FLAG_CHECKPOINT_INDEX:
+ *   uint32 nrOfCheckpoints
+ *   uint32 reserved
+ *   AgorCheckpoint_s checkpoint[nrOfCheckpoints]   // 40 bytes each, first one is the seed at row 0, bit offset 0
+ *   '0' padding                                    // payload starts at 16-byte aligned file offset
 */
-void Encoder::flushBitstreamNoAlignment(Writter_s writter)
+void Encoder::pushCheckpointIndex(Writter_s writter, const std::vector<AgorCheckpoint_s>& checkpoints)
 {
-    for(auto n = 8 - *writter.m_pBitCnt; n > 0; n--) {   //
-        pushBit_0(writter);
+    static_assert(sizeof(AgorCheckpoint_s) == 40, "checkpoint index entry is 40 bytes");
+
+    drainBits(writter);
+    std::uint32_t count[] = {(std::uint32_t)checkpoints.size(), 0};
+    const std::uint8_t* pCount       = (const std::uint8_t*)count;
+    const std::uint8_t* pCheckpoints = (const std::uint8_t*)checkpoints.data();
+    pushBytes(writter, pCount, sizeof(count));
+    pushBytes(writter, pCheckpoints, checkpoints.size() * sizeof(AgorCheckpoint_s));
+
+    if(*writter.m_pBytesCnt % 16 != 0) {
+        std::size_t padding = 16 - (*writter.m_pBytesCnt % 16);
+        pushZeros(writter, padding);
+    }
+}
+
+/**
+ * Flush last byte. Fill in '0' to missing bits, align to 16 bytes and write everything to file.
+ * Already complete byte gets one extra '0' byte.
+*/
+void Encoder::flushBitstream(Writter_s writter)
+{
+    flushBitstreamNoAlignment(writter);
+
+    if(*writter.m_pBytesCnt % 16 != 0) {
+        std::size_t padding = 16 - (*writter.m_pBytesCnt % 16);
+        pushZeros(writter, padding);
     }
+    writeOutBuffer(writter);
+}
+
+/**
+ * Flush last byte without alignment. Fill in '0' to missing bits and move it to output buffer.
+ * Already complete byte gets one extra '0' byte.
+*/
+void Encoder::flushBitstreamNoAlignment(Writter_s writter)
+{
+    pushBits(writter, 0, 8 - (*writter.m_pBitCnt % 8));
+    drainBits(writter);
 }
 
 /* Dump DPCM (differential relative to prev pixel) values to file.*/
@@ -7,15 +7,80 @@
 #include <fstream>
 #include <iostream>
 #include <span>
+#include <vector>
 
+/**
+ * Bit writer. Codes are packed MSB first into 64 bit accumulator (m_pBfr), complete words are moved to
+ * output buffer (m_pOutBfr) which is written to file in chunks of WRITTER_CHUNK_SIZE bytes.
+ * m_pBitCnt holds number of valid bits in accumulator, m_pBytesCnt number of bytes moved out of it.
+ * If m_pWf is nullptr, output buffer is never written to file.
+ * If m_pOutBfr is nullptr, bytes are stored directly to caller owned m_outSpan at offset *m_pBytesCnt,
+ * writing past its end throws.
+*/
 struct Writter_s {
     std::ofstream* m_pWf;
-    std::uint32_t* m_pBfr;
+    std::uint64_t* m_pBfr;
     std::size_t* m_pBitCnt;
     std::size_t* m_pBytesCnt;
+    std::vector<std::uint8_t>* m_pOutBfr;
+    std::span<std::uint8_t> m_outSpan;
 
     explicit Writter_s();
-    explicit Writter_s(std::ofstream* pWf, std::uint32_t* pBfr, std::size_t* pBitCnt, std::size_t* pBytes);
+    explicit Writter_s(
+       std::ofstream* pWf,
+       std::uint64_t* pBfr,
+       std::size_t* pBitCnt,
+       std::size_t* pBytes,
+       std::vector<std::uint8_t>* pOutBfr);
+    explicit Writter_s(
+       std::uint64_t* pBfr,
+       std::size_t* pBitCnt,
+       std::size_t* pBytes,
+       std::span<std::uint8_t> outSpan);
+};
+
+/**
+ * State of the pixel stream encoded by encodeParallel or encodeParallelInBlocks, one pixel per call.
+ * Owned by Encoder instance, so that multiple encoders can compress different images concurrently.
+*/
+struct EncoderContext_s {
+    std::size_t idx      = 0;   // index of next quadruplet, 0 starts new image
+    std::uint64_t bfr    = 0;
+    std::size_t bitCnt   = 0;
+    std::size_t bytesCnt = 0;
+    std::ofstream wf;
+    std::vector<std::uint8_t> outBfr;
+    Writter_s writter;
+    std::int16_t YCCC_prev[4] = {0, 0, 0, 0};
+    std::int16_t YCCC_up[4]   = {0, 0, 0, 0};
+    std::uint32_t A[4]        = {0, 0, 0, 0};
+    std::uint32_t N           = N_START;
+
+    /* encodeParallelInBlocks only */
+    std::size_t rowsPerBlock          = 0;
+    std::size_t blockSize_quadruplets = 0;
+    std::size_t blockSize_pixels      = 0;
+    std::vector<std::uint32_t> blockSizes_bytes;
+    std::size_t bytesCntPrevious = 0;
+    std::size_t idxPrevious      = 0;
+#ifdef DUMP_VERIFICATION
+    std::ofstream wf_dpcm;
+    std::ofstream wf_calc;
+    std::ofstream wf_qr;
+    std::ofstream wf_qrK;
+    std::ofstream wf_codes;
+#endif
+};
+
+/**
+ * Intermediate values of one quadruplet encoded by Encoder::encodeBlockQuadruple, per channel.
+*/
+struct QuadrupleCodes_s {
+    std::int16_t dpcm[4];
+    std::uint16_t posValue[4];
+    std::uint16_t quotient[4];
+    std::uint16_t remainder[4];
+    std::uint16_t k[4];
 };
 
 class Encoder
@@ -23,6 +88,8 @@ class Encoder
   private:
     const Image* m_pImg         = nullptr;
     const ImageYCCC* m_pImgYCCC = nullptr;
+    std::span<std::uint16_t const> m_bayerGB;   // BayerCFA data of m_pImg or caller supplied frame
+    std::span<std::int16_t const> m_YCCC;       // caller supplied frame already in YCCC, used instead of m_bayerGB
     std::size_t m_width, m_height, m_length;
     sQuadChannelCS m_kValues;
     sQuadChannelCS m_dpcm;   // max value 2*max(dpcm) = 1020 - 0 = 1020 (Y channel), 255 - -255 = 510 (others)
@@ -45,6 +112,7 @@ class Encoder
     std::size_t m_fileSize      = 0;
     std::size_t m_idealRule     = 0;
     std::size_t m_nrOfBlocks    = 0;
+    EncoderContext_s m_ctx;
 #ifdef DUMP_VERIFICATION
     std::size_t m_row                 = 0;
     std::size_t m_col                 = 0;
@@ -68,6 +136,8 @@ class Encoder
         parallel_standard,
         parallel_limited,
         parallel_limited_blocks,
+        parallel_limited_blocks_balanced,
+        parallel_limited_checkpoints,
         end
     };
     Encoder(
@@ -84,6 +154,24 @@ class Encoder
        std::size_t header_bytes,
        const char* fileName,
        std::uint16_t nrOfBlocks);
+    Encoder(
+       std::span<std::uint16_t const> bayerGB,
+       std::size_t width,
+       std::size_t height,
+       std::uint32_t A_init,
+       std::uint32_t N_threshold,
+       std::size_t lossyBits,
+       std::size_t unaryMaxWidth,
+       std::uint8_t bpp);
+    Encoder(
+       std::span<std::int16_t const> YCCC,
+       std::size_t width,
+       std::size_t height,
+       std::uint32_t A_init,
+       std::uint32_t N_threshold,
+       std::size_t lossyBits,
+       std::size_t unaryMaxWidth,
+       std::uint8_t bpp);
     Encoder(
        const ImageYCCC* pImgYCCC,
        const char* folderOut,
@@ -101,6 +189,22 @@ class Encoder
     const sQuadChannelCS* getDpcmChannelsConst() const;
 
     std::unique_ptr<std::vector<std::size_t>> runParallelCompression();
+    std::unique_ptr<std::vector<std::size_t>> runParallelCompressionInBlocks(
+       std::size_t nrOfThreads = 0,
+       bool balanced = false);
+    std::unique_ptr<std::vector<std::size_t>> runParallelCompressionWithCheckpoints();
+    std::size_t encodeToBuffer(std::vector<std::uint8_t>& out);
+    std::size_t encodeToBuffer(std::span<std::uint8_t> out);
+    std::size_t encodeToBuffer(
+       std::vector<std::uint8_t>& out,
+       std::vector<std::uint32_t>& blockSizes_bytes,
+       std::size_t nrOfBlocks,
+       std::size_t nrOfThreads = 0,
+       bool balanced = false);
+    static std::vector<std::size_t> balanceBlockRows(
+       const std::vector<std::uint64_t>& rowEndBits,
+       std::size_t nrOfBlocks);
+    std::size_t encodeToBufferWithCheckpoints(std::vector<std::uint8_t>& out, std::size_t nrOfCheckpoints);
     std::size_t encodeParallel(
        std::uint16_t gb,   //
        std::uint16_t b,
@@ -112,6 +216,20 @@ class Encoder
        std::uint16_t r,
        std::uint16_t gr,
        std::uint16_t blockSize);
+    void encodeBlock(
+       std::size_t rowFirst,
+       std::size_t rows,
+       Writter_s writter,
+       std::size_t rowsPerCheckpoint = 0,
+       std::vector<AgorCheckpoint_s>* pCheckpoints = nullptr);
+    void encodeBlockSeedPixel(const std::int16_t* YCCC, std::int16_t* YCCC_prev, std::uint32_t* A, Writter_s writter);
+    void encodeBlockQuadruple(
+       const std::int16_t* YCCC,
+       std::int16_t* YCCC_prev,
+       std::uint32_t* A,
+       std::uint32_t& N,
+       Writter_s writter,
+       QuadrupleCodes_s* pCodes = nullptr);
     void encodeParallelOneQuadrupleSeedPixel(
        std::uint16_t gb,   //
        std::uint16_t b,
@@ -128,7 +246,6 @@ class Encoder
        std::int16_t* YCCC_prev,
        std::uint32_t* A,
        std::uint32_t& N,
-       std::uint32_t N_threshold,
        std::uint8_t last,
        Writter_s writter);
 
@@ -175,15 +292,26 @@ class Encoder
        const std::int16_t* kValues);
 
     void pushBit(Writter_s writter, std::uint32_t bit);
+    void pushBits(Writter_s writter, std::uint32_t bits, std::size_t n);
+    void pushBitsLSBFirst(Writter_s writter, std::uint32_t bits, std::size_t n);
+    void pushBits_1(Writter_s writter, std::size_t n);
     void pushHeader(Writter_s writter, std::uint64_t header);
+    void pushFileHeader(Writter_s writter, std::uint8_t reservedBits = 0);
+    void pushBlockIndex(
+       Writter_s writter,
+       const std::vector<std::uint32_t>& blockSizes_bytes,
+       const std::vector<std::uint32_t>& blockRows = {});
+    void pushCheckpointIndex(Writter_s writter, const std::vector<AgorCheckpoint_s>& checkpoints);
     void pushShort(Writter_s writter, std::uint16_t data);
+    void pushBytes(Writter_s writter, const std::uint8_t* pData, std::size_t n);
+    void pushZeros(Writter_s writter, std::size_t n);
     void pushBit_1(Writter_s writter);
     void pushBit_0(Writter_s writter);
+    void drainBits(Writter_s writter);
+    void writeOutBuffer(Writter_s writter);
     void flushBitstream(Writter_s writter);
     void flushBitstreamNoAlignment(Writter_s writter);
 
-    void dumpBlockSizeToFile(char* filePath, std::vector<std::uint32_t>& blockSizes_bytes);
-
     void dumpAbsToFile(const char* fileName);
     void dumpQuotientToFile(const char* fileName);
     void dumpRemainderToFile(const char* fileName);
@@ -0,0 +1,121 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#    define WIN32_LEAN_AND_MEAN
+#    define NOMINMAX
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+MappedFile::MappedFile(){};
+
+MappedFile::~MappedFile()
+{
+    close();
+};
+
+/**
+ * Maps whole file. Returns false if file cannot be opened or mapped.
+ * Empty file is mapped successfully with size 0.
+*/
+bool MappedFile::open(const char* fileName)
+{
+    close();
+#ifdef _WIN32
+    HANDLE hFile =
+       CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    m_hFile = hFile;
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(hFile, &fileSize)) {
+        close();
+        return false;
+    }
+    m_size = (std::size_t)fileSize.QuadPart;
+    if(m_size == 0) {
+        return true;
+    }
+
+    m_hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(m_hMapping == NULL) {
+        close();
+        return false;
+    }
+    m_pData = (const std::uint8_t*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+    if(m_pData == nullptr) {
+        close();
+        return false;
+    }
+#else
+    int fd = ::open(fileName, O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    m_size = (std::size_t)st.st_size;
+    if(m_size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void* pData = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);   // mapping stays valid after file descriptor is closed
+    if(pData == MAP_FAILED) {
+        m_size = 0;
+        return false;
+    }
+    madvise(pData, m_size, MADV_SEQUENTIAL);
+    madvise(pData, m_size, MADV_WILLNEED);   // start read-ahead now, so that mapping acts as a prefetch
+    m_pData = (const std::uint8_t*)pData;
+#endif
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if(m_pData != nullptr) {
+        UnmapViewOfFile(m_pData);
+    }
+    if(m_hMapping != nullptr) {
+        CloseHandle(m_hMapping);
+    }
+    if(m_hFile != nullptr) {
+        CloseHandle(m_hFile);
+    }
+    m_hMapping = nullptr;
+    m_hFile    = nullptr;
+#else
+    if(m_pData != nullptr) {
+        munmap((void*)m_pData, m_size);
+    }
+#endif
+    m_pData = nullptr;
+    m_size  = 0;
+}
+
+const std::uint8_t* MappedFile::data() const
+{
+    return m_pData;
+};
+
+std::size_t MappedFile::size() const
+{
+    return m_size;
+};
+
+std::span<std::uint8_t const> MappedFile::getDataView() const
+{
+    return {m_pData, m_size};
+}
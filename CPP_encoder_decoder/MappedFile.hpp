@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+
+/**
+ * Read only memory mapping of a whole file. Data is paged in by the OS on first access instead of being copied.
+ * Mapping is released when object is destroyed.
+*/
+class MappedFile
+{
+  private:
+    const std::uint8_t* m_pData = nullptr;
+    std::size_t m_size          = 0;
+#ifdef _WIN32
+    void* m_hFile    = nullptr;
+    void* m_hMapping = nullptr;
+#endif
+
+    void close();
+
+  public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const char* fileName);
+
+    const std::uint8_t* data() const;
+    std::size_t size() const;
+    std::span<std::uint8_t const> getDataView() const;
+};
+
+using pMappedFile = std::unique_ptr<MappedFile>;
@@ -118,28 +118,34 @@ __kernel void bitstream_to_dpcm(
    ushort unaryMaxWidth,
    //    ulong totalPixels,
    ulong bpp,
-   ulong groupByteOffset,
+   __global ulong* blockOffsets,
    int nrOfColumns,
    int nrOfRows,
-   int nrOfRowsInBlock)
+   __global uint* rowFirstInBlock)
 {
 
     int global_id = get_global_id(0);
     int local_id  = get_local_id(0);
 
-    int node_offset   = nrOfRowsInBlock * nrOfColumns * global_id;
+    // work-items beyond the last block (global size is rounded up) and empty trailing blocks have 0 pixels
+    if(pixelsInBlock[global_id] == 0) {
+        return;
+    }
+
+    // 4 channels per quadruplet
+    int node_offset = 4 * rowFirstInBlock[global_id] * nrOfColumns;
 
-    ulong currentByteOffset = groupByteOffset * global_id;
+    ulong currentByteOffset = blockOffsets[global_id];
 
 
     // printf(
-    //    "kernel: bitstream_to_dpcm: GID: %d, LID: %d |, number of rows in a block: %d, group byte off: "
+    //    "kernel: bitstream_to_dpcm: GID: %d, LID: %d |, first row of block: %u, block byte off: "
     //    "%lu, "
     //    "curr byte off: %lu, node off: %d, pixInBlock: %u, quadsInBlock: %u \n",
     //    global_id,
     //    local_id,
-    //    nrOfRowsInBlock,
-    //    groupByteOffset,
+    //    rowFirstInBlock[global_id],
+    //    blockOffsets[global_id],
     //    currentByteOffset,
     //    node_offset,
     //    pixelsInBlock[global_id],
@@ -148,8 +154,8 @@ __kernel void bitstream_to_dpcm(
     /* Variables for bitstream reading */
     // ulong bitStreamSize,
     ulong bitsReadFromByte = 0;
-    ulong byteIdx          = 0;
-    uchar byte             = bitstream[currentByteOffset];   // load first byte
+    ulong byteIdx          = currentByteOffset;   // absolute, kh_fetchBit indexes the whole bitstream
+    uchar byte             = bitstream[byteIdx];   // load first byte
 
     /* Other variable */
 
@@ -225,7 +231,7 @@ __kernel void bitstream_to_dpcm(
         //    idx,
         //    pixelsInBlock,
         //    byteIdx,
-        //    groupByteOffset * (global_id + 1),
+        //    blockOffsets[global_id + 1],
         //    YCCC_dpcm_local[0],
         //    YCCC_dpcm_local[1],
         //    YCCC_dpcm_local[2],
@@ -293,7 +299,7 @@ __kernel void first_column_all_rows(
    __global uint* pixelsInBlock,
    int nrOfColumns,
    int nrOfRows,
-   int nrOfRowsInBlock)
+   __global uint* rowFirstInBlock)
 {
     int global_id = get_global_id(0);
     int local_id  = get_local_id(0);
@@ -302,19 +308,21 @@ __kernel void first_column_all_rows(
     // calculate all pixels in first column
     // CALCULATE ALL YCCC from DPCM
 
-    // int node_offset = nrOfRows/get_local_size(0) * local_id;
-    int node_offset = nrOfRows / nrOfRowsInBlock * nrOfColumns * global_id;
+    if(pixelsInBlock[global_id] == 0) {
+        return;
+    }
 
-    int last_thread_id = nrOfRows / nrOfRowsInBlock;
+    // int node_offset = nrOfRows/get_local_size(0) * local_id;
+    int node_offset = 4 * rowFirstInBlock[global_id] * nrOfColumns;
 
     uint rowsToEvaluate = (pixelsInBlock[global_id]/4)/nrOfColumns;
 
     // printf(
-    //    "kernel: first_col_all_rows | GID: %d, LID: %d, Node off: %d, rows in block: %d, Nr of rows: %d, Nr of pix in block: %u, nr of rows to evaluate %d\n",
+    //    "kernel: first_col_all_rows | GID: %d, LID: %d, Node off: %d, first row of block: %u, Nr of rows: %d, Nr of pix in block: %u, nr of rows to evaluate %d\n",
     //    global_id,
     //    local_id,
     //    node_offset,
-    //    nrOfRowsInBlock,
+    //    rowFirstInBlock[global_id],
     //    nrOfRows,
     //    pixelsInBlock[global_id],
     //    rowsToEvaluate);
@@ -345,4 +353,433 @@ __kernel void first_column_all_rows(
         YCCC[idx_curr + 3] = YCCC[idx_prev + 3] + YCCC_dpcm[idx_curr + 3];
     }
     // }
-}
\ No newline at end of file
+}
+
+/**
+ * Same parsing as one iteration of bitstream_to_dpcm: decodes one quadruplet of DPCM values and updates A and N.
+ * @param quotientInit is unaryMaxWidth for the seed quadruplet (forces binary coding) and 0 otherwise.
+*/
+inline short4 kh_decodeQuadruplet(
+   __global uchar* bitstream,
+   ulong* bitsReadFromByte,
+   ulong* byteIdx,
+   uchar* byte,
+   uint4* A,
+   uint* N,
+   ushort quotientInit,
+   ushort unaryMaxWidth,
+   ulong bpp)
+{
+    uint N_threshold = 8;
+    uint k_seed      = bpp + 3;   // max 12 BPP + 3 = 15
+
+    short4 dpcm;
+    for(uchar ch = 0; ch < 4; ch++) {
+        ushort k = 0;
+        for(uchar it = 0; it < (bpp + 2); it++) {
+            if((*N << k) < (*A)[ch]) {
+                k = k + 1;
+            }
+        }
+
+        ushort quotient = quotientInit;
+        ushort absVal   = 0;
+        uint lastBit;
+        do {   // decode quotient: unary coding
+            lastBit = kh_fetchBit(bitstream, bitsReadFromByte, byteIdx, byte);
+            if(lastBit == 1) {
+                quotient++;
+            }
+        } while(lastBit == 1 && quotient < unaryMaxWidth);
+
+        /* m_unaryMaxWidth * '1' -> indicates binary coding of positive value */
+        if(quotient >= unaryMaxWidth) {
+            for(uint n = 0; n < k_seed; n++) {   //decode remainder
+                lastBit = kh_fetchBit(bitstream, bitsReadFromByte, byteIdx, byte);
+                absVal  = absVal | ((ushort)lastBit << n); /* LSB first */
+            };
+        } else {
+            ushort remainder = 0;
+            for(uint n = 0; n < k; n++) {   //decode remainder
+                lastBit   = kh_fetchBit(bitstream, bitsReadFromByte, byteIdx, byte);
+                remainder = remainder | ((ushort)lastBit << n); /* LSB first*/
+            };
+            absVal = quotient * (1 << k) + remainder;
+        }
+        dpcm[ch] = kh_fromAbs(absVal);
+        (*A)[ch] += dpcm[ch] > 0 ? dpcm[ch] : -dpcm[ch];
+    }
+
+    *N += 1;
+    if(*N >= N_threshold) {
+        *N >>= 1;
+        *A >>= 1;
+    }
+    return dpcm;
+}
+
+/**
+ * Same as kh_YCCC_to_BayerGB_8bit, for a quadruplet held in private memory.
+ * @param idxGB is index of the Gb pixel in the full resolution image of width 2 * @param width.
+*/
+inline void kh_quadrupletToBayerGB_8bit(short4 yccc, __global uchar* bayerGB, uint idxGB, uint width, uint lossyBits)
+{
+    short y  = yccc[0];
+    short cd = yccc[1];
+    short cm = yccc[2];
+    short co = yccc[3];
+
+    // clang-format off
+    bayerGB[idxGB]                 = (uchar)((short)(2 * y + -6 * cd +  4 * cm +  2 * co) >> 3) << lossyBits;   // Gb
+    bayerGB[idxGB + 1]             = (uchar)((short)(2 * y +  2 * cd + -4 * cm + -6 * co) >> 3) << lossyBits;   // B
+    bayerGB[idxGB + 2 * width]     = (uchar)((short)(2 * y +  2 * cd + -4 * cm +  2 * co) >> 3) << lossyBits;   // R
+    bayerGB[idxGB + 2 * width + 1] = (uchar)((short)(2 * y +  2 * cd +  4 * cm +  2 * co) >> 3) << lossyBits;   // Gr
+    // clang-format on
+}
+
+/**
+ * Same as kh_quadrupletToBayerGB_8bit for images of more than 8 BPP.
+*/
+inline void kh_quadrupletToBayerGB_16bit(short4 yccc, __global ushort* bayerGB, uint idxGB, uint width, uint lossyBits)
+{
+    short y  = yccc[0];
+    short cd = yccc[1];
+    short cm = yccc[2];
+    short co = yccc[3];
+
+    // clang-format off
+    bayerGB[idxGB]                 = (ushort)((short)(2 * y + -6 * cd +  4 * cm +  2 * co) >> 3) << lossyBits;   // Gb
+    bayerGB[idxGB + 1]             = (ushort)((short)(2 * y +  2 * cd + -4 * cm + -6 * co) >> 3) << lossyBits;   // B
+    bayerGB[idxGB + 2 * width]     = (ushort)((short)(2 * y +  2 * cd + -4 * cm +  2 * co) >> 3) << lossyBits;   // R
+    bayerGB[idxGB + 2 * width + 1] = (ushort)((short)(2 * y +  2 * cd +  4 * cm +  2 * co) >> 3) << lossyBits;   // Gr
+    // clang-format on
+}
+
+/**
+ * Same as yccc_to_bayergb_8bit for images of more than 8 BPP.
+*/
+__kernel void
+   yccc_to_bayergb_16bit(__global short* YCCC, __global ushort* bayerGB, uint lossyBits, uint width, uint nrOfPixels)
+{
+    int global_id = get_global_id(0);
+
+    int curr_idx = global_id;
+    if(curr_idx < nrOfPixels) {
+        int idxGB = (curr_idx / width) * width * 4 + 2 * (curr_idx % width);
+        kh_quadrupletToBayerGB_16bit(vload4(curr_idx, YCCC), bayerGB, idxGB, width, lossyBits);
+    }
+}
+
+/**
+ * Body of bitstream_to_bayergb_8bit and bitstream_to_bayergb_16bit. Exactly one of @param bayerGB_8bit and
+ * @param bayerGB_16bit is not NULL, the branch on it is the same for all work-items.
+*/
+inline void kh_bitstreamToBayerGB(
+   __global uchar* bitstream,
+   __global uint* pixelsInBlock,
+   __global uchar* bayerGB_8bit,
+   __global ushort* bayerGB_16bit,
+   ushort unaryMaxWidth,
+   ulong bpp,
+   __global ulong* blockOffsets,
+   int nrOfColumns,
+   __global uint* rowFirstInBlock,
+   uint lossyBits)
+{
+    int global_id = get_global_id(0);
+
+    // work-items beyond the last block (global size is rounded up) and empty trailing blocks have 0 pixels
+    if(pixelsInBlock[global_id] == 0) {
+        return;
+    }
+
+    ulong bitsReadFromByte = 0;
+    ulong byteIdx          = blockOffsets[global_id];
+    uchar byte             = bitstream[byteIdx];   // load first byte
+
+    uint A_init = 32;
+    uint4 A     = {A_init, A_init, A_init, A_init};
+    uint N      = 4;
+
+    uint quadsInBlock = pixelsInBlock[global_id] / 4;
+    uint row          = rowFirstInBlock[global_id];
+    uint col          = 0;
+
+    // seed quadruplet
+    short4 rowStart = kh_decodeQuadruplet(
+       bitstream, &bitsReadFromByte, &byteIdx, &byte, &A, &N, unaryMaxWidth, unaryMaxWidth, bpp);
+    short4 left     = rowStart;
+    uint idxGB      = row * nrOfColumns * 4;
+    if(bayerGB_16bit != NULL) {
+        kh_quadrupletToBayerGB_16bit(left, bayerGB_16bit, idxGB, nrOfColumns, lossyBits);
+    } else {
+        kh_quadrupletToBayerGB_8bit(left, bayerGB_8bit, idxGB, nrOfColumns, lossyBits);
+    }
+
+    for(uint idx = 1; idx < quadsInBlock; idx++) {
+        short4 dpcm =
+           kh_decodeQuadruplet(bitstream, &bitsReadFromByte, &byteIdx, &byte, &A, &N, 0, unaryMaxWidth, bpp);
+        col++;
+        if(col == nrOfColumns) {   // new row, predict from the first quadruplet one row up
+            col      = 0;
+            row      = row + 1;
+            rowStart = rowStart + dpcm;
+            left     = rowStart;
+        } else {
+            left = left + dpcm;
+        }
+        idxGB = row * nrOfColumns * 4 + 2 * col;
+        if(bayerGB_16bit != NULL) {
+            kh_quadrupletToBayerGB_16bit(left, bayerGB_16bit, idxGB, nrOfColumns, lossyBits);
+        } else {
+            kh_quadrupletToBayerGB_8bit(left, bayerGB_8bit, idxGB, nrOfColumns, lossyBits);
+        }
+    }
+}
+
+/**
+ * Fused alternative to bitstream_to_dpcm, first_column_all_rows, dpcm_across_rows and yccc_to_bayergb_8bit.
+ * One work-item decodes one block: DPCM values are accumulated in private memory (left neighbour and first
+ * quadruplet of the previous row) and written straight to the Bayer image, so YCCC and YCCC_dpcm never reach
+ * global memory. @param nrOfColumns is width of the channel (half of the image width).
+*/
+__kernel void bitstream_to_bayergb_8bit(
+   __global uchar* bitstream,
+   __global uint* pixelsInBlock,
+   __global uchar* bayerGB,
+   ushort unaryMaxWidth,
+   ulong bpp,
+   __global ulong* blockOffsets,
+   int nrOfColumns,
+   __global uint* rowFirstInBlock,
+   uint lossyBits)
+{
+    kh_bitstreamToBayerGB(
+       bitstream,
+       pixelsInBlock,
+       bayerGB,
+       NULL,
+       unaryMaxWidth,
+       bpp,
+       blockOffsets,
+       nrOfColumns,
+       rowFirstInBlock,
+       lossyBits);
+}
+
+/**
+ * Same as bitstream_to_bayergb_8bit for images of more than 8 BPP.
+*/
+__kernel void bitstream_to_bayergb_16bit(
+   __global uchar* bitstream,
+   __global uint* pixelsInBlock,
+   __global ushort* bayerGB,
+   ushort unaryMaxWidth,
+   ulong bpp,
+   __global ulong* blockOffsets,
+   int nrOfColumns,
+   __global uint* rowFirstInBlock,
+   uint lossyBits)
+{
+    kh_bitstreamToBayerGB(
+       bitstream,
+       pixelsInBlock,
+       NULL,
+       bayerGB,
+       unaryMaxWidth,
+       bpp,
+       blockOffsets,
+       nrOfColumns,
+       rowFirstInBlock,
+       lossyBits);
+}
+
+/**
+ * Next 64 bits of the window starting at bit @param bitPos, MSB first (same order as kh_fetchBit).
+ * At least 57 bits are valid, the rest is zero. Window must have 8 readable bytes after bitPos / 8.
+*/
+inline ulong kh_peekBits64(__local uchar* window, uint bitPos)
+{
+    uint byteIdx = bitPos >> 3;
+    ulong bits   = 0;
+    for(uint i = 0; i < 8; i++) {
+        bits = (bits << 8) | window[byteIdx + i];
+    }
+    return bits << (bitPos & 7);
+}
+
+/**
+ * Reads @param n (max. 32) bits that were written LSB first. Bits above the lowest 16 are dropped, as in kh_fetchBit
+ * based parsing (k_seed is 17 for 14 BPP).
+*/
+inline ushort kh_readBitsLSBFirst(__local uchar* window, uint* bitPos, uint n)
+{
+    if(n == 0) {
+        return 0;
+    }
+    uint bits = (uint)(kh_peekBits64(window, *bitPos) >> (64 - n));
+    *bitPos += n;
+
+    // reverse all 32 bits, then drop the ones that were not read
+    bits = ((bits >> 1) & 0x55555555) | ((bits & 0x55555555) << 1);
+    bits = ((bits >> 2) & 0x33333333) | ((bits & 0x33333333) << 2);
+    bits = ((bits >> 4) & 0x0F0F0F0F) | ((bits & 0x0F0F0F0F) << 4);
+    bits = ((bits >> 8) & 0x00FF00FF) | ((bits & 0x00FF00FF) << 8);
+    bits = (bits >> 16) | (bits << 16);
+    return (ushort)(bits >> (32 - n));
+}
+
+/**
+ * Same as kh_decodeQuadruplet, bits are read from a window in local memory. Unary part is counted with clz on a
+ * 64-bit peek instead of bit by bit. Quadruplet must fit into the window (see bitstream_to_dpcm_local).
+*/
+inline short4 kh_decodeQuadrupletLocal(
+   __local uchar* window,
+   uint* bitPos,
+   uint4* A,
+   uint* N,
+   ushort quotientInit,
+   ushort unaryMaxWidth,
+   uint bpp)
+{
+    uint N_threshold = 8;
+    uint k_seed      = bpp + 3;   // max 12 BPP + 3 = 15
+
+    short4 dpcm;
+    for(uchar ch = 0; ch < 4; ch++) {
+        ushort k = 0;
+        for(uchar it = 0; it < (bpp + 2); it++) {
+            if((*N << k) < (*A)[ch]) {
+                k = k + 1;
+            }
+        }
+
+        ushort quotient = quotientInit;
+        if(quotient >= unaryMaxWidth) {
+            *bitPos += 1;   // seed: only the delimiter
+        } else {
+            for(;;) {   // decode quotient: unary coding, ends with '0' or after unaryMaxWidth '1's
+                ulong bits = kh_peekBits64(window, *bitPos);
+                uint ones  = clz(~bits);
+                uint valid = 64 - (*bitPos & 7);
+                uint need  = unaryMaxWidth - quotient;
+                if(ones >= need) {
+                    quotient += need;
+                    *bitPos += need;
+                    break;
+                }
+                quotient += ones;
+                if(ones < valid) {
+                    *bitPos += ones + 1;
+                    break;
+                }
+                *bitPos += ones;
+            }
+        }
+
+        ushort absVal;
+        /* m_unaryMaxWidth * '1' -> indicates binary coding of positive value */
+        if(quotient >= unaryMaxWidth) {
+            absVal = kh_readBitsLSBFirst(window, bitPos, k_seed);
+        } else {
+            absVal = quotient * (1 << k) + kh_readBitsLSBFirst(window, bitPos, k);
+        }
+        dpcm[ch] = kh_fromAbs(absVal);
+        (*A)[ch] += dpcm[ch] > 0 ? dpcm[ch] : -dpcm[ch];
+    }
+
+    *N += 1;
+    if(*N >= N_threshold) {
+        *N >>= 1;
+        *A >>= 1;
+    }
+    return dpcm;
+}
+
+/**
+ * Same result as bitstream_to_dpcm, bitstream is parsed from local memory. Decoding runs in rounds: the work-group
+ * cooperatively copies a window of @param windowVecs x 16 B per work-item, starting at the work-item's current
+ * position, with consecutive work-items loading consecutive 16 B of the same window (coalesced). Then every
+ * work-item decodes as long as the next quadruplet surely fits into its window (@param maxQuadrupletBits).
+ * Bitstream buffer needs windowVecs x 16 B of padding after the last block.
+ * @param windows holds windowVecs uint4 per work-item, @param windowStart one uint per work-item.
+ * All work-items of a work-group reach the barriers, work-items without pixels only help with the copies.
+*/
+__kernel void bitstream_to_dpcm_local(
+   __global uint4* bitstream,
+   __global uint* pixelsInBlock,
+   __global short* YCCC_dpcm,
+   __global short* YCCC,
+   ushort unaryMaxWidth,
+   uint bpp,
+   __global ulong* blockOffsets,
+   int nrOfColumns,
+   __global uint* rowFirstInBlock,
+   __local uint4* windows,
+   __local uint* windowStart,
+   uint windowVecs,
+   uint maxQuadrupletBits)
+{
+    __local int anyActive[2];
+
+    int global_id  = get_global_id(0);
+    int local_id   = get_local_id(0);
+    int local_size = get_local_size(0);
+
+    int node_offset = 4 * rowFirstInBlock[global_id] * nrOfColumns;
+
+    uint quadsInBlock = pixelsInBlock[global_id] / 4;
+    uint idx          = 0;
+    ulong absBitPos   = blockOffsets[global_id] * 8;   // position in the whole bitstream
+
+    uint A_init = 32;
+    uint4 A     = {A_init, A_init, A_init, A_init};
+    uint N      = 4;
+
+    __local uchar* window = (__local uchar*)(windows + local_id * windowVecs);
+    uint windowBits       = windowVecs * 16 * 8;
+
+    if(local_id == 0) {
+        anyActive[0] = 0;
+    }
+
+    for(uint pass = 0;; pass++) {
+        barrier(CLK_LOCAL_MEM_FENCE);   // previous round decoded, windows may be overwritten
+
+        // in uint4, aligned down to 16 B; finished work-items have nothing to copy
+        windowStart[local_id] = idx < quadsInBlock ? (uint)(absBitPos >> 7) : 0xFFFFFFFF;
+        if(idx < quadsInBlock) {
+            anyActive[pass & 1] = 1;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+        if(anyActive[pass & 1] == 0) {
+            break;
+        }
+        if(local_id == 0) {
+            anyActive[(pass + 1) & 1] = 0;
+        }
+
+        for(uint i = local_id; i < local_size * windowVecs; i += local_size) {
+            uint owner = i / windowVecs;
+            if(windowStart[owner] != 0xFFFFFFFF) {
+                windows[i] = bitstream[windowStart[owner] + i % windowVecs];
+            }
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if(idx < quadsInBlock) {
+            uint bitPos = (uint)(absBitPos - ((ulong)windowStart[local_id] << 7));
+            // 64 bits of slack for the last peek
+            while(idx < quadsInBlock && bitPos + maxQuadrupletBits + 64 <= windowBits) {
+                short4 dpcm = kh_decodeQuadrupletLocal(
+                   window, &bitPos, &A, &N, idx == 0 ? unaryMaxWidth : 0, unaryMaxWidth, bpp);
+                vstore4(dpcm, node_offset / 4 + idx, YCCC_dpcm);
+                if(idx == 0) {
+                    vstore4(dpcm, node_offset / 4, YCCC);   // seed
+                }
+                idx++;
+            }
+            absBitPos = ((ulong)windowStart[local_id] << 7) + bitPos;
+        }
+    }
+}
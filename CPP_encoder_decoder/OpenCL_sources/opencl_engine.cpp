@@ -0,0 +1,444 @@
+
+#include "opencl_engine.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+namespace
+{
+std::string getDeviceInfoString(cl_device_id device, cl_device_info param)
+{
+    std::size_t size = 0;
+    if(clGetDeviceInfo(device, param, 0, NULL, &size) != CL_SUCCESS || size == 0) {
+        return "";
+    }
+    std::string value(size, '\0');
+    clGetDeviceInfo(device, param, size, value.data(), NULL);
+    value.resize(std::strlen(value.c_str()));
+    return value;
+}
+}   // namespace
+
+OpenCLEngine& OpenCLEngine::getInstance()
+{
+    static OpenCLEngine engine;
+    return engine;
+}
+
+OpenCLEngine::~OpenCLEngine()
+{
+    release();
+}
+
+/**
+ * Sets up device, context, queue, program and kernels on first call. Later calls return the first result,
+ * so a box without OpenCL reports the failure once and is not probed again for every frame.
+*/
+cl_int OpenCLEngine::init()
+{
+    if(m_ready || m_initStatus != CL_SUCCESS) {
+        return m_initStatus;
+    }
+
+    identify_platforms();
+
+    cl_int status = selectDevice();
+    if(status == CL_SUCCESS) {
+        m_context = clCreateContext(NULL, 1, &m_device, NULL, NULL, &status);
+        evaluateReturnStatus(status);
+    }
+    if(status == CL_SUCCESS) {
+        m_slots.resize(1);
+        status = createQueue(m_slots[0]);
+    }
+    if(status == CL_SUCCESS) {
+        status = clGetDeviceInfo(
+           m_device, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(m_maxWorkGroupSize), &m_maxWorkGroupSize, NULL);
+        evaluateReturnStatus(status);
+    }
+    if(status == CL_SUCCESS) {
+        status = clGetDeviceInfo(m_device, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(m_localMemSize), &m_localMemSize, NULL);
+        evaluateReturnStatus(status);
+    }
+    if(status == CL_SUCCESS) {
+        status = clGetDeviceInfo(m_device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(m_computeUnits), &m_computeUnits, NULL);
+        evaluateReturnStatus(status);
+    }
+    if(status == CL_SUCCESS) {
+        status = buildProgram();
+    }
+    if(status == CL_SUCCESS) {
+        const char* kernelNames[(std::size_t)kernel::count] = {
+           "bitstream_to_dpcm",
+           "first_column_all_rows",
+           "dpcm_across_rows",
+           "yccc_to_bayergb_8bit",
+           "bitstream_to_bayergb_8bit",
+           "bitstream_to_dpcm_local",
+           "yccc_to_bayergb_16bit",
+           "bitstream_to_bayergb_16bit"};
+        for(std::size_t k = 0; k < (std::size_t)kernel::count && status == CL_SUCCESS; k++) {
+            m_kernels[k] = clCreateKernel(m_program, kernelNames[k], &status);
+            evaluateReturnStatus(status);
+        }
+    }
+
+    if(status != CL_SUCCESS) {
+        printf("OpenCLEngine: initialization failed: %s\n", getErrorString(status));
+        release();
+        m_initStatus = status;
+        return status;
+    }
+
+    m_ready = true;
+    return CL_SUCCESS;
+}
+
+bool OpenCLEngine::isReady() const
+{
+    return m_ready;
+}
+
+/**
+ * Makes sure slots 0..nrOfSlots-1 exist, each with its own command queue. Slots are never removed.
+*/
+cl_int OpenCLEngine::setNrOfSlots(std::size_t nrOfSlots)
+{
+    if(!m_ready) {
+        return CL_INVALID_CONTEXT;
+    }
+    while(m_slots.size() < nrOfSlots) {
+        Slot_s slot;
+        cl_int status = createQueue(slot);
+        if(status != CL_SUCCESS) {
+            return status;
+        }
+        m_slots.push_back(slot);
+    }
+    return CL_SUCCESS;
+}
+
+std::size_t OpenCLEngine::getNrOfSlots() const
+{
+    return m_slots.size();
+}
+
+/**
+ * Returns pooled device buffer <id> of slot <slot> of at least <size> bytes. Buffer is recreated only when
+ * it is too small or was created with other flags; its content is not preserved then.
+*/
+cl_mem OpenCLEngine::getBuffer(buffer id, std::size_t size, cl_mem_flags flags, std::size_t slot)
+{
+    Slot_s& s       = m_slots[slot];
+    std::size_t idx = (std::size_t)id;
+    if(s.buffers[idx] != nullptr && s.bufferSizes[idx] >= size && s.bufferFlags[idx] == flags) {
+        return s.buffers[idx];
+    }
+    if(s.buffers[idx] != nullptr) {
+        clReleaseMemObject(s.buffers[idx]);
+        s.buffers[idx]     = nullptr;
+        s.bufferSizes[idx] = 0;
+    }
+
+    cl_int status  = CL_SUCCESS;
+    s.buffers[idx] = clCreateBuffer(m_context, flags, size, NULL, &status);
+    if(evaluateReturnStatus(status)) {
+        s.buffers[idx] = nullptr;
+        return nullptr;
+    }
+    s.bufferSizes[idx] = size;
+    s.bufferFlags[idx] = flags;
+    return s.buffers[idx];
+}
+
+/**
+ * Returns host pointer to pinned (page locked) staging buffer <id> of slot <slot> of at least <size> bytes.
+ * Transfers between device buffers and this memory can run as DMA, asynchronously to the host.
+ * Pointer stays valid until the buffer grows; caller must not grow it while a transfer from it is in flight.
+*/
+void* OpenCLEngine::getPinnedBuffer(pinned id, std::size_t size, std::size_t slot)
+{
+    Slot_s& s       = m_slots[slot];
+    std::size_t idx = (std::size_t)id;
+    if(s.pinnedHost[idx] != nullptr && s.pinnedSizes[idx] >= size) {
+        return s.pinnedHost[idx];
+    }
+    releasePinnedBuffer(s, idx);
+
+    cl_int status        = CL_SUCCESS;
+    s.pinnedBuffers[idx] = clCreateBuffer(m_context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, size, NULL, &status);
+    if(evaluateReturnStatus(status)) {
+        s.pinnedBuffers[idx] = nullptr;
+        return nullptr;
+    }
+    s.pinnedHost[idx] = clEnqueueMapBuffer(
+       s.queue, s.pinnedBuffers[idx], CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, size, 0, NULL, NULL, &status);
+    if(evaluateReturnStatus(status)) {
+        releasePinnedBuffer(s, idx);
+        return nullptr;
+    }
+    s.pinnedSizes[idx] = size;
+    return s.pinnedHost[idx];
+}
+
+cl_context OpenCLEngine::getContext() const
+{
+    return m_context;
+}
+
+cl_command_queue OpenCLEngine::getQueue(std::size_t slot) const
+{
+    return m_slots[slot].queue;
+}
+
+cl_device_id OpenCLEngine::getDevice() const
+{
+    return m_device;
+}
+
+cl_kernel OpenCLEngine::getKernel(kernel id) const
+{
+    return m_kernels[(std::size_t)id];
+}
+
+std::size_t OpenCLEngine::getMaxWorkGroupSize() const
+{
+    return m_maxWorkGroupSize;
+}
+
+std::size_t OpenCLEngine::getLocalMemSize() const
+{
+    return m_localMemSize;
+}
+
+std::size_t OpenCLEngine::getComputeUnits() const
+{
+    return m_computeUnits;
+}
+
+cl_int OpenCLEngine::createQueue(Slot_s& slot)
+{
+    cl_int status                          = CL_SUCCESS;
+    cl_queue_properties queue_properties[] = {CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0};
+
+    slot.queue = clCreateCommandQueueWithProperties(m_context, m_device, queue_properties, &status);
+    evaluateReturnStatus(status);
+    return status;
+}
+
+cl_int OpenCLEngine::selectDevice()
+{
+    cl_uint numPlatforms = 0;
+    cl_int status        = clGetPlatformIDs(0, NULL, &numPlatforms);
+    if(status != CL_SUCCESS || numPlatforms == 0) {
+        printf("OpenCLEngine: no OpenCL platform found.\n");
+        return status != CL_SUCCESS ? status : CL_DEVICE_NOT_FOUND;
+    }
+    std::vector<cl_platform_id> platforms(numPlatforms);
+    status = clGetPlatformIDs(numPlatforms, platforms.data(), NULL);
+    if(evaluateReturnStatus(status)) {
+        return status;
+    }
+
+    std::vector<cl_device_type> deviceTypes = {CL_DEVICE_TYPE_GPU, CL_DEVICE_TYPE_ALL};
+    if(const char* env = std::getenv("OPENCL_DEVICE_TYPE")) {
+        if(std::strcmp(env, "cpu") == 0) {
+            deviceTypes = {CL_DEVICE_TYPE_CPU};
+        } else if(std::strcmp(env, "gpu") == 0) {
+            deviceTypes = {CL_DEVICE_TYPE_GPU};
+        } else if(std::strcmp(env, "all") == 0) {
+            deviceTypes = {CL_DEVICE_TYPE_ALL};
+        } else {
+            printf("OpenCLEngine: unknown OPENCL_DEVICE_TYPE '%s', expected cpu, gpu or all.\n", env);
+        }
+    }
+
+    for(cl_device_type deviceType : deviceTypes) {
+        for(cl_platform_id platform : platforms) {
+            cl_uint numDevices = 0;
+            cl_device_id device;
+            if(clGetDeviceIDs(platform, deviceType, 1, &device, &numDevices) == CL_SUCCESS && numDevices > 0) {
+                m_platform = platform;
+                m_device   = device;
+                printf("OpenCLEngine: using device %s.\n", getDeviceInfoString(device, CL_DEVICE_NAME).c_str());
+                return CL_SUCCESS;
+            }
+        }
+    }
+
+    printf("OpenCLEngine: no suitable OpenCL device found.\n");
+    return CL_DEVICE_NOT_FOUND;
+}
+
+/**
+ * Builds kernels.cl for the selected device. Binary of a previous build is loaded from
+ * OpenCL_sources/kernels_<key>.bin when present, where key hashes kernel source, device name and driver version,
+ * so an edited kernel or updated driver does not pick up a stale binary.
+*/
+cl_int OpenCLEngine::buildProgram()
+{
+    std::filesystem::path kernelFilePath = std::filesystem::current_path() / "OpenCL_sources/kernels.cl";
+
+    std::ifstream rf(kernelFilePath, std::ios::in | std::ios::binary);
+    if(!rf) {
+        std::cout << "OpenCLEngine: cannot open kernel file " << kernelFilePath << std::endl;
+        return CL_INVALID_PROGRAM;
+    }
+    std::string source((std::istreambuf_iterator<char>(rf)), std::istreambuf_iterator<char>());
+    rf.close();
+
+    std::string key = source + getDeviceInfoString(m_device, CL_DEVICE_NAME)
+                      + getDeviceInfoString(m_device, CL_DRIVER_VERSION);
+    char keyString[32];
+    sprintf(keyString, "%016zx", std::hash<std::string>{}(key));
+    std::string cachePath = (kernelFilePath.parent_path() / ("kernels_" + std::string(keyString) + ".bin")).string();
+
+    if(loadProgramBinary(cachePath) == CL_SUCCESS) {
+        printf("OpenCLEngine: loaded program binary %s\n", cachePath.c_str());
+        return CL_SUCCESS;
+    }
+
+    const char* sourcePtr  = source.c_str();
+    std::size_t sourceSize = source.size();
+    cl_int status          = CL_SUCCESS;
+    m_program              = clCreateProgramWithSource(m_context, 1, &sourcePtr, &sourceSize, &status);
+    if(evaluateReturnStatus(status)) {
+        return status;
+    }
+
+    status = clBuildProgram(m_program, 1, &m_device, NULL, NULL, NULL);
+    if(status != CL_SUCCESS) {
+        printf("Error: Failed to build program executable!\n");
+        std::size_t len = 0;
+        clGetProgramBuildInfo(m_program, m_device, CL_PROGRAM_BUILD_LOG, 0, NULL, &len);
+        std::string buildLog(len, '\0');
+        clGetProgramBuildInfo(m_program, m_device, CL_PROGRAM_BUILD_LOG, len, buildLog.data(), NULL);
+        printf("%s\n", buildLog.c_str());
+        return status;
+    }
+
+    storeProgramBinary(cachePath);
+    return CL_SUCCESS;
+}
+
+cl_int OpenCLEngine::loadProgramBinary(const std::string& cachePath)
+{
+    std::ifstream rf(cachePath, std::ios::in | std::ios::binary);
+    if(!rf) {
+        return CL_INVALID_BINARY;
+    }
+    std::vector<unsigned char> binary((std::istreambuf_iterator<char>(rf)), std::istreambuf_iterator<char>());
+    rf.close();
+    if(binary.empty()) {
+        return CL_INVALID_BINARY;
+    }
+
+    const unsigned char* binaryPtr = binary.data();
+    std::size_t binarySize         = binary.size();
+    cl_int binaryStatus            = CL_SUCCESS;
+    cl_int status                  = CL_SUCCESS;
+    m_program = clCreateProgramWithBinary(m_context, 1, &m_device, &binarySize, &binaryPtr, &binaryStatus, &status);
+    if(status == CL_SUCCESS && binaryStatus != CL_SUCCESS) {
+        status = binaryStatus;
+    }
+    if(status == CL_SUCCESS) {
+        status = clBuildProgram(m_program, 1, &m_device, NULL, NULL, NULL);
+    }
+    if(status != CL_SUCCESS) {
+        // Stale or foreign binary: fall back to building from source, which overwrites the cache file.
+        printf(
+           "OpenCLEngine: program binary %s rejected (%s), rebuilding.\n", cachePath.c_str(), getErrorString(status));
+        if(m_program != nullptr) {
+            clReleaseProgram(m_program);
+            m_program = nullptr;
+        }
+    }
+    return status;
+}
+
+void OpenCLEngine::storeProgramBinary(const std::string& cachePath)
+{
+    std::size_t binarySize = 0;
+    cl_int status = clGetProgramInfo(m_program, CL_PROGRAM_BINARY_SIZES, sizeof(binarySize), &binarySize, NULL);
+    if(status != CL_SUCCESS || binarySize == 0) {
+        return;
+    }
+    std::vector<unsigned char> binary(binarySize);
+    unsigned char* binaryPtr = binary.data();
+    status                   = clGetProgramInfo(m_program, CL_PROGRAM_BINARIES, sizeof(binaryPtr), &binaryPtr, NULL);
+    if(evaluateReturnStatus(status)) {
+        return;
+    }
+
+    // Written under a temporary name and renamed, so a concurrently starting process never reads half a binary.
+    std::string tmpPath = cachePath + ".tmp";
+    std::ofstream wf(tmpPath, std::ios::out | std::ios::binary);
+    if(!wf) {
+        return;
+    }
+    wf.write((const char*)binary.data(), binary.size());
+    wf.close();
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, cachePath, ec);
+    if(ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return;
+    }
+    printf("OpenCLEngine: stored program binary %s\n", cachePath.c_str());
+}
+
+void OpenCLEngine::releasePinnedBuffer(Slot_s& slot, std::size_t idx)
+{
+    if(slot.pinnedHost[idx] != nullptr) {
+        clEnqueueUnmapMemObject(slot.queue, slot.pinnedBuffers[idx], slot.pinnedHost[idx], 0, NULL, NULL);
+        clFinish(slot.queue);
+        slot.pinnedHost[idx] = nullptr;
+    }
+    if(slot.pinnedBuffers[idx] != nullptr) {
+        clReleaseMemObject(slot.pinnedBuffers[idx]);
+        slot.pinnedBuffers[idx] = nullptr;
+    }
+    slot.pinnedSizes[idx] = 0;
+}
+
+void OpenCLEngine::release()
+{
+    for(Slot_s& slot : m_slots) {
+        for(std::size_t p = 0; p < (std::size_t)pinned::count; p++) {
+            releasePinnedBuffer(slot, p);
+        }
+        for(std::size_t b = 0; b < (std::size_t)buffer::count; b++) {
+            if(slot.buffers[b] != nullptr) {
+                clReleaseMemObject(slot.buffers[b]);
+            }
+        }
+        if(slot.queue != nullptr) {
+            clReleaseCommandQueue(slot.queue);
+        }
+    }
+    m_slots.clear();
+    for(std::size_t k = 0; k < (std::size_t)kernel::count; k++) {
+        if(m_kernels[k] != nullptr) {
+            clReleaseKernel(m_kernels[k]);
+            m_kernels[k] = nullptr;
+        }
+    }
+    if(m_program != nullptr) {
+        clReleaseProgram(m_program);
+        m_program = nullptr;
+    }
+    if(m_context != nullptr) {
+        clReleaseContext(m_context);
+        m_context = nullptr;
+    }
+    m_device   = nullptr;
+    m_platform = nullptr;
+    m_ready    = false;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "opencl_platforms.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Long-lived OpenCL state of the decoder: device, context, command queue, program with kernels
+ * and a pool of device buffers. Device discovery and program build are done once, on first init().
+ * Program binary is cached on disk next to kernels.cl and reused while kernel source and device/driver are the same.
+ * Device buffers only grow, so frames of the same (or smaller) geometry do not allocate device memory.
+ *
+ * Queue and buffers are kept per slot. Slot 0 always exists; streaming decode keeps one frame in flight per slot
+ * (see setNrOfSlots), each on its own in-order queue with its own device buffers and pinned host staging buffers,
+ * so that transfers of one frame can overlap kernels of another.
+ *
+ * GPU is preferred. When no platform has one, first available device of any type is used (e.g. PoCL on CPU),
+ * OPENCL_DEVICE_TYPE=cpu|gpu|all environment variable overrides the choice.
+ * Not thread safe: kernels and buffers are shared, all enqueueing is done from one thread.
+ */
+class OpenCLEngine
+{
+  public:
+    enum class kernel
+    {
+        bitstreamToDpcm,
+        firstColumnAllRows,
+        dpcmAcrossRows,
+        ycccToBayerGB_8bit,
+        bitstreamToBayerGB_8bit,   // fused alternative to the four kernels above
+        bitstreamToDpcm_local,     // bitstreamToDpcm parsing from local memory
+        ycccToBayerGB_16bit,       // ushort output for more than 8 BPP
+        bitstreamToBayerGB_16bit,
+        count
+    };
+
+    enum class buffer
+    {
+        bitStream,
+        blockOffsets,
+        pixelsInBlock,
+        rowFirstInBlock,
+        YCCC,
+        YCCC_dpcm,
+        bayerGB,
+        count
+    };
+
+    enum class pinned
+    {
+        bitStream,
+        bayerGB,
+        count
+    };
+
+    static OpenCLEngine& getInstance();
+
+    OpenCLEngine(const OpenCLEngine&)            = delete;
+    OpenCLEngine& operator=(const OpenCLEngine&) = delete;
+    ~OpenCLEngine();
+
+    cl_int init();
+    bool isReady() const;
+
+    cl_int setNrOfSlots(std::size_t nrOfSlots);
+    std::size_t getNrOfSlots() const;
+
+    cl_mem getBuffer(buffer id, std::size_t size, cl_mem_flags flags, std::size_t slot = 0);
+    void* getPinnedBuffer(pinned id, std::size_t size, std::size_t slot = 0);
+
+    cl_context getContext() const;
+    cl_command_queue getQueue(std::size_t slot = 0) const;
+    cl_device_id getDevice() const;
+    cl_kernel getKernel(kernel id) const;
+    std::size_t getMaxWorkGroupSize() const;
+    std::size_t getLocalMemSize() const;
+    std::size_t getComputeUnits() const;
+
+  private:
+    struct Slot_s {
+        cl_command_queue queue = nullptr;
+
+        cl_mem buffers[(std::size_t)buffer::count]           = {};
+        std::size_t bufferSizes[(std::size_t)buffer::count]  = {};
+        cl_mem_flags bufferFlags[(std::size_t)buffer::count] = {};
+
+        // CL_MEM_ALLOC_HOST_PTR buffers, mapped for the whole lifetime; pinnedHost is the mapped pointer
+        cl_mem pinnedBuffers[(std::size_t)pinned::count]    = {};
+        void* pinnedHost[(std::size_t)pinned::count]        = {};
+        std::size_t pinnedSizes[(std::size_t)pinned::count] = {};
+    };
+
+    OpenCLEngine() = default;
+
+    cl_int selectDevice();
+    cl_int createQueue(Slot_s& slot);
+    cl_int buildProgram();
+    cl_int loadProgramBinary(const std::string& cachePath);
+    void storeProgramBinary(const std::string& cachePath);
+    void releasePinnedBuffer(Slot_s& slot, std::size_t idx);
+    void release();
+
+    bool m_ready                   = false;
+    cl_int m_initStatus            = CL_SUCCESS;
+    cl_platform_id m_platform      = nullptr;
+    cl_device_id m_device          = nullptr;
+    cl_context m_context           = nullptr;
+    cl_program m_program           = nullptr;
+    std::size_t m_maxWorkGroupSize = 1;
+    cl_ulong m_localMemSize        = 0;
+    cl_uint m_computeUnits         = 1;
+
+    cl_kernel m_kernels[(std::size_t)kernel::count] = {};
+    std::vector<Slot_s> m_slots;
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Base of a frame travelling through runFramePipeline. When load or process throws, its message is kept in error,
+ * remaining stages except store are skipped for that frame. Store is expected to report it.
+*/
+struct PipelineFrame_s {
+    std::size_t imgIdx = 0;
+    std::string error;
+};
+
+/**
+ * Processes frames imgIdx_min..imgIdx_max in three overlapping stages:
+ * - one loader thread calls load() for upcoming frames in order,
+ * - <nrOfWorkers> threads call process() on loaded frames concurrently, in any order,
+ * - calling thread calls store() strictly in frame order.
+ * At most <queueDepth> frames are in flight (loaded but not yet stored), which bounds memory use.
+ * Frame must derive from PipelineFrame_s and be default constructible.
+*/
+template<typename Frame>
+void runFramePipeline(
+   std::size_t imgIdx_min,
+   std::size_t imgIdx_max,
+   std::size_t nrOfWorkers,
+   std::size_t queueDepth,
+   std::function<void(Frame&)> load,
+   std::function<void(Frame&)> process,
+   std::function<void(Frame&)> store)
+{
+    nrOfWorkers = std::max<std::size_t>(nrOfWorkers, 1);
+    queueDepth  = std::max<std::size_t>(queueDepth, 1);
+
+    std::mutex mtx;
+    std::condition_variable cv_loaded;   // loader -> workers
+    std::condition_variable cv_done;   // workers -> store
+    std::condition_variable cv_space;   // store -> loader
+    std::deque<std::unique_ptr<Frame>> loaded;
+    std::map<std::size_t, std::unique_ptr<Frame>> done;
+    std::size_t inFlight = 0;
+    bool loaderFinished  = false;
+    bool abortPipeline   = false;
+
+    auto runStage = [](std::function<void(Frame&)>& stage, Frame& frame) {
+        if(!frame.error.empty()) {
+            return;
+        }
+        try {
+            stage(frame);
+        } catch(std::exception& e) {
+            frame.error = e.what();
+        }
+    };
+
+    std::thread loader([&]() {
+        for(std::size_t imgIdx = imgIdx_min; imgIdx <= imgIdx_max; imgIdx++) {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv_space.wait(lock, [&]() { return inFlight < queueDepth || abortPipeline; });
+                if(abortPipeline) {
+                    break;
+                }
+                inFlight++;
+            }
+            auto frame    = std::make_unique<Frame>();
+            frame->imgIdx = imgIdx;
+            runStage(load, *frame);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                loaded.push_back(std::move(frame));
+            }
+            cv_loaded.notify_one();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            loaderFinished = true;
+        }
+        cv_loaded.notify_all();
+    });
+
+    auto worker = [&]() {
+        while(true) {
+            std::unique_ptr<Frame> frame;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv_loaded.wait(lock, [&]() { return !loaded.empty() || loaderFinished; });
+                if(loaded.empty()) {
+                    return;
+                }
+                frame = std::move(loaded.front());
+                loaded.pop_front();
+            }
+            runStage(process, *frame);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                std::size_t imgIdx = frame->imgIdx;
+                done[imgIdx]       = std::move(frame);
+            }
+            cv_done.notify_one();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(nrOfWorkers);
+    for(std::size_t w = 0; w < nrOfWorkers; w++) {
+        workers.emplace_back(worker);
+    }
+
+    try {
+        for(std::size_t imgIdx = imgIdx_min; imgIdx <= imgIdx_max; imgIdx++) {
+            std::unique_ptr<Frame> frame;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv_done.wait(lock, [&]() { return done.count(imgIdx) != 0; });
+                frame = std::move(done[imgIdx]);
+                done.erase(imgIdx);
+            }
+            store(*frame);   // store reports frame.error itself
+            frame.reset();   // release frame memory before loader reuses the slot
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                inFlight--;
+            }
+            cv_space.notify_one();
+        }
+    } catch(...) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            abortPipeline = true;
+        }
+        cv_space.notify_all();
+        loader.join();
+        for(auto& w : workers) {
+            w.join();
+        }
+        throw;
+    }
+
+    loader.join();
+    for(auto& w : workers) {
+        w.join();
+    }
+}
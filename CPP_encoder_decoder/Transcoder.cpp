@@ -0,0 +1,67 @@
+#include "Transcoder.hpp"
+#include "Encoder.hpp"
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * Transcodes compressed image @param bitStream (any layout) to @param out with <nrOfBlocks> blocks
+ * (0: no blocks), or with <nrOfBlocks> checkpoints when @param checkpoints is set. With @param balanced, blocks
+ * have roughly equal compressed size instead of equal row count (see Encoder::encodeToBuffer). Encoding runs on
+ * the calling thread, frames are expected to be transcoded concurrently. Returns header of the source image.
+*/
+headerData_t Transcoder::transcodeToBuffer(
+   std::span<std::uint8_t const> bitStream,
+   std::vector<std::uint8_t>& out,
+   std::size_t nrOfBlocks,
+   bool checkpoints,
+   bool balanced)
+{
+    headerData_t headerData = Decoder::readHeader(bitStream);
+
+    // checkpoint stream is decoded serially from its start, checkpoints of the source are not needed
+    std::vector<std::uint32_t> blockSizes;
+    std::vector<std::uint32_t> blockRows;
+    std::vector<AgorCheckpoint_s> sourceCheckpoints;
+    std::size_t payloadOffset =
+       Decoder::readBlockIndex(bitStream, headerData, blockSizes, blockRows, sourceCheckpoints);
+
+    m_YCCC.resize((std::size_t)headerData.width * headerData.height);
+    auto status = DecoderBase::decodeToYCCC_actual(
+       headerData.width,
+       headerData.height,
+       headerData.unaryMaxWidth,
+       headerData.bpp,
+       bitStream.data() + payloadOffset,
+       bitStream.size() - payloadOffset,
+       m_YCCC.data(),
+       m_YCCC.size(),
+       blockSizes,
+       blockRows);
+    if(status) {
+        DecoderBase::handleReturnValue(status);
+        throw std::runtime_error("Decoding to YCCC unsuccessful.");
+    }
+
+    // decoder always starts with A_init 32 and N_threshold 8
+    Encoder enc{
+       std::span<std::int16_t const>(m_YCCC),
+       headerData.width,
+       headerData.height,
+       32,
+       8,
+       headerData.lossyBits,
+       headerData.unaryMaxWidth,
+       headerData.bpp};
+    if(nrOfBlocks == 0) {
+        enc.encodeToBuffer(out);
+    } else if(checkpoints) {
+        enc.encodeToBufferWithCheckpoints(out, nrOfBlocks);
+    } else {
+        std::vector<std::uint32_t> blockSizes_bytes;
+        enc.encodeToBuffer(out, blockSizes_bytes, nrOfBlocks, 1, balanced);
+    }
+
+    // encoder writes current time and full image ROI, keep timestamp and ROI (header bytes 0 - 15) of the source
+    std::memcpy(out.data(), bitStream.data(), 2 * sizeof(std::uint64_t));
+    return headerData;
+}
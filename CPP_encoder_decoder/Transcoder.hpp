@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Decoder.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * Changes layout of a compressed image (independent blocks, one AGOR stream with checkpoints, or neither) without
+ * BayerCFA round trip: payload is decoded to YCCC and encoded again by the same AGOR coder, so the decoded image is
+ * unchanged. Timestamp, ROI and compression parameters of the source are kept.
+ * YCCC buffer is reused between frames, use one instance per thread.
+*/
+class Transcoder
+{
+  private:
+    std::vector<std::int16_t> m_YCCC;
+
+  public:
+    headerData_t transcodeToBuffer(
+       std::span<std::uint8_t const> bitStream,
+       std::vector<std::uint8_t>& out,
+       std::size_t nrOfBlocks,
+       bool checkpoints = false,
+       bool balanced = false);
+};
@@ -0,0 +1,619 @@
+#ifdef BENCHMARK
+
+// Benchmark of encoder and decoder backends. Build with -D BENCHMARK (and -D TIMING_EN for per-stage breakdown).
+// example command:
+// benchmark.exe -x 2048 -y 1536 -n 2 -B 0,32,64,128,256 -k 10 -o ../images/wallpapers/statistics_blocks
+// benchmark.exe -i ../images/lite_dataset -f img_8bpp_ -s 0 -e 3 -b 16 -B 0,64 -o statistics
+
+#    include <algorithm>
+#    include <chrono>
+#    include <cstdio>
+#    include <cstring>
+#    include <fstream>
+#    include <functional>
+#    include <iostream>
+#    include <string>
+#    include <vector>
+
+#    include "DecoderBase.hpp"
+#    include "Encoder.hpp"
+#    include "helpers.hpp"
+
+struct BenchmarkParams_s {
+    const char* folder_in     = nullptr;   // nullptr: synthetic frames
+    const char* fileName      = "img_";
+    const char* csvPrefix     = "statistics";
+    std::size_t imgIdx_min    = 0;
+    std::size_t imgIdx_max    = 0;
+    std::size_t headerBytes   = 16;
+    std::size_t width         = 2048;
+    std::size_t height        = 1536;
+    std::size_t nrOfFrames    = 1;
+    std::uint8_t bpp          = 8;
+    std::size_t lossyBits     = 0;
+    std::size_t unaryMaxWidth = C_MAX_UNARY_LENGTH;
+    std::size_t iterations    = 10;
+    bool use_gpu              = false;
+    bool balanced             = false;   // blocks of roughly equal compressed size instead of equal rows
+    std::vector<std::size_t> blockCounts{0, 32, 64, 128, 256};
+};
+
+struct BenchmarkFrame_s {
+    std::size_t imgIdx;
+    std::size_t width;
+    std::size_t height;
+    std::vector<std::uint16_t> bayerGB;
+};
+
+/**
+ * Stage samples of one (frame, block count, backend) run, in microseconds.
+*/
+struct BenchmarkSamples_s {
+    std::vector<std::uint64_t> memBitstream;
+    std::vector<std::uint64_t> parsing;
+    std::vector<std::uint64_t> firstColumn;
+    std::vector<std::uint64_t> dpcmToYccc;
+    std::vector<std::uint64_t> ycccToBayer;
+    std::vector<std::uint64_t> memDeviceToHost;
+    std::vector<std::uint64_t> total;
+
+    void push(const StageTimes_s& t)
+    {
+        memBitstream.push_back(t.memBitstream);
+        parsing.push_back(t.parsing);
+        firstColumn.push_back(t.firstColumn);
+        dpcmToYccc.push_back(t.dpcmToYccc);
+        ycccToBayer.push_back(t.ycccToBayer);
+        memDeviceToHost.push_back(t.memDeviceToHost);
+        total.push_back(t.total);
+    }
+};
+
+/**
+ * Nearest rank percentile (0..100) of samples. Sorts samples.
+*/
+static double percentile(std::vector<std::uint64_t>& samples, double pct)
+{
+    if(samples.empty()) {
+        return 0;
+    }
+    std::sort(samples.begin(), samples.end());
+    std::size_t rank = (std::size_t)((pct / 100.0) * (samples.size() - 1) + 0.5);
+    return (double)samples[std::min(rank, samples.size() - 1)];
+}
+
+static std::uint64_t elapsedMicros(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+}
+
+/**
+ * Smooth gradient with noise, so that prediction residuals look like a natural image. Deterministic.
+*/
+static BenchmarkFrame_s generateFrame(std::size_t imgIdx, std::size_t width, std::size_t height, std::uint8_t bpp)
+{
+    BenchmarkFrame_s frame{imgIdx, width, height, std::vector<std::uint16_t>(width * height)};
+    std::uint32_t maxVal = (1u << bpp) - 1;
+    std::uint32_t seed   = 0x12345678u + (std::uint32_t)imgIdx;
+    for(std::size_t row = 0; row < height; row++) {
+        for(std::size_t col = 0; col < width; col++) {
+            seed               = seed * 1664525u + 1013904223u;
+            std::uint32_t base = (std::uint32_t)((row * maxVal) / (2 * height) + (col * maxVal) / (2 * width));
+            std::uint32_t val  = base + ((seed >> 24) & 0x0F) + ((row & 1) ^ (col & 1)) * (maxVal / 16);
+            frame.bayerGB[row * width + col] = (std::uint16_t)std::min(val, maxVal);
+        }
+    }
+    return frame;
+}
+
+static void printHelp()
+{
+    std::cout << "Usage:\n"
+              << "[-i input_location (where bayerCFA_GB folder is), omit for synthetic frames]\n"
+              << "[-f filename (default 'img_')] [-s min_index] [-e max_index] [-b header_bytes, default 16]\n"
+              << "[-x width -y height -n nrOfFrames] (synthetic frames, default 2048 x 1536, 1 frame)\n"
+              << "[-r bpp, default 8] [-l lossy_bits, default 0] [-u unary_max_width]\n"
+              << "[-B list of block counts, default 0,32,64,128,256] [-k iterations, default 10]\n"
+              << "[-E (balance blocks by compressed size, encode time includes both passes)]\n"
+              << "[-g (include OpenCL backends)] [-o csv prefix, default 'statistics']\n"
+              << std::endl;
+}
+
+static BenchmarkParams_s parseArguments(int argc, char* argv[])
+{
+    BenchmarkParams_s params;
+    for(int i = 1; i < argc; i += 2) {
+        const char* flag = argv[i];
+        if(std::strcmp(flag, "-g") == 0) {
+            params.use_gpu = true;
+            i--;
+            continue;
+        }
+        if(std::strcmp(flag, "-E") == 0) {
+            params.balanced = true;
+            i--;
+            continue;
+        }
+        if(std::strcmp(flag, "-h") == 0 || i + 1 >= argc) {
+            printHelp();
+            exit(std::strcmp(flag, "-h") == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+        const char* value = argv[i + 1];
+        if(std::strcmp(flag, "-i") == 0) {
+            params.folder_in = value;
+        } else if(std::strcmp(flag, "-f") == 0) {
+            params.fileName = value;
+        } else if(std::strcmp(flag, "-o") == 0) {
+            params.csvPrefix = value;
+        } else if(std::strcmp(flag, "-s") == 0) {
+            params.imgIdx_min = std::stoi(value);
+        } else if(std::strcmp(flag, "-e") == 0) {
+            params.imgIdx_max = std::stoi(value);
+        } else if(std::strcmp(flag, "-b") == 0) {
+            params.headerBytes = std::stoi(value);
+        } else if(std::strcmp(flag, "-x") == 0) {
+            params.width = std::stoi(value);
+        } else if(std::strcmp(flag, "-y") == 0) {
+            params.height = std::stoi(value);
+        } else if(std::strcmp(flag, "-n") == 0) {
+            params.nrOfFrames = std::stoi(value);
+        } else if(std::strcmp(flag, "-r") == 0) {
+            params.bpp = std::stoi(value);
+        } else if(std::strcmp(flag, "-l") == 0) {
+            params.lossyBits = std::stoi(value);
+        } else if(std::strcmp(flag, "-u") == 0) {
+            params.unaryMaxWidth = std::stoi(value);
+        } else if(std::strcmp(flag, "-k") == 0) {
+            params.iterations = std::max(1, std::stoi(value));
+        } else if(std::strcmp(flag, "-B") == 0) {
+            params.blockCounts.clear();
+            std::string list = value;
+            std::size_t pos  = 0;
+            while(pos <= list.size()) {
+                std::size_t next = list.find(',', pos);
+                if(next == std::string::npos) {
+                    next = list.size();
+                }
+                params.blockCounts.push_back(std::stoi(list.substr(pos, next - pos)));
+                pos = next + 1;
+            }
+        } else {
+            std::cerr << "Invalid flag: " << flag << std::endl;
+            printHelp();
+            exit(EXIT_FAILURE);
+        }
+    }
+    return params;
+}
+
+static std::vector<BenchmarkFrame_s> loadFrames(const BenchmarkParams_s& params)
+{
+    std::vector<BenchmarkFrame_s> frames;
+    if(params.folder_in == nullptr) {
+        for(std::size_t imgIdx = 0; imgIdx < params.nrOfFrames; imgIdx++) {
+            frames.push_back(generateFrame(imgIdx, params.width, params.height, params.bpp));
+        }
+        return frames;
+    }
+    for(std::size_t imgIdx = params.imgIdx_min; imgIdx <= params.imgIdx_max; imgIdx++) {
+        char path[200];
+        sprintf(path, "%s/bayerCFA_GB/%s%02zu.bin", params.folder_in, params.fileName, imgIdx);
+        pImage pImg   = Helpers::read_image(path, params.headerBytes, params.width, params.height);
+        auto dataView = pImg->getDataView();
+        frames.push_back(BenchmarkFrame_s{
+           imgIdx,
+           pImg->getWidth(),
+           pImg->getHeight(),
+           std::vector<std::uint16_t>(dataView.begin(), dataView.end())});
+    }
+    return frames;
+}
+
+/**
+ * Writes one row in the schema of images/wallpapers/statistics_blocks.csv. Values are medians in milliseconds.
+*/
+static void writeCsvRow(std::ofstream& wf, const BenchmarkFrame_s& frame, std::size_t nrOfBlocks, BenchmarkSamples_s& s)
+{
+    char txt[400];
+    sprintf(
+       txt,
+       "%zu,%zu,%zu,%zu,%zu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+       frame.imgIdx,
+       frame.width,
+       frame.height,
+       frame.width * frame.height,
+       nrOfBlocks,
+       percentile(s.memBitstream, 50) / 1000,
+       percentile(s.parsing, 50) / 1000,
+       percentile(s.firstColumn, 50) / 1000,
+       percentile(s.dpcmToYccc, 50) / 1000,
+       percentile(s.ycccToBayer, 50) / 1000,
+       percentile(s.memDeviceToHost, 50) / 1000,
+       percentile(s.total, 50) / 1000);
+    wf << txt;
+}
+
+static void printStage(const char* name, std::vector<std::uint64_t>& samples)
+{
+    if(percentile(samples, 100) == 0) {
+        return;   // stage not measured by this backend
+    }
+    printf(
+       "    %-18s min %9.3f | median %9.3f | p99 %9.3f [ms]\n",
+       name,
+       percentile(samples, 0) / 1000,
+       percentile(samples, 50) / 1000,
+       percentile(samples, 99) / 1000);
+}
+
+static void printSummary(
+   const char* backend,
+   const BenchmarkFrame_s& frame,
+   std::size_t nrOfBlocks,
+   std::size_t rawBytes,
+   BenchmarkSamples_s& s)
+{
+    double median_us = percentile(s.total, 50);
+    printf(
+       "%-16s img %2zu, %zu x %zu, blocks %4zu: %8.1f MB/s\n",
+       backend,
+       frame.imgIdx,
+       frame.width,
+       frame.height,
+       nrOfBlocks,
+       median_us > 0 ? rawBytes / median_us : 0.0);
+    printStage("Mem: Bitstream", s.memBitstream);
+    printStage("Parsing", s.parsing);
+    printStage("First column", s.firstColumn);
+    printStage("DPCM to YCCC", s.dpcmToYccc);
+    printStage("YCCC to Bayer", s.ycccToBayer);
+    printStage("Mem: device to host", s.memDeviceToHost);
+    printStage("Total time", s.total);
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkParams_s params = parseArguments(argc, argv);
+
+#    ifndef TIMING_EN
+    std::cout << "TIMING_EN is not defined, only total time is reported." << std::endl;
+#    endif
+
+    std::vector<BenchmarkFrame_s> frames = loadFrames(params);
+
+    const char* backends[] = {
+       "encode",
+       "actual",
+       "block_sequential",
+       "block_parallel",
+       "pseudo_gpu",
+       "opencl",
+       "planar",
+       "opencl_fused",
+       "opencl_local"};
+    constexpr std::size_t nrOfBackends = sizeof(backends) / sizeof(backends[0]);
+    std::ofstream wf_csv[nrOfBackends];
+    auto csv = [&](std::size_t backend) -> std::ofstream& {
+        if(!wf_csv[backend].is_open()) {
+            char path[200];
+            sprintf(path, "%s_%s.csv", params.csvPrefix, backends[backend]);
+            wf_csv[backend].open(path, std::ios::out);
+            if(!wf_csv[backend]) {
+                char msg[200];
+                sprintf(msg, "Cannot open specified file: %s", path);
+                throw std::runtime_error(msg);
+            }
+            wf_csv[backend] << "Column1,Column2,Column3,Column4,Nr of Blocks,Mem: Bitstream,Parsing,First column,"
+                               "DPCM to YCCC,YCCC to Bayer,Mem: device to host,Total time\n";
+        }
+        return wf_csv[backend];
+    };
+
+    DecoderBase decoderBase;
+    DecodeWorkspace_s workspace;   // shared by backends, so that iterations after warm up do not allocate
+
+    for(const BenchmarkFrame_s& frame : frames) {
+        std::size_t rawBytes = frame.width * frame.height * (params.bpp > 8 ? 2 : 1);
+        std::vector<std::uint8_t> bayer_8bit(params.bpp > 8 ? 0 : frame.width * frame.height);
+        std::vector<std::uint16_t> bayer_16bit(params.bpp > 8 ? frame.width * frame.height : 0);
+
+        for(std::size_t nrOfBlocks : params.blockCounts) {
+            Encoder enc{
+               frame.bayerGB,
+               frame.width,
+               frame.height,
+               32,
+               8,
+               params.lossyBits,
+               params.unaryMaxWidth,
+               params.bpp};
+            std::vector<std::uint8_t> bitstream;
+            std::vector<std::uint32_t> blockSizes;
+            std::vector<std::uint32_t> blockRows;
+
+            // encode, last iteration leaves bitstream for decoders
+            BenchmarkSamples_s samples;
+            for(std::size_t it = 0; it < params.iterations; it++) {
+                auto begin = std::chrono::steady_clock::now();
+                if(nrOfBlocks == 0) {
+                    enc.encodeToBuffer(bitstream);
+                } else {
+                    enc.encodeToBuffer(bitstream, blockSizes, nrOfBlocks, 0, params.balanced);
+                }
+                StageTimes_s times;
+                times.total = elapsedMicros(begin);
+                samples.push(times);
+            }
+            printSummary(backends[0], frame, nrOfBlocks, rawBytes, samples);
+            writeCsvRow(csv(0), frame, nrOfBlocks, samples);
+
+            // decoders get block sizes and rows from the block index of the bitstream, as they do from a file
+            std::size_t payloadOffset = 0;
+            std::uint8_t reserved     = Reader::getOmlsHeader(bitstream.data()) >> 56;
+            STATUS_t indexStatus      = Reader::getBlockIndex(
+               bitstream.data(), bitstream.size(), reserved, blockSizes, blockRows, payloadOffset);
+            if(indexStatus != BASE_SUCCESS) {
+                DecoderBase::handleReturnValue(indexStatus);
+                printf("%u blocks: block index is invalid, decoders skipped.\n", unsigned(nrOfBlocks));
+                continue;
+            }
+            const std::uint8_t* payload = bitstream.data() + payloadOffset;
+            std::size_t payloadSize     = bitstream.size() - payloadOffset;
+
+            // each backend returns status and fills stage times, total is measured here when backend does not
+            auto runDecoder = [&](std::size_t backend, std::function<STATUS_t(StageTimes_s&)> decode) {
+                BenchmarkSamples_s samples;
+                for(std::size_t it = 0; it < params.iterations + 1; it++) {   // first iteration is warm up
+                    StageTimes_s times;
+                    auto begin      = std::chrono::steady_clock::now();
+                    STATUS_t status = decode(times);
+                    if(times.total == 0) {
+                        times.total = elapsedMicros(begin);
+                    }
+                    if(status != BASE_SUCCESS) {
+                        DecoderBase::handleReturnValue(status);
+                        printf("%s: decoding failed, skipped.\n", backends[backend]);
+                        return;
+                    }
+                    if(it != 0) {
+                        samples.push(times);
+                    }
+                }
+                bool same = true;
+                if(params.lossyBits == 0) {
+                    for(std::size_t i = 0; i < frame.bayerGB.size() && same; i++) {
+                        same = frame.bayerGB[i] == (params.bpp > 8 ? bayer_16bit[i] : bayer_8bit[i]);
+                    }
+                }
+                if(!same) {
+                    printf("%s: decoded image differs from original!\n", backends[backend]);
+                }
+                printSummary(backends[backend], frame, nrOfBlocks, rawBytes, samples);
+                writeCsvRow(csv(backend), frame, nrOfBlocks, samples);
+            };
+
+            auto decodeActual = [&](std::size_t nrOfThreads) {
+                return [&, nrOfThreads](StageTimes_s&) -> STATUS_t {
+                    if(nrOfBlocks == 0) {
+                        return params.bpp > 8 ? DecoderBase::decodeBitstreamParallel_actual<std::uint16_t>(
+                                                   frame.width,
+                                                   frame.height,
+                                                   params.lossyBits,
+                                                   params.unaryMaxWidth,
+                                                   params.bpp,
+                                                   payload,
+                                                   payloadSize,
+                                                   bayer_16bit.data(),
+                                                   bayer_16bit.size(),
+                                                   workspace.getRows(1, frame.width / 2))
+                                              : DecoderBase::decodeBitstreamParallel_actual<std::uint8_t>(
+                                                   frame.width,
+                                                   frame.height,
+                                                   params.lossyBits,
+                                                   params.unaryMaxWidth,
+                                                   params.bpp,
+                                                   payload,
+                                                   payloadSize,
+                                                   bayer_8bit.data(),
+                                                   bayer_8bit.size(),
+                                                   workspace.getRows(1, frame.width / 2));
+                    }
+                    return params.bpp > 8 ? DecoderBase::decodeBlocksParallel_actual<std::uint16_t>(
+                                               frame.width,
+                                               frame.height,
+                                               params.lossyBits,
+                                               params.unaryMaxWidth,
+                                               params.bpp,
+                                               payload,
+                                               payloadSize,
+                                               bayer_16bit.data(),
+                                               bayer_16bit.size(),
+                                               blockSizes,
+                                               blockRows,
+                                               nrOfThreads,
+                                               &workspace)
+                                          : DecoderBase::decodeBlocksParallel_actual<std::uint8_t>(
+                                               frame.width,
+                                               frame.height,
+                                               params.lossyBits,
+                                               params.unaryMaxWidth,
+                                               params.bpp,
+                                               payload,
+                                               payloadSize,
+                                               bayer_8bit.data(),
+                                               bayer_8bit.size(),
+                                               blockSizes,
+                                               blockRows,
+                                               nrOfThreads,
+                                               &workspace);
+                };
+            };
+
+            if(nrOfBlocks == 0) {
+                runDecoder(1, decodeActual(1));
+                runDecoder(6, [&](StageTimes_s& times) -> STATUS_t {
+                    STATUS_t status = params.bpp > 8 ? decoderBase.decodeBitstreamParallel_planar<std::uint16_t>(
+                                                          frame.width,
+                                                          frame.height,
+                                                          params.lossyBits,
+                                                          params.unaryMaxWidth,
+                                                          params.bpp,
+                                                          payload,
+                                                          payloadSize,
+                                                          bayer_16bit.data(),
+                                                          bayer_16bit.size(),
+                                                          0,
+                                                          &workspace)
+                                                     : decoderBase.decodeBitstreamParallel_planar<std::uint8_t>(
+                                                          frame.width,
+                                                          frame.height,
+                                                          params.lossyBits,
+                                                          params.unaryMaxWidth,
+                                                          params.bpp,
+                                                          payload,
+                                                          payloadSize,
+                                                          bayer_8bit.data(),
+                                                          bayer_8bit.size(),
+                                                          0,
+                                                          &workspace);
+                    times = decoderBase.m_stageTimes;
+                    return status;
+                });
+                runDecoder(4, [&](StageTimes_s& times) -> STATUS_t {
+                    STATUS_t status = params.bpp > 8 ? decoderBase.decodeBitstreamParallel_pseudo_gpu<std::uint16_t>(
+                                                          frame.width,
+                                                          frame.height,
+                                                          params.lossyBits,
+                                                          params.unaryMaxWidth,
+                                                          params.bpp,
+                                                          payload,
+                                                          payloadSize,
+                                                          bayer_16bit.data(),
+                                                          bayer_16bit.size(),
+                                                          &workspace)
+                                                     : decoderBase.decodeBitstreamParallel_pseudo_gpu<std::uint8_t>(
+                                                          frame.width,
+                                                          frame.height,
+                                                          params.lossyBits,
+                                                          params.unaryMaxWidth,
+                                                          params.bpp,
+                                                          payload,
+                                                          payloadSize,
+                                                          bayer_8bit.data(),
+                                                          bayer_8bit.size(),
+                                                          &workspace);
+                    times = decoderBase.m_stageTimes;
+                    return status;
+                });
+            } else {
+                runDecoder(2, decodeActual(1));
+                runDecoder(3, decodeActual(0));
+            }
+
+#    ifdef INCLUDE_OPENCL
+            if(params.use_gpu) {
+                runDecoder(5, [&](StageTimes_s& times) -> STATUS_t {
+                    STATUS_t status;
+                    if(nrOfBlocks == 0) {
+                        status = params.bpp > 8 ? decoderBase.decodeBitstreamParallel_opencl<std::uint16_t>(
+                                                     frame.width,
+                                                     frame.height,
+                                                     params.lossyBits,
+                                                     params.unaryMaxWidth,
+                                                     params.bpp,
+                                                     payload,
+                                                     payloadSize,
+                                                     bayer_16bit.data(),
+                                                     bayer_16bit.size(),
+                                                     &workspace)
+                                                : decoderBase.decodeBitstreamParallel_opencl<std::uint8_t>(
+                                                     frame.width,
+                                                     frame.height,
+                                                     params.lossyBits,
+                                                     params.unaryMaxWidth,
+                                                     params.bpp,
+                                                     payload,
+                                                     payloadSize,
+                                                     bayer_8bit.data(),
+                                                     bayer_8bit.size(),
+                                                     &workspace);
+                    } else {
+                        status = params.bpp > 8 ? decoderBase.decodeBitstreamParallel_opencl<std::uint16_t>(
+                                                     frame.width,
+                                                     frame.height,
+                                                     params.lossyBits,
+                                                     params.unaryMaxWidth,
+                                                     params.bpp,
+                                                     payload,
+                                                     payloadSize,
+                                                     bayer_16bit.data(),
+                                                     bayer_16bit.size(),
+                                                     blockSizes,
+                                                     blockRows)
+                                                : decoderBase.decodeBitstreamParallel_opencl<std::uint8_t>(
+                                                     frame.width,
+                                                     frame.height,
+                                                     params.lossyBits,
+                                                     params.unaryMaxWidth,
+                                                     params.bpp,
+                                                     payload,
+                                                     payloadSize,
+                                                     bayer_8bit.data(),
+                                                     bayer_8bit.size(),
+                                                     blockSizes,
+                                                     blockRows);
+                    }
+                    times = decoderBase.m_stageTimes;
+                    return status;
+                });
+                // other kernels for decoding in blocks, A/B against the four kernels above
+                auto decodeOpenCL = [&](DecoderBase::blockKernels kernels) {
+                    return [&, kernels](StageTimes_s& times) -> STATUS_t {
+                        STATUS_t status = params.bpp > 8 ? decoderBase.decodeBitstreamParallel_opencl<std::uint16_t>(
+                                                              frame.width,
+                                                              frame.height,
+                                                              params.lossyBits,
+                                                              params.unaryMaxWidth,
+                                                              params.bpp,
+                                                              payload,
+                                                              payloadSize,
+                                                              bayer_16bit.data(),
+                                                              bayer_16bit.size(),
+                                                              blockSizes,
+                                                              blockRows,
+                                                              kernels)
+                                                         : decoderBase.decodeBitstreamParallel_opencl<std::uint8_t>(
+                                                              frame.width,
+                                                              frame.height,
+                                                              params.lossyBits,
+                                                              params.unaryMaxWidth,
+                                                              params.bpp,
+                                                              payload,
+                                                              payloadSize,
+                                                              bayer_8bit.data(),
+                                                              bayer_8bit.size(),
+                                                              blockSizes,
+                                                              blockRows,
+                                                              kernels);
+                        times = decoderBase.m_stageTimes;
+                        return status;
+                    };
+                };
+                if(nrOfBlocks != 0) {
+                    runDecoder(7, decodeOpenCL(DecoderBase::blockKernels::fused));
+                    runDecoder(8, decodeOpenCL(DecoderBase::blockKernels::localParsing));
+                }
+            }
+#    endif
+        }
+    }
+
+    for(auto& wf : wf_csv) {
+        if(wf.is_open()) {
+            wf.close();
+        }
+    }
+    std::cout << "Benchmark finished" << std::endl;
+}
+
+#endif
@@ -12,4 +12,11 @@
 #define C_MAX_UNARY_LENGTH_FULL (2040 + 1) /* Unary length when compressor switches to binary coding of positive value*/
 #define C_MAX_UNARY_LENGTH (8) /* Unary length when compressor switches to binary coding of positive value*/
 
-#define RAW_HEADER_SIZE 16 /* Size of initial raw image size. Timestamp + ROI */
\ No newline at end of file
+#define WRITTER_CHUNK_SIZE (1 << 20) /* Bytes collected by the bit writer before they are written to file */
+
+#define RAW_HEADER_SIZE 16 /* Size of initial raw image size. Timestamp + ROI */
+#define C_HEADER_FLAG_BLOCK_INDEX 0x01 /* Set in reserved byte of compression info when block index follows the header */
+#define C_HEADER_FLAG_CHECKPOINT_INDEX 0x02 /* Same, when checkpoint index of continuous AGOR stream follows */
+#define C_HEADER_FLAG_BLOCK_ROWS 0x04 /* With C_HEADER_FLAG_BLOCK_INDEX, block index also holds first row of each block */
+#define C_HEADER_FLAGS_INDEX \
+    (C_HEADER_FLAG_BLOCK_INDEX | C_HEADER_FLAG_CHECKPOINT_INDEX | C_HEADER_FLAG_BLOCK_ROWS) /* Not in exported header */
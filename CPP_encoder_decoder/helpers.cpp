@@ -1,6 +1,21 @@
 #include "helpers.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#    define WIN32_LEAN_AND_MEAN
+#    define NOMINMAX
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/uio.h>
+#    include <unistd.h>
+#endif
 // #include <stdexcept>
 
 // void Helpers::dumpBayer(const char* outputFile, const pImage img)
@@ -94,18 +109,15 @@ pImage Helpers::read_image(const char* input, std::size_t header_bytes, size_t w
 {
     printf("Reading header...\n");
 
-    FILE* file = fopen(input, "rb");
-    if(file == nullptr) {
+    MappedFile file;
+    if(!file.open(input) || file.size() < header_bytes) {
         std::cerr << "Failed to open the file." << std::endl;
         char msg[200];
         sprintf(msg, "Cannot open specified file: %s", input);
         throw std::runtime_error(msg);
     }
 
-    auto header =
-       new(std::align_val_t(16)) char[header_bytes];   // this will ensure that the header is aligned to 16 bytes
-    size_t bytesRead = fread(header, 1, header_bytes, file);   // this makes a copy
-    (void)bytesRead;
+    const char* header = (const char*)file.data();   // mapping is page aligned, header is read in place
 
     std::uint16_t width;
     std::uint16_t height;
@@ -118,14 +130,14 @@ pImage Helpers::read_image(const char* input, std::size_t header_bytes, size_t w
 
     switch(header_bytes) {
         case 4: {
-            width  = (reinterpret_cast<std::uint16_t*>(header))[0];
-            height = (reinterpret_cast<std::uint16_t*>(header))[1];
+            width  = (reinterpret_cast<const std::uint16_t*>(header))[0];
+            height = (reinterpret_cast<const std::uint16_t*>(header))[1];
             printf("Image read: width = %u, height = %u\n", width, height);
             break;
         }
 
         case 8: {
-            timestamp = (reinterpret_cast<std::uint64_t*>(header))[0];
+            timestamp = (reinterpret_cast<const std::uint64_t*>(header))[0];
             width     = width_a;
             height    = height_a;
             printf(
@@ -140,12 +152,12 @@ pImage Helpers::read_image(const char* input, std::size_t header_bytes, size_t w
         case 16: {
 
             printf("Reading 16 byte header...\n");
-            timestamp          = (reinterpret_cast<std::uint64_t*>(header))[0];
-            uint64_t remainder = (reinterpret_cast<std::uint64_t*>(header))[1];
+            timestamp          = (reinterpret_cast<const std::uint64_t*>(header))[0];
+            uint64_t remainder = (reinterpret_cast<const std::uint64_t*>(header))[1];
 
-            width  = (reinterpret_cast<std::uint16_t*>(header))[sizeof(uint64_t) / sizeof(uint16_t) + 0];
-            height = (reinterpret_cast<std::uint16_t*>(header))[sizeof(uint64_t) / sizeof(uint16_t) + 1];
-            // unary_width = (reinterpret_cast<std::uint16_t*>(header))[sizeof(uint64_t) / sizeof(uint16_t) + 2];
+            width  = (reinterpret_cast<const std::uint16_t*>(header))[sizeof(uint64_t) / sizeof(uint16_t) + 0];
+            height = (reinterpret_cast<const std::uint16_t*>(header))[sizeof(uint64_t) / sizeof(uint16_t) + 1];
+            // unary_width = (reinterpret_cast<const std::uint16_t*>(header))[sizeof(uint64_t) / sizeof(uint16_t) + 2];
             unary_width = header[sizeof(uint64_t) / sizeof(uint8_t) + 2 * sizeof(uint16_t) / sizeof(uint8_t) + 0];
             bpp         = header[sizeof(uint64_t) / sizeof(uint8_t) + 2 * sizeof(uint16_t) / sizeof(uint8_t) + 1];
             lossy_bits  = header[sizeof(uint64_t) / sizeof(uint8_t) + 2 * sizeof(uint16_t) / sizeof(uint8_t) + 2];
@@ -168,15 +180,15 @@ pImage Helpers::read_image(const char* input, std::size_t header_bytes, size_t w
 
         case 24: {
             // clang-format off
-            timestamp   = (reinterpret_cast<std::uint64_t*>(header))[0];
-            roi         = (reinterpret_cast<std::uint64_t*>(header))[1];
-            width       = (reinterpret_cast<std::uint16_t*>(header))[2*sizeof(uint64_t)/sizeof(uint16_t) + 0];
-            height      = (reinterpret_cast<std::uint16_t*>(header))[2*sizeof(uint64_t)/sizeof(uint16_t) + 1];
+            timestamp   = (reinterpret_cast<const std::uint64_t*>(header))[0];
+            roi         = (reinterpret_cast<const std::uint64_t*>(header))[1];
+            width       = (reinterpret_cast<const std::uint16_t*>(header))[2*sizeof(uint64_t)/sizeof(uint16_t) + 0];
+            height      = (reinterpret_cast<const std::uint16_t*>(header))[2*sizeof(uint64_t)/sizeof(uint16_t) + 1];
             unary_width = header[2*sizeof(uint64_t)/sizeof(uint8_t) + 2 * sizeof(uint16_t)/sizeof(uint8_t) + 0];
             bpp         = header[2*sizeof(uint64_t)/sizeof(uint8_t) + 2 * sizeof(uint16_t)/sizeof(uint8_t) + 1];
             lossy_bits  = header[2*sizeof(uint64_t)/sizeof(uint8_t) + 2 * sizeof(uint16_t)/sizeof(uint8_t) + 2];
             reserved    = header[2*sizeof(uint64_t)/sizeof(uint8_t) + 2 * sizeof(uint16_t)/sizeof(uint8_t) + 3];
-            // lossy_bits  = saturate_cast<std::uint8_t>(reinterpret_cast<std::uint16_t*>(header))[4 + 3];
+            // lossy_bits  = saturate_cast<std::uint8_t>(reinterpret_cast<const std::uint16_t*>(header))[4 + 3];
             // clang-format on
             printf(
                "Image read: timestamp = %llu, ROI = %llX, width = %u, height = %u, unary_width = %u, bpp = %u, "
@@ -200,36 +212,24 @@ pImage Helpers::read_image(const char* input, std::size_t header_bytes, size_t w
             (void)reserved;
     }
 
-    // Seek to the end of the file to get its size
-    fpos_t position;
-    fgetpos(file, &position);
-    fseek(file, 0, SEEK_END);
-    long sourceSize = ftell(file);
-    fsetpos(file, &position);
-
-    std::vector<std::uint16_t> inputBytes(width * height);
     std::uint64_t expectedDataSize = width * height;
     if(bpp != 8) {
         expectedDataSize = expectedDataSize * 2;   // two bytes per pixel
     }
 
-    bytesRead = fread(inputBytes.data(), 1, (sourceSize - header_bytes), file);
+    if(file.size() - header_bytes != expectedDataSize) {
+        throw std::runtime_error("Not all bytes read!");
+    }
 
+    // Pixels are converted straight from the mapping
+    const std::uint8_t* pixels = file.data() + header_bytes;
+    std::vector<std::uint16_t> inputBytes(width * height);
     if(bpp == 8) {
-        std::vector<std::uint8_t> inputBytes_8(width * height);
-        for(std::size_t i = 0; i < inputBytes.size()/2; i++) { // inputBytes is only half filled
-            inputBytes_8[2*i] = (std::uint8_t)(inputBytes[i] & 0xFF);
-            inputBytes_8[2*i+1] = (std::uint8_t)(inputBytes[i] >> 8);
+        for(std::size_t i = 0; i < inputBytes.size(); i++) {
+            inputBytes[i] = (std::uint16_t)pixels[i];
         }
-        for(std::size_t i = 0; i < inputBytes_8.size(); i++) {
-            inputBytes[i] = (std::uint16_t)inputBytes_8[i];
-        }
-    }
-
-    fclose(file);
-
-    if(bytesRead != expectedDataSize) {
-        throw std::runtime_error("Not all bytes read!");
+    } else {
+        memcpy(inputBytes.data(), pixels, expectedDataSize);
     }
 
     // Create unique pointer to Image object while moving ownership of inputBytes vector to Image object
@@ -434,4 +434,68 @@ void Helpers::dumpToFile(const char* fileName, const uQuadChannelCS* quadCh, std
     wf.write((char*)quadCh->getChannelDataConst(uQ::Co), 2 * quadCh->getChannelSizeConst(uQ::Co));
 
     wf.close();
-};
\ No newline at end of file
+};
+
+/**
+ * Creates (or truncates) file fileName and writes all parts to it in order, with a single gather write where the
+ * platform supports it. Returns false on failure.
+*/
+bool Helpers::writeFileGather(const char* fileName, std::span<const std::span<std::uint8_t const>> parts)
+{
+#ifdef _WIN32
+    HANDLE hFile = CreateFileA(fileName, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    // WriteFileGather needs unbuffered, page aligned I/O, so parts are written one by one without stdio buffering.
+    for(auto part : parts) {
+        std::size_t written = 0;
+        while(written < part.size()) {
+            DWORD chunk = (DWORD)std::min<std::size_t>(part.size() - written, 1 << 30);
+            DWORD done  = 0;
+            if(!WriteFile(hFile, part.data() + written, chunk, &done, NULL)) {
+                CloseHandle(hFile);
+                return false;
+            }
+            written += done;
+        }
+    }
+    CloseHandle(hFile);
+    return true;
+#else
+    int fd = ::open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) {
+        return false;
+    }
+
+    std::vector<struct iovec> iov;
+    iov.reserve(parts.size());
+    for(auto part : parts) {
+        if(!part.empty()) {
+            iov.push_back({(void*)part.data(), part.size()});
+        }
+    }
+
+    // writev may write less than requested, continue from where it stopped
+    std::size_t idx = 0;
+    while(idx < iov.size()) {
+        ssize_t done = writev(fd, iov.data() + idx, (int)(iov.size() - idx));
+        if(done < 0) {
+            if(errno == EINTR) {
+                continue;   // interrupted before anything was written
+            }
+            ::close(fd);
+            return false;
+        }
+        while(idx < iov.size() && (std::size_t)done >= iov[idx].iov_len) {
+            done -= iov[idx].iov_len;
+            idx++;
+        }
+        if(idx < iov.size()) {
+            iov[idx].iov_base = (std::uint8_t*)iov[idx].iov_base + done;
+            iov[idx].iov_len -= done;
+        }
+    }
+    return ::close(fd) == 0;
+#endif
+}
@@ -5,6 +5,7 @@
 #include "ImageYCCC.hpp"
 #include "globalDefines.hpp"
 #include <cstdint>
+#include <span>
 
 class Helpers
 {
@@ -26,6 +27,8 @@ class Helpers
 
     static bool isLittleEndian();
 
+    static bool writeFileGather(const char* fileName, std::span<const std::span<std::uint8_t const>> parts);
+
     static void dump16pp(const char* outputFile, const Image* pImg);
     static void dump8pp(const char* outputFile, const Image* pImg);
     static void dumpBayer(const char* outputFile, const Image* pImg);
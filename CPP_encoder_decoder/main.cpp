@@ -1,15 +1,18 @@
 #ifndef MAIN_MINIMAL
-#    ifndef MAIN_DEMO
+#    if !defined(MAIN_DEMO) && !defined(BENCHMARK)
 
+#        include <algorithm>
 #        include <bitset>
 #        include <chrono>
 #        include <cstdio>
 #        include <cstring>
 #        include <ctime>
+#        include <deque>
 #        include <filesystem>
 #        include <iostream>
 #        include <iterator>   // for std::next
 #        include <memory>
+#        include <mutex>
 #        include <string>
 #        include <vector>
 
@@ -17,6 +20,9 @@
 #        include "Encoder.hpp"
 #        include "Image.hpp"
 #        include "ImageYCCC.hpp"
+#        include "MappedFile.hpp"
+#        include "Pipeline.hpp"
+#        include "Transcoder.hpp"
 #        include "helpers.hpp"
 #        include "main.hpp"
 
@@ -52,20 +58,34 @@ int main(int argc, char* argv[])
         }
     }
 
-    if(params.ideal_compress) {
-        compressImageRangeIdeal(
+    if(params.transcode) {
+        transcodeImageRange(
            params.fileName,
            params.folder_in,
            params.folder_out,
            params.imgIdx_min,
            params.imgIdx_max,
-           params.unaryMaxWidth,
-           params.bpp,
-           params.lossyBits,
-           &widthHeight,
-           16);
-    } else if(params.compress) {
-        compressImageRangeAGOR(
+           params.nrOfBlocks,
+           params.targetBlocks,
+           params.checkpoints,
+           params.balanced,
+           params.nrOfWorkers,
+           params.queueDepth);
+    }
+
+    if(params.indexRows != 0 && !params.compress) {
+        buildCheckpointIndexRange(
+           params.fileName,
+           params.folder_in,
+           params.imgIdx_min,
+           params.imgIdx_max,
+           &N,
+           &A_init,
+           params.indexRows);
+    }
+
+    if(params.ideal_compress) {
+        compressImageRangeIdeal(
            params.fileName,
            params.folder_in,
            params.folder_out,
@@ -73,13 +93,84 @@ int main(int argc, char* argv[])
            params.imgIdx_max,
            params.unaryMaxWidth,
            params.bpp,
-           &N,
-           &A_init,
            params.lossyBits,
            &widthHeight,
-           16,
-           params.nrOfBlocks);
-        if(params.decompress) {
+           16);
+    } else if(params.compress) {
+        if(params.nrOfWorkers != 0) {
+            compressImageRangePipelined(
+               params.fileName,
+               params.folder_in,
+               params.folder_out,
+               params.imgIdx_min,
+               params.imgIdx_max,
+               params.unaryMaxWidth,
+               params.bpp,
+               &N,
+               &A_init,
+               params.lossyBits,
+               &widthHeight,
+               16,
+               params.nrOfBlocks,
+               params.nrOfWorkers,
+               params.queueDepth,
+               params.checkpoints,
+               params.balanced);
+        } else {
+            compressImageRangeAGOR(
+               params.fileName,
+               params.folder_in,
+               params.folder_out,
+               params.imgIdx_min,
+               params.imgIdx_max,
+               params.unaryMaxWidth,
+               params.bpp,
+               &N,
+               &A_init,
+               params.lossyBits,
+               &widthHeight,
+               16,
+               params.nrOfBlocks,
+               params.checkpoints,
+               params.balanced);
+        }
+        if(params.indexRows != 0) {
+            buildCheckpointIndexRange(
+               params.fileName,
+               params.folder_out,
+               params.imgIdx_min,
+               params.imgIdx_max,
+               &N,
+               &A_init,
+               params.indexRows);
+        }
+        if(params.decompress && params.nrOfWorkers != 0 && params.use_gpu && params.nrOfBlocks != 0) {
+            decompressImageRangeStreamingGPU(
+               params.fileName,
+               params.folder_out,
+               params.folder_out,
+               params.imgIdx_min,
+               params.imgIdx_max,
+               &N,
+               &A_init,
+               16,
+               params.nrOfBlocks,
+               params.nrOfWorkers,
+               params.gpu_kernels);
+        } else if(params.decompress && params.nrOfWorkers != 0 && !params.use_gpu) {
+            decompressImageRangePipelined(
+               params.fileName,
+               params.folder_out,
+               params.folder_out,
+               params.imgIdx_min,
+               params.imgIdx_max,
+               &N,
+               &A_init,
+               16,
+               params.nrOfBlocks,
+               params.nrOfWorkers,
+               params.queueDepth);
+        } else if(params.decompress) {
             decompressImageRangeAGOR(
                params.fileName,
                params.folder_out,
@@ -95,28 +186,58 @@ int main(int argc, char* argv[])
                //    24, // 24 if you want to include header (width[15:0], height[15:0], unary_width[7:0], bpp[7:0], lossy_bits[7:0], reserved). If you want to verify decompressed with original using Winmerge, set this to 16 (exclude header)
                16,
                params.use_gpu,
-               params.nrOfBlocks);
+               params.nrOfBlocks,
+               params.gpu_kernels);
         }
     } else if(params.decompress) {
         for(std::size_t imgIdx = params.imgIdx_min; imgIdx <= params.imgIdx_max; imgIdx++) {
             widthHeight.push_back(params.width);
             widthHeight.push_back(params.height);
         }   // end for
-        decompressImageRangeAGOR(
-           params.fileName,
-           params.folder_in,
-           params.folder_out,
-           params.imgIdx_min,
-           params.imgIdx_max,
-           params.unaryMaxWidth,
-           params.bpp,
-           &N,
-           &A_init,
-           params.lossyBits,
-           &widthHeight,
-           params.header_bytes,
-           params.use_gpu,
-           params.nrOfBlocks);
+        if(params.nrOfWorkers != 0 && params.use_gpu && params.nrOfBlocks != 0) {
+            decompressImageRangeStreamingGPU(
+               params.fileName,
+               params.folder_in,
+               params.folder_out,
+               params.imgIdx_min,
+               params.imgIdx_max,
+               &N,
+               &A_init,
+               params.header_bytes,
+               params.nrOfBlocks,
+               params.nrOfWorkers,
+               params.gpu_kernels);
+        } else if(params.nrOfWorkers != 0 && !params.use_gpu) {
+            decompressImageRangePipelined(
+               params.fileName,
+               params.folder_in,
+               params.folder_out,
+               params.imgIdx_min,
+               params.imgIdx_max,
+               &N,
+               &A_init,
+               params.header_bytes,
+               params.nrOfBlocks,
+               params.nrOfWorkers,
+               params.queueDepth);
+        } else {
+            decompressImageRangeAGOR(
+               params.fileName,
+               params.folder_in,
+               params.folder_out,
+               params.imgIdx_min,
+               params.imgIdx_max,
+               params.unaryMaxWidth,
+               params.bpp,
+               &N,
+               &A_init,
+               params.lossyBits,
+               &widthHeight,
+               params.header_bytes,
+               params.use_gpu,
+               params.nrOfBlocks,
+               params.gpu_kernels);
+        }
     }
 
     // if((params.p_ideal_compress == 'n') & (params.p_compress == 'n') & (params.p_decompress == 'n')) {
@@ -145,7 +266,9 @@ void compressImageRangeAGOR(
    std::size_t lossyBits,
    std::vector<std::size_t>* imageSizes,
    std::size_t headerBytes,
-   std::uint16_t nrOfBlocks)
+   std::uint16_t nrOfBlocks,
+   bool checkpoints,
+   bool balanced)
 {
     std::cout << "\nAGOR compression with Q max width: " << unsigned(unaryMaxWidth) << std::endl;
     char path[200];
@@ -234,6 +357,12 @@ void compressImageRangeAGOR(
         std::unique_ptr<std::vector<std::size_t>> fileSize;
         if(unaryMaxWidth == (2040 + 1)) {
             fileSize = enc.encodeUsingMethod(Encoder::method::parallel_standard);
+        } else if(nrOfBlocks != 0 && checkpoints) {
+            fileSize = enc.encodeUsingMethod(Encoder::method::parallel_limited_checkpoints);
+        } else if(nrOfBlocks != 0 && balanced) {
+            fileSize = enc.encodeUsingMethod(Encoder::method::parallel_limited_blocks_balanced);
+        } else if(nrOfBlocks != 0) {
+            fileSize = enc.encodeUsingMethod(Encoder::method::parallel_limited_blocks);
         } else {
             fileSize = enc.encodeUsingMethod(Encoder::method::parallel_limited);
         }
@@ -349,32 +478,6 @@ void compressImageRangeIdeal(
     wf_report.close();
 }
 
-void readBlockSizes(const char* fileName, std::vector<std::uint32_t>* blockSizes)
-{
-    std::ifstream rf(fileName, std::ios::in | std::ios::binary);
-    if(!rf) {
-        char msg[200];
-        std::sprintf(msg, "Cannot open specified file: %s", fileName);
-        throw std::runtime_error(msg);
-    }
-
-    // find length of file
-    rf.seekg(0, std::ios::end);
-    std::size_t length = rf.tellg();
-    rf.seekg(0, std::ios::beg);
-
-    std::size_t nrOfBlocks = length / sizeof(std::uint32_t);
-
-    if(nrOfBlocks != blockSizes->size()) {
-        rf.close();
-        std::cerr << "Number of blocks in file does not match the number of blocks in the vector." << std::endl;
-    }
-
-    rf.read(reinterpret_cast<char*>(blockSizes->data()), length);
-
-    rf.close();
-}
-
 void decompressImageRangeAGOR(
    const char* fileName,
    const char* folder_in,
@@ -389,7 +492,8 @@ void decompressImageRangeAGOR(
    std::vector<std::size_t>* imageSizes,
    std::size_t headerBytes,
    bool use_gpu,
-   std::uint16_t nrOfBlocks)
+   std::uint16_t nrOfBlocks,
+   DecoderBase::blockKernels gpu_kernels)
 {
 
     std::cout << "\nAGOR decompression" << std::endl;
@@ -402,6 +506,9 @@ void decompressImageRangeAGOR(
     }
     std::cout << std::endl;
 
+    // decoded images and scratch buffers, reused for all frames
+    DecodeWorkspace_s workspace;
+
     for(std::size_t imgIdx = imgIdx_min; imgIdx <= imgIdx_max; imgIdx++) {
 
         // PARELLEL IMPLEMENTATION
@@ -418,33 +525,23 @@ void decompressImageRangeAGOR(
             // Decoder
             //    dec{path, imageSizes->data()[2 * it], imageSizes->data()[2 * it + 1], A_init->data()[0], N->data()[0]};
             Decoder dec{path, A_init->data()[0], N->data()[0]};
+            dec.setWorkspace(&workspace);
             std::cout << "\nLoaded image at " << path << std::endl;
+            if(nrOfBlocks == 0 && !use_gpu) {
+                // sidecar checkpoint index of buildCheckpointIndexRange, if any, enables parallel decoding
+                sprintf(path, "%s/compressed/%s%02zu_checkpoints.bin", folder_in, fileName, imgIdx);
+                if(std::filesystem::exists(path)) {
+                    dec.importCheckpointIndex(path);
+                    std::cout << "Loaded checkpoint index at " << path << std::endl;
+                }
+            }
 #        ifdef TIMING_EN
             std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 #        endif
+            // blocks, if any, are taken from the block index of the file
             headerData_t headerData;
             if(use_gpu) {
-                if(nrOfBlocks != 0) {
-                    std::vector<std::uint32_t> blockSizes(nrOfBlocks);
-                    char path_blockSizes[200];
-                    sprintf(
-                       path_blockSizes,
-                       "%s/compressed/%s%02zu_%04u_blockSizes.bin",
-                       folder_in,
-                       fileName,
-                       imgIdx,
-                       nrOfBlocks);
-
-                    std::cout << std::endl;
-                    readBlockSizes(path_blockSizes, &blockSizes);
-
-                    headerData = dec.decodeParallelGPU(blockSizes);
-
-                } else {
-                    // std::cerr << "Cannot use GPU without specifying number of blocks." << std::endl;
-                    std::vector<std::uint32_t> blockSizes_dummy;
-                    headerData = dec.decodeParallelGPU(blockSizes_dummy);
-                }
+                headerData = dec.decodeParallelGPU(gpu_kernels);
             } else {
                 headerData = dec.decodeParallel();
             }
@@ -452,17 +549,8 @@ void decompressImageRangeAGOR(
             std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
 #        endif
 
+            // existing file is overwritten by exportBayerImage
             sprintf(path, "%s/decompressed/%s%02zu.bin", folder_out, fileName, imgIdx);
-            if(std::filesystem::exists(path)) {
-                // Delete the file
-                std::cout << "Deleting existing file: " << path << " \n";
-                try {
-                    std::filesystem::remove(path);
-                    std::cout << "File deleted successfully.\n";
-                } catch(const std::exception& e) {
-                    std::cerr << "Error deleting file: " << e.what() << "\n";
-                }
-            }
             // if headerBytes == 4, then it is old binary with no header
             // ( well actually 4 bytes header with width and height) --- well this appends 8 bytes to the file so it will be wrong anyways
             // std::uint64_t header = (headerBytes == 4) ? 1 : 0;
@@ -474,7 +562,7 @@ void decompressImageRangeAGOR(
 
             std::uint64_t header = 0;
             if(headerBytes == 24) {
-                header |= (std::uint64_t)headerData.reserved << 56;
+                header |= (std::uint64_t)(headerData.reserved & ~C_HEADER_FLAGS_INDEX) << 56;
                 header |= (std::uint64_t)headerData.lossyBits << 48;
                 header |= (std::uint64_t)headerData.bpp << 40;
                 header |= (std::uint64_t)headerData.unaryMaxWidth << 32;
@@ -504,6 +592,476 @@ void decompressImageRangeAGOR(
     }
 }
 
+/**
+ * Builds sidecar checkpoint index <fileName>xx_checkpoints.bin for each compressed file <fileName>xx.bin (without
+ * blocks) in <folder>/compressed: the file is parsed once and AGOR state is recorded every <rowsPerCheckpoint> rows.
+ * Compressed files are not modified.
+*/
+void buildCheckpointIndexRange(
+   const char* fileName,
+   const char* folder,
+   std::size_t imgIdx_min,
+   std::size_t imgIdx_max,
+   std::vector<std::uint32_t>* N,
+   std::vector<std::uint32_t>* A_init,
+   std::size_t rowsPerCheckpoint)
+{
+    std::cout << "\nBuilding checkpoint index every " << rowsPerCheckpoint << " rows" << std::endl;
+    char path[200];
+
+    for(std::size_t imgIdx = imgIdx_min; imgIdx <= imgIdx_max; imgIdx++) {
+        try {
+            sprintf(path, "%s/compressed/%s%02zu.bin", folder, fileName, imgIdx);
+            Decoder dec{path, A_init->data()[0], N->data()[0]};
+#        ifdef TIMING_EN
+            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+#        endif
+            std::size_t nrOfCheckpoints = dec.buildCheckpointIndex(rowsPerCheckpoint);
+#        ifdef TIMING_EN
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            std::cout << "Checkpoint index building time = "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]"
+                      << std::endl;
+#        endif
+
+            sprintf(path, "%s/compressed/%s%02zu_checkpoints.bin", folder, fileName, imgIdx);
+            dec.exportCheckpointIndex(path);
+            std::cout << "Saved " << nrOfCheckpoints << " checkpoints to " << path << std::endl;
+        } catch(std::runtime_error& e) {
+            std::cout << "RUNTIME ERROR: \n";
+            std::cout << e.what() << "\n";
+        }
+    }
+}
+
+struct CompressFrame_s : PipelineFrame_s {
+    pImage pImg;
+    std::unique_ptr<Encoder> pEnc;
+    std::vector<std::uint8_t> bitstream;
+    std::vector<std::uint32_t> blockSizes;
+};
+
+/**
+ * Same output as compressImageRangeAGOR, but frames are read, encoded and written in a pipeline:
+ * reader prefetches up to <queueDepth> frames, <nrOfWorkers> encoders run concurrently and
+ * files and report lines are written in frame order. Dumps for verification are not written.
+*/
+void compressImageRangePipelined(
+   const char* fileName,
+   const char* folder_in,
+   const char* folder_out,
+   std::size_t imgIdx_min,
+   std::size_t imgIdx_max,
+   std::size_t unaryMaxWidth,
+   std::uint8_t bpp,
+   std::vector<std::uint32_t>* N,
+   std::vector<std::uint32_t>* A_init,
+   std::size_t lossyBits,
+   std::vector<std::size_t>* imageSizes,
+   std::size_t headerBytes,
+   std::uint16_t nrOfBlocks,
+   std::size_t nrOfWorkers,
+   std::size_t queueDepth,
+   bool checkpoints,
+   bool balanced)
+{
+    std::cout << "\nAGOR pipelined compression with Q max width: " << unsigned(unaryMaxWidth) << ", "
+              << nrOfWorkers << " workers, queue depth " << queueDepth << std::endl;
+    char path[200];
+
+    std::ofstream wf_report;
+    sprintf(path, "%s/compressed/report.csv", folder_out);
+    wf_report.open(path, std::ios::app);
+    if(!wf_report) {
+        char msg[200];
+        std::sprintf(msg, "Cannot open specified file: %s", path);
+        throw std::runtime_error(msg);
+    }
+
+    // image sizes from the user, header sizes are appended in frame order by the store stage
+    bool sizeFromHeader                = headerBytes == 4 || headerBytes == 16 || headerBytes == 24;
+    std::vector<std::size_t> userSizes = *imageSizes;
+    bool useBlocks                     = nrOfBlocks != 0 && unaryMaxWidth != (2040 + 1);
+
+    auto load = [&](CompressFrame_s& frame) {
+        char path[200];
+        sprintf(path, "%s/%s%02zu.bin", folder_in, fileName, frame.imgIdx);
+        if(!std::filesystem::exists(path)) {
+            sprintf(path, "%s/bayerCFA_GB/%s%02zu.bin", folder_in, fileName, frame.imgIdx);
+        }
+        if(sizeFromHeader) {
+            frame.pImg = Helpers::read_image(path, headerBytes, 0, 0);
+        } else {
+            std::size_t it = frame.imgIdx - imgIdx_min;
+            frame.pImg     = Helpers::read_image(path, headerBytes, userSizes.at(2 * it), userSizes.at(2 * it + 1));
+        }
+    };
+
+    auto process = [&](CompressFrame_s& frame) {
+        frame.pEnc = std::make_unique<Encoder>(
+           frame.pImg->getDataView(),
+           frame.pImg->getWidth(),
+           frame.pImg->getHeight(),
+           A_init->data()[0],
+           N->data()[0],
+           lossyBits,
+           unaryMaxWidth,
+           bpp);
+        if(useBlocks && checkpoints) {
+            frame.pEnc->encodeToBufferWithCheckpoints(frame.bitstream, nrOfBlocks);
+        } else if(useBlocks) {
+            // frames already run concurrently, so each frame is encoded on a single thread
+            frame.pEnc->encodeToBuffer(frame.bitstream, frame.blockSizes, nrOfBlocks, 1, balanced);
+        } else {
+            frame.pEnc->encodeToBuffer(frame.bitstream);
+        }
+    };
+
+    auto store = [&](CompressFrame_s& frame) {
+        if(!frame.error.empty()) {
+            std::cout << "RUNTIME ERROR: \n";
+            std::cout << "Frame " << frame.imgIdx << ": " << frame.error << "\n";
+            return;
+        }
+        if(sizeFromHeader) {
+            imageSizes->push_back(frame.pImg->getWidth());
+            imageSizes->push_back(frame.pImg->getHeight());
+        }
+
+        char path[200];
+        if(useBlocks) {
+            sprintf(path, "%s/compressed/%s%02zu_%04u_blocks.bin", folder_out, fileName, frame.imgIdx, nrOfBlocks);
+        } else {
+            sprintf(path, "%s/compressed/%s%02zu.bin", folder_out, fileName, frame.imgIdx);
+        }
+        std::span<std::uint8_t const> parts[] = {frame.bitstream};
+        if(!Helpers::writeFileGather(path, parts)) {
+            char msg[200];
+            std::sprintf(msg, "Cannot write specified file: %s", path);
+            throw std::runtime_error(msg);
+        }
+
+        std::cout << "Frame " << frame.imgIdx << ": " << frame.pImg->getWidth() << " x " << frame.pImg->getHeight()
+                  << ", file size: " << unsigned(frame.bitstream.size()) << " bytes" << std::endl;
+
+        std::time_t current_time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        char msg[200];
+        struct tm* p = localtime(&current_time);
+        strftime(msg, sizeof(msg), "%a %b %m %Y %H:%M:%S", p);
+
+        wf_report << msg << " , " << fileName << unsigned(frame.imgIdx) << ".png , " << unsigned(lossyBits)
+                  << " lossy bits, AGOR , " << unsigned(frame.bitstream.size()) << " ,bytes"
+                  << ",max unary length," << unsigned(unaryMaxWidth) << std::endl;
+    };
+
+#        ifdef TIMING_EN
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+#        endif
+    runFramePipeline<CompressFrame_s>(imgIdx_min, imgIdx_max, nrOfWorkers, queueDepth, load, process, store);
+#        ifdef TIMING_EN
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cout << "Pipelined compression time = "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]" << std::endl;
+#        endif
+    wf_report.close();
+}
+
+struct DecompressFrame_s : PipelineFrame_s {
+    std::unique_ptr<Decoder> pDec;
+    std::unique_ptr<DecodeWorkspace_s> pWorkspace;
+    headerData_t headerData;
+};
+
+/**
+ * Same output as decompressImageRangeAGOR on CPU, but frames are mapped, decoded and exported in a pipeline:
+ * reader maps up to <queueDepth> compressed files ahead, <nrOfWorkers> decoders run concurrently and
+ * images are exported in frame order.
+*/
+void decompressImageRangePipelined(
+   const char* fileName,
+   const char* folder_in,
+   const char* folder_out,
+   std::size_t imgIdx_min,
+   std::size_t imgIdx_max,
+   std::vector<std::uint32_t>* N,
+   std::vector<std::uint32_t>* A_init,
+   std::size_t headerBytes,
+   std::uint16_t nrOfBlocks,
+   std::size_t nrOfWorkers,
+   std::size_t queueDepth)
+{
+    std::cout << "\nAGOR pipelined decompression, " << nrOfWorkers << " workers, queue depth " << queueDepth
+              << std::endl;
+
+    // at most <queueDepth> frames are in flight, each holds one workspace from load until store
+    std::mutex workspaceMtx;
+    std::vector<std::unique_ptr<DecodeWorkspace_s>> freeWorkspaces;
+
+    auto load = [&](DecompressFrame_s& frame) {
+        {
+            std::lock_guard<std::mutex> lock(workspaceMtx);
+            if(freeWorkspaces.empty()) {
+                frame.pWorkspace = std::make_unique<DecodeWorkspace_s>();
+            } else {
+                frame.pWorkspace = std::move(freeWorkspaces.back());
+                freeWorkspaces.pop_back();
+            }
+        }
+        char path[200];
+        if(nrOfBlocks == 0) {
+            sprintf(path, "%s/compressed/%s%02zu.bin", folder_in, fileName, frame.imgIdx);
+        } else {
+            sprintf(path, "%s/compressed/%s%02zu_%04u_blocks.bin", folder_in, fileName, frame.imgIdx, nrOfBlocks);
+        }
+        frame.pDec = std::make_unique<Decoder>(path, A_init->data()[0], N->data()[0]);
+        frame.pDec->setWorkspace(frame.pWorkspace.get());
+    };
+
+    auto process = [&](DecompressFrame_s& frame) {
+        // frames already run concurrently, so blocks of each frame are decoded on a single thread
+        frame.headerData = frame.pDec->decodeParallel(1);
+    };
+
+    auto releaseWorkspace = [&](DecompressFrame_s& frame) {
+        if(frame.pWorkspace != nullptr) {
+            std::lock_guard<std::mutex> lock(workspaceMtx);
+            freeWorkspaces.push_back(std::move(frame.pWorkspace));
+        }
+    };
+
+    auto store = [&](DecompressFrame_s& frame) {
+        if(!frame.error.empty()) {
+            std::cout << "RUNTIME ERROR: \n";
+            std::cout << "Frame " << frame.imgIdx << ": " << frame.error << "\n";
+            releaseWorkspace(frame);
+            return;
+        }
+        const headerData_t& headerData = frame.headerData;
+
+        std::uint64_t header = 0;
+        if(headerBytes == 24) {
+            header |= (std::uint64_t)(headerData.reserved & ~C_HEADER_FLAGS_INDEX) << 56;
+            header |= (std::uint64_t)headerData.lossyBits << 48;
+            header |= (std::uint64_t)headerData.bpp << 40;
+            header |= (std::uint64_t)headerData.unaryMaxWidth << 32;
+            header |= (std::uint64_t)headerData.height << 16;
+            header |= (std::uint64_t)headerData.width << 0;
+        }
+
+        char path[200];
+        sprintf(path, "%s/decompressed/%s%02zu.bin", folder_out, fileName, frame.imgIdx);
+        frame.pDec->exportBayerImage(path, header, headerData.roi, headerData.timestamp);
+        releaseWorkspace(frame);
+        std::cout << "Saved an image: " << path << std::endl;
+    };
+
+#        ifdef TIMING_EN
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+#        endif
+    runFramePipeline<DecompressFrame_s>(imgIdx_min, imgIdx_max, nrOfWorkers, queueDepth, load, process, store);
+#        ifdef TIMING_EN
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cout << "Pipelined decompression time = "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]" << std::endl;
+#        endif
+}
+
+struct TranscodeFrame_s : PipelineFrame_s {
+    pMappedFile pSource;
+    std::vector<std::uint8_t> bitstream;
+};
+
+/**
+ * Changes layout of compressed files in <folder_in>/compressed from <nrOfBlocks> blocks (0: none) to <targetBlocks>
+ * blocks (of roughly equal compressed size with <balanced>), or to <targetBlocks> checkpoints with <checkpoints>,
+ * and writes them to <folder_out>/compressed.
+ * Frames are decoded only to YCCC and encoded again (see Transcoder), <nrOfWorkers> frames at once
+ * (0: one per core), files are read and written in a pipeline as in compressImageRangePipelined.
+*/
+void transcodeImageRange(
+   const char* fileName,
+   const char* folder_in,
+   const char* folder_out,
+   std::size_t imgIdx_min,
+   std::size_t imgIdx_max,
+   std::uint16_t nrOfBlocks,
+   std::uint16_t targetBlocks,
+   bool checkpoints,
+   bool balanced,
+   std::size_t nrOfWorkers,
+   std::size_t queueDepth)
+{
+    if(nrOfWorkers == 0) {
+        nrOfWorkers = std::max(1u, std::thread::hardware_concurrency());
+        queueDepth  = 2 * nrOfWorkers;
+    }
+    std::cout << "\nAGOR transcoding to " << targetBlocks << (checkpoints ? " checkpoints, " : " blocks, ")
+              << nrOfWorkers << " workers, queue depth " << queueDepth << std::endl;
+
+    auto load = [&](TranscodeFrame_s& frame) {
+        char path[200];
+        if(nrOfBlocks == 0) {
+            sprintf(path, "%s/compressed/%s%02zu.bin", folder_in, fileName, frame.imgIdx);
+        } else {
+            sprintf(path, "%s/compressed/%s%02zu_%04u_blocks.bin", folder_in, fileName, frame.imgIdx, nrOfBlocks);
+        }
+        STATUS_t status = DecoderBase::importBitstream(path, frame.pSource);
+        if(status) {
+            char msg[200];
+            sprintf(msg, "OMLS Error: %u:Error while importing bitstream: %s", status, path);
+            throw std::runtime_error(msg);
+        }
+    };
+
+    auto process = [&](TranscodeFrame_s& frame) {
+        thread_local Transcoder transcoder;   // YCCC buffer is reused by frames of the same worker
+        transcoder.transcodeToBuffer(
+           frame.pSource->getDataView(),
+           frame.bitstream,
+           targetBlocks,
+           checkpoints,
+           balanced);
+    };
+
+    auto store = [&](TranscodeFrame_s& frame) {
+        frame.pSource.reset();   // source may be overwritten, e.g. blocks to checkpoints of the same count
+        if(!frame.error.empty()) {
+            std::cout << "RUNTIME ERROR: \n";
+            std::cout << "Frame " << frame.imgIdx << ": " << frame.error << "\n";
+            return;
+        }
+
+        char path[200];
+        if(targetBlocks == 0) {
+            sprintf(path, "%s/compressed/%s%02zu.bin", folder_out, fileName, frame.imgIdx);
+        } else {
+            sprintf(path, "%s/compressed/%s%02zu_%04u_blocks.bin", folder_out, fileName, frame.imgIdx, targetBlocks);
+        }
+        std::span<std::uint8_t const> parts[] = {frame.bitstream};
+        if(!Helpers::writeFileGather(path, parts)) {
+            char msg[200];
+            std::sprintf(msg, "Cannot write specified file: %s", path);
+            throw std::runtime_error(msg);
+        }
+        std::cout << "Saved transcoded image: " << path << std::endl;
+    };
+
+#        ifdef TIMING_EN
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+#        endif
+    runFramePipeline<TranscodeFrame_s>(imgIdx_min, imgIdx_max, nrOfWorkers, queueDepth, load, process, store);
+#        ifdef TIMING_EN
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cout << "Transcoding time = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count()
+              << "[ms]" << std::endl;
+#        endif
+}
+
+struct StreamingGPUFrame_s {
+    std::size_t imgIdx = 0;
+    std::size_t slot   = 0;
+    std::unique_ptr<Decoder> pDec;
+};
+
+/**
+ * Same output as decompressImageRangeAGOR with GPU and blocks, but up to <nrOfSlots> frames are in flight on the
+ * device, each on its own OpenCL queue: upload of frame N+1 overlaps kernels of frame N and readback of frame N-1,
+ * while the host loads the next file and exports finished frames in order.
+*/
+void decompressImageRangeStreamingGPU(
+   const char* fileName,
+   const char* folder_in,
+   const char* folder_out,
+   std::size_t imgIdx_min,
+   std::size_t imgIdx_max,
+   std::vector<std::uint32_t>* N,
+   std::vector<std::uint32_t>* A_init,
+   std::size_t headerBytes,
+   std::uint16_t nrOfBlocks,
+   std::size_t nrOfSlots,
+   DecoderBase::blockKernels gpu_kernels)
+{
+#        ifndef INCLUDE_OPENCL
+    std::cout << "Streaming GPU decompression requires a build with INCLUDE_OPENCL." << std::endl;
+#        else
+    nrOfSlots = std::max<std::size_t>(nrOfSlots, 2);
+    std::cout << "\nAGOR streaming GPU decompression, " << nrOfSlots << " frames in flight" << std::endl;
+
+    // frames are finished and exported one at a time, so they share one workspace for the decoded image
+    DecodeWorkspace_s workspace;
+    std::deque<std::unique_ptr<StreamingGPUFrame_s>> inFlight;
+
+    auto finishOldest = [&]() {
+        std::unique_ptr<StreamingGPUFrame_s> frame = std::move(inFlight.front());
+        inFlight.pop_front();
+        try {
+            headerData_t headerData = frame->pDec->finishParallelGPU();
+
+            std::uint64_t header = 0;
+            if(headerBytes == 24) {
+                header |= (std::uint64_t)(headerData.reserved & ~C_HEADER_FLAGS_INDEX) << 56;
+                header |= (std::uint64_t)headerData.lossyBits << 48;
+                header |= (std::uint64_t)headerData.bpp << 40;
+                header |= (std::uint64_t)headerData.unaryMaxWidth << 32;
+                header |= (std::uint64_t)headerData.height << 16;
+                header |= (std::uint64_t)headerData.width << 0;
+            }
+
+            char path[200];
+            sprintf(path, "%s/decompressed/%s%02zu.bin", folder_out, fileName, frame->imgIdx);
+            frame->pDec->exportBayerImage(path, header, headerData.roi, headerData.timestamp);
+            std::cout << "Saved an image: " << path << std::endl;
+        } catch(std::runtime_error& e) {
+            std::cout << "RUNTIME ERROR: \n";
+            std::cout << "Frame " << frame->imgIdx << ": " << e.what() << "\n";
+        }
+    };
+
+#            ifdef TIMING_EN
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+#            endif
+    // advances only when a frame actually enters inFlight, so a failed frame does not skip a slot
+    std::size_t nextSlot = 0;
+    for(std::size_t imgIdx = imgIdx_min; imgIdx <= imgIdx_max; imgIdx++) {
+        if(inFlight.size() == nrOfSlots) {
+            finishOldest();
+        }
+        std::size_t slot = nextSlot % nrOfSlots;
+        // pinned buffers of the slot must not be reused while a frame in flight still owns them
+        auto holdsSlot = [slot](const std::unique_ptr<StreamingGPUFrame_s>& frame) { return frame->slot == slot; };
+        while(std::any_of(inFlight.begin(), inFlight.end(), holdsSlot)) {
+            finishOldest();
+        }
+
+        try {
+            auto frame    = std::make_unique<StreamingGPUFrame_s>();
+            frame->imgIdx = imgIdx;
+            frame->slot   = slot;
+
+            char path[200];
+            sprintf(path, "%s/compressed/%s%02zu_%04u_blocks.bin", folder_in, fileName, imgIdx, nrOfBlocks);
+
+            frame->pDec = std::make_unique<Decoder>(path, A_init->data()[0], N->data()[0]);
+            frame->pDec->setWorkspace(&workspace);
+            frame->pDec->enqueueParallelGPU(slot, gpu_kernels);
+            inFlight.push_back(std::move(frame));
+            nextSlot++;
+        } catch(std::runtime_error& e) {
+            std::cout << "RUNTIME ERROR: \n";
+            std::cout << "Frame " << imgIdx << ": " << e.what() << "\n";
+        }
+    }
+    while(!inFlight.empty()) {
+        finishOldest();
+    }
+#            ifdef TIMING_EN
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cout << "Streaming GPU decompression time = "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "[ms]" << std::endl;
+#            endif
+#        endif
+}
+
 std::uint64_t getCurrentTimeMicros()
 {
     auto now      = std::chrono::system_clock::now();
@@ -675,8 +1233,28 @@ void printHelp()
               << "[-x width -y height] (necesarry only if header == 0)\n"
               << "[-r bpp] (resolution in bits per pixel, default 8)\n"
               << "[-g (use GPU)]\n"
-              << "[-B nrOfBlocks] (number of blocks for GPU parallel processing. Omit or set to 0 for no separation to "
-                 "blocks.)\n"
+              << "[-F] (with -g and -B, decode each block with a single fused OpenCL kernel instead of four kernels)\n"
+              << "[-L] (with -g and -B, parse the bitstream of the blocks from OpenCL local memory)\n"
+              << "[-B nrOfBlocks] (number of blocks for parallel processing on GPU or CPU threads. Omit or set to 0 "
+                 "for no separation to blocks. Decompression reads the blocks from the block index of the file.)\n"
+              << "[-K] (with -c and -B, encode one continuous AGOR stream with nrOfBlocks checkpoints of the AGOR "
+                 "state instead of independent blocks: better compression, still decoded in parallel on CPU threads. "
+                 "Decompression recognizes it from the header.)\n"
+              << "[-E] (with -c and -B, or with -T, place block boundaries so that blocks have roughly equal "
+                 "compressed size instead of equal number of rows; first rows of the blocks are stored in the block "
+                 "index. Encoding takes two passes.)\n"
+              << "[-I rowsPerCheckpoint] (for files without blocks, parse each compressed file once and write sidecar "
+                 "checkpoint index *_checkpoints.bin with AGOR state every rowsPerCheckpoint rows (even). Later "
+                 "decompressions without -B use it to decode on multiple CPU threads. Runs after compression with "
+                 "-c, on input_location otherwise.)\n"
+              << "[-T targetBlocks] (transcode compressed files with nrOfBlocks blocks (-B, 0 or omitted: none) to "
+                 "targetBlocks blocks (0: none), or to targetBlocks checkpoints with -K, without decompressing to "
+                 "BayerCFA. Files are read from input_location and written to output_location, nrOfWorkers "
+                 "(-j, default one per core) at once. Runs before -c and -d.)\n"
+              << "[-j nrOfWorkers] (pipelined batch mode: frames are read, encoded/decoded on nrOfWorkers threads and "
+                 "written concurrently. Omit or set to 0 to process frames one after another. With -g and -B, "
+                 "decompression streams frames through the GPU with nrOfWorkers frames in flight.)\n"
+              << "[-q queueDepth] (max. number of frames in flight in pipelined batch mode, default 2 * nrOfWorkers)\n"
               << std::endl;
 }
 
@@ -699,7 +1277,15 @@ Params parseArguments(int argc, char* argv[])
     params.header_bytes   = 16;
     params.bpp            = 8;
     params.use_gpu        = false;
+    params.gpu_kernels    = DecoderBase::blockKernels::four;
     params.nrOfBlocks     = 0;
+    params.checkpoints    = false;
+    params.balanced       = false;
+    params.indexRows      = 0;
+    params.transcode      = false;
+    params.targetBlocks   = 0;
+    params.nrOfWorkers    = 0;
+    params.queueDepth     = 0;
 
     if(argc == 1) {
         std::cout << "No arguments supplied." << std::endl;
@@ -759,8 +1345,29 @@ Params parseArguments(int argc, char* argv[])
                 params.bpp = std::stoi(argv[i + 1]);
             } else if(std::strcmp(flag, "-g") == 0) {
                 params.use_gpu = true;
+            } else if(std::strcmp(flag, "-F") == 0) {
+                params.gpu_kernels = DecoderBase::blockKernels::fused;
+                i--;   // single parameter
+            } else if(std::strcmp(flag, "-L") == 0) {
+                params.gpu_kernels = DecoderBase::blockKernels::localParsing;
+                i--;   // single parameter
             } else if(std::strcmp(flag, "-B") == 0) {
                 params.nrOfBlocks = std::stoi(argv[i + 1]);
+            } else if(std::strcmp(flag, "-T") == 0) {
+                params.transcode    = true;
+                params.targetBlocks = std::stoi(argv[i + 1]);
+            } else if(std::strcmp(flag, "-I") == 0) {
+                params.indexRows = std::stoi(argv[i + 1]);
+            } else if(std::strcmp(flag, "-K") == 0) {
+                params.checkpoints = true;
+                i--;   // single parameter
+            } else if(std::strcmp(flag, "-E") == 0) {
+                params.balanced = true;
+                i--;   // single parameter
+            } else if(std::strcmp(flag, "-j") == 0) {
+                params.nrOfWorkers = std::stoi(argv[i + 1]);
+            } else if(std::strcmp(flag, "-q") == 0) {
+                params.queueDepth = std::stoi(argv[i + 1]);
             } else if(std::strcmp(flag, "-h") == 0) {
                 printHelp();
                 exit(EXIT_SUCCESS);
@@ -786,7 +1393,7 @@ Params parseArguments(int argc, char* argv[])
 
     // Check for missing required input arguments
     if(params.folder_in == nullptr || params.folder_out == nullptr ||
-       (params.compress == false && params.decompress == false)) {
+       (params.compress == false && params.decompress == false && params.indexRows == 0 && !params.transcode)) {
         std::cerr << "Missing required input arguments." << std::endl;
         printHelp();
         exit(EXIT_FAILURE);
@@ -849,6 +1456,30 @@ Params parseArguments(int argc, char* argv[])
     if(params.nrOfBlocks != 0) {
         std::cout << "          nrOfBlocks: " << params.nrOfBlocks << std::endl;
     }
+    if(params.checkpoints) {
+        std::cout << "         checkpoints: true" << std::endl;
+    }
+    if(params.balanced) {
+        std::cout << "            balanced: true" << std::endl;
+    }
+    if(params.indexRows != 0) {
+        std::cout << "           indexRows: " << params.indexRows << std::endl;
+    }
+    if(params.transcode) {
+        std::cout << "        targetBlocks: " << params.targetBlocks << std::endl;
+    }
+    if(params.gpu_kernels == DecoderBase::blockKernels::fused) {
+        std::cout << "         gpu_kernels: fused" << std::endl;
+    } else if(params.gpu_kernels == DecoderBase::blockKernels::localParsing) {
+        std::cout << "         gpu_kernels: local parsing" << std::endl;
+    }
+    if(params.nrOfWorkers != 0) {
+        if(params.queueDepth == 0) {
+            params.queueDepth = 2 * params.nrOfWorkers;
+        }
+        std::cout << "         nrOfWorkers: " << params.nrOfWorkers << std::endl;
+        std::cout << "          queueDepth: " << params.queueDepth << std::endl;
+    }
     if(params.header_bytes == 0) {
         std::cout << "               width: " << params.width << std::endl;
         std::cout << "              height: " << params.height << std::endl;
@@ -21,7 +21,15 @@ struct Params {
     bool decompress;
     bool ideal_compress;
     bool use_gpu;
+    DecoderBase::blockKernels gpu_kernels;   // OpenCL kernels for decoding in blocks
     std::uint16_t nrOfBlocks;
+    bool checkpoints;          // with nrOfBlocks: one AGOR stream with checkpoints instead of independent blocks
+    bool balanced;             // with nrOfBlocks: blocks of roughly equal compressed size instead of equal rows
+    std::size_t indexRows;     // rows per checkpoint of sidecar checkpoint index, 0: no index is built
+    bool transcode;            // change layout of compressed files to targetBlocks blocks (or checkpoints)
+    std::uint16_t targetBlocks;
+    std::size_t nrOfWorkers;   // 0: frames are processed one after another
+    std::size_t queueDepth;
 };
 
 void printHelp();
@@ -45,7 +53,29 @@ void compressImageRangeAGOR(
    std::size_t lossyBits,
    std::vector<std::size_t>* imageSizes,
    std::size_t headerBytes,
-   std::uint16_t nrOfBlocks);
+   std::uint16_t nrOfBlocks,
+   bool checkpoints = false,
+   bool balanced = false);
+void buildCheckpointIndexRange(
+   const char* fileName,
+   const char* folder,
+   std::size_t imgIdx_min,
+   std::size_t imgIdx_max,
+   std::vector<std::uint32_t>* N,
+   std::vector<std::uint32_t>* A_init,
+   std::size_t rowsPerCheckpoint);
+void transcodeImageRange(
+   const char* fileName,
+   const char* folder_in,
+   const char* folder_out,
+   std::size_t imgIdx_min,
+   std::size_t imgIdx_max,
+   std::uint16_t nrOfBlocks,
+   std::uint16_t targetBlocks,
+   bool checkpoints,
+   bool balanced,
+   std::size_t nrOfWorkers,
+   std::size_t queueDepth);
 void compressImageRangeIdeal(
    const char* fileName,
    const char* folder_in,
@@ -71,7 +101,51 @@ void decompressImageRangeAGOR(
    std::vector<std::size_t>* imageSizes,
    std::size_t headerBytes,
    bool use_gpu,
-   std::uint16_t nrOfBlocks);
+   std::uint16_t nrOfBlocks,
+   DecoderBase::blockKernels gpu_kernels = DecoderBase::blockKernels::four);
+
+void compressImageRangePipelined(
+   const char* fileName,
+   const char* folder_in,
+   const char* folder_out,
+   std::size_t imgIdx_min,
+   std::size_t imgIdx_max,
+   std::size_t unaryMaxWidth,
+   std::uint8_t bpp,
+   std::vector<std::uint32_t>* N,
+   std::vector<std::uint32_t>* A_init,
+   std::size_t lossyBits,
+   std::vector<std::size_t>* imageSizes,
+   std::size_t headerBytes,
+   std::uint16_t nrOfBlocks,
+   std::size_t nrOfWorkers,
+   std::size_t queueDepth,
+   bool checkpoints = false,
+   bool balanced = false);
+void decompressImageRangePipelined(
+   const char* fileName,
+   const char* folder_in,
+   const char* folder_out,
+   std::size_t imgIdx_min,
+   std::size_t imgIdx_max,
+   std::vector<std::uint32_t>* N,
+   std::vector<std::uint32_t>* A_init,
+   std::size_t headerBytes,
+   std::uint16_t nrOfBlocks,
+   std::size_t nrOfWorkers,
+   std::size_t queueDepth);
+void decompressImageRangeStreamingGPU(
+   const char* fileName,
+   const char* folder_in,
+   const char* folder_out,
+   std::size_t imgIdx_min,
+   std::size_t imgIdx_max,
+   std::vector<std::uint32_t>* N,
+   std::vector<std::uint32_t>* A_init,
+   std::size_t headerBytes,
+   std::uint16_t nrOfBlocks,
+   std::size_t nrOfSlots,
+   DecoderBase::blockKernels gpu_kernels = DecoderBase::blockKernels::four);
 
 void runTests();
 void createMissingDirectories(const char* folder_out);